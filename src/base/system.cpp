@@ -5,6 +5,7 @@
 #include <charconv>
 #include <chrono>
 #include <cinttypes>
+#include <climits>
 #include <cmath>
 #include <cstdarg>
 #include <cstdio>
@@ -27,6 +28,7 @@
 #if defined(CONF_FAMILY_UNIX)
 #include <csignal>
 #include <locale>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/utsname.h>
@@ -408,6 +410,45 @@ int io_error(IOHANDLE io)
 	return ferror((FILE *)io);
 }
 
+const void *io_map(IOHANDLE io, unsigned *size)
+{
+#if defined(CONF_FAMILY_WINDOWS)
+	HANDLE file = (HANDLE)_get_osfhandle(_fileno((FILE *)io));
+	LARGE_INTEGER length;
+	if(!GetFileSizeEx(file, &length) || length.QuadPart <= 0 || length.QuadPart > UINT_MAX)
+		return nullptr;
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if(!mapping)
+		return nullptr;
+	// the view keeps the mapping object alive
+	void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if(!data)
+		return nullptr;
+	*size = (unsigned)length.QuadPart;
+	return data;
+#else
+	int fd = fileno((FILE *)io);
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size <= 0 || (uint64_t)st.st_size > UINT_MAX)
+		return nullptr;
+	void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if(data == MAP_FAILED)
+		return nullptr;
+	*size = (unsigned)st.st_size;
+	return data;
+#endif
+}
+
+void io_unmap(const void *data, unsigned size)
+{
+#if defined(CONF_FAMILY_WINDOWS)
+	UnmapViewOfFile(data);
+#else
+	munmap(const_cast<void *>(data), size);
+#endif
+}
+
 unsigned io_write(IOHANDLE io, const void *buffer, unsigned size)
 {
 	return fwrite(buffer, 1, size, (FILE *)io);
@@ -402,6 +402,31 @@ int io_sync(IOHANDLE io);
  */
 int io_error(IOHANDLE io);
 
+/**
+ * Maps the whole file into memory for reading.
+ *
+ * @ingroup File-IO
+ *
+ * @param io Handle to the file.
+ * @param size Receives the length of the file.
+ *
+ * @return Pointer to the read-only contents or nullptr on failure, e.g. for empty files.
+ *
+ * @remark The mapping stays valid after the file is closed.
+ * @remark The result must be released with <io_unmap>.
+ */
+const void *io_map(IOHANDLE io, unsigned *size);
+
+/**
+ * Releases a mapping created by <io_map>.
+ *
+ * @ingroup File-IO
+ *
+ * @param data The mapped contents.
+ * @param size Length of the mapping as returned by <io_map>.
+ */
+void io_unmap(const void *data, unsigned size);
+
 /**
  * @ingroup File-IO
  * @return An <IOHANDLE> to the standard input.
@@ -0,0 +1,127 @@
+#ifndef BASE_TL_MPSC_QUEUE_H
+#define BASE_TL_MPSC_QUEUE_H
+
+#include "../system.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// small number identifying the calling thread, assigned on first use
+inline int mpsc_producer_index()
+{
+	static std::atomic_int s_NextIndex{0};
+	thread_local int s_Index = s_NextIndex.fetch_add(1);
+	return s_Index;
+}
+
+/*
+	Bounded queue with many producer threads and one consumer thread.
+	Producers reserve a slot with a compare and swap on the tail and publish
+	it through the slot's sequence number, the consumer never waits: TryPop
+	returns false if the next slot isn't published yet.
+
+	Push records how long every producer waited in a histogram of power of
+	two microseconds. Producers are told apart by mpsc_producer_index(),
+	threads beyond MAX_PRODUCERS share rows.
+*/
+template<class T, int Capacity>
+class CMpscQueue
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+	enum
+	{
+		MAX_PRODUCERS = 16,
+		// bucket i counts latencies below 2^i microseconds, the last one the rest
+		NUM_LATENCY_BUCKETS = 16,
+	};
+
+	CMpscQueue()
+	{
+		for(int i = 0; i < Capacity; i++)
+			m_aSlots[i].m_Sequence.store(i, std::memory_order_relaxed);
+	}
+	CMpscQueue(const CMpscQueue &) = delete;
+	CMpscQueue &operator=(const CMpscQueue &) = delete;
+
+	// returns false if the queue is full, safe from any thread
+	bool TryPush(const T &Value)
+	{
+		uint32_t Pos = m_Tail.load(std::memory_order_relaxed);
+		while(true)
+		{
+			CSlot &Slot = m_aSlots[Pos & (Capacity - 1)];
+			int32_t Diff = (int32_t)(Slot.m_Sequence.load(std::memory_order_acquire) - Pos);
+			if(Diff == 0)
+			{
+				if(m_Tail.compare_exchange_weak(Pos, Pos + 1, std::memory_order_relaxed))
+				{
+					Slot.m_Value = Value;
+					Slot.m_Sequence.store(Pos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if(Diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				Pos = m_Tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// yields until there is space, safe from any thread
+	void Push(const T &Value)
+	{
+		// time_get() isn't thread safe
+		std::chrono::nanoseconds Start = time_get_nanoseconds();
+		if(!TryPush(Value))
+		{
+			m_NumFull.fetch_add(1, std::memory_order_relaxed);
+			do
+			{
+				thread_yield();
+			} while(!TryPush(Value));
+		}
+		int64_t Micros = std::chrono::duration_cast<std::chrono::microseconds>(time_get_nanoseconds() - Start).count();
+		int Bucket = 0;
+		while(Bucket < NUM_LATENCY_BUCKETS - 1 && Micros >= ((int64_t)1 << Bucket))
+			Bucket++;
+		m_aaLatencies[mpsc_producer_index() % MAX_PRODUCERS][Bucket].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// consumer thread only, returns false if nothing is published
+	bool TryPop(T *pValue)
+	{
+		CSlot &Slot = m_aSlots[m_Head & (Capacity - 1)];
+		if((int32_t)(Slot.m_Sequence.load(std::memory_order_acquire) - (m_Head + 1)) < 0)
+			return false;
+		*pValue = Slot.m_Value;
+		Slot.m_Sequence.store(m_Head + Capacity, std::memory_order_release);
+		m_Head++;
+		return true;
+	}
+
+	int64_t NumLatencies(int Producer, int Bucket) const { return m_aaLatencies[Producer][Bucket].load(std::memory_order_relaxed); }
+	// number of Push calls that found the queue full
+	int64_t NumFull() const { return m_NumFull.load(std::memory_order_relaxed); }
+
+private:
+	struct CSlot
+	{
+		std::atomic<uint32_t> m_Sequence;
+		T m_Value;
+	};
+
+	CSlot m_aSlots[Capacity];
+	alignas(64) std::atomic<uint32_t> m_Tail{0};
+	alignas(64) uint32_t m_Head = 0;
+	std::atomic<int64_t> m_aaLatencies[MAX_PRODUCERS][NUM_LATENCY_BUCKETS] = {};
+	std::atomic<int64_t> m_NumFull{0};
+};
+
+#endif // BASE_TL_MPSC_QUEUE_H
@@ -36,6 +36,9 @@ public:
 	virtual void Unload() = 0;
 	virtual bool IsLoaded() const = 0;
 	virtual IOHANDLE File() const = 0;
+	virtual void LoadAllData(class IEngine *pEngine) = 0;
+	// exchanges the loaded files of two maps
+	virtual void Swap(IEngineMap *pOther) = 0;
 
 	virtual SHA256_DIGEST Sha256() const = 0;
 	virtual unsigned Crc() const = 0;
@@ -353,6 +353,8 @@ public:
 	virtual void RedirectClient(int ClientId, int Port, bool Verbose = false) = 0;
 	virtual bool GetMapReload() const = 0;
 	virtual void ChangeMap(const char *pMap) = 0;
+	// hint that pMapName is likely loaded next, so its client map can be converted in the background
+	virtual void PrepareMap(const char *pMapName) = 0;
 
 	virtual void DemoRecorder_HandleAutoStart() = 0;
 
@@ -418,6 +420,8 @@ public:
 	virtual void Register(int ClientId, const char* pUsername, const char* pPassword, const char* pEmail) = 0;
 	virtual void Login(int ClientId, const char* pUsername, const char* pPassword) = 0;
 	virtual void Logout(int ClientId) = 0;
+	virtual void ShowTop10(int ClientId, int ScoreType) = 0;
+	virtual void ShowRank(int ClientId, int ScoreType) = 0;
 #endif
 
 public:
@@ -87,3 +87,35 @@ void IDbConnection::FormatCreatePoints(char *aBuf, unsigned int BufferSize)
 		")",
 		GetPrefix(), MAX_NAME_LENGTH, BinaryCollate());
 }
+
+void IDbConnection::FormatCreateInfcRounds(char *aBuf, unsigned int BufferSize, bool Backup)
+{
+	str_format(aBuf, BufferSize,
+		"CREATE TABLE IF NOT EXISTS %s_infc_rounds%s ("
+		"  RoundId VARCHAR(64) COLLATE %s NOT NULL, "
+		"  Map VARCHAR(128) COLLATE %s NOT NULL, "
+		"  Timestamp TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP, "
+		"  Duration INT DEFAULT 0, "
+		"  NumPlayersMin INT DEFAULT 0, "
+		"  NumPlayersMax INT DEFAULT 0, "
+		"  NumWinners INT DEFAULT 0, "
+		"  PRIMARY KEY (RoundId)"
+		")",
+		GetPrefix(), Backup ? "_backup" : "",
+		BinaryCollate(), BinaryCollate());
+}
+
+void IDbConnection::FormatCreateInfcRoundScores(char *aBuf, unsigned int BufferSize, bool Backup)
+{
+	str_format(aBuf, BufferSize,
+		"CREATE TABLE IF NOT EXISTS %s_infc_round_scores%s ("
+		"  RoundId VARCHAR(64) COLLATE %s NOT NULL, "
+		"  Name VARCHAR(%d) COLLATE %s NOT NULL, "
+		"  ScoreType INT NOT NULL, "
+		"  Score INT DEFAULT 0, "
+		"  Won BOOL DEFAULT FALSE, "
+		"  PRIMARY KEY (RoundId, Name, ScoreType)"
+		")",
+		GetPrefix(), Backup ? "_backup" : "",
+		BinaryCollate(), MAX_NAME_LENGTH, BinaryCollate());
+}
@@ -4,10 +4,71 @@
 #include "connection_pool.h"
 #include <base/system.h>
 
+#include <list>
 #include <memory>
+#include <string>
+#include <unordered_map>
 
 class IConsole;
 
+// least recently used prepared statements of one connection, keyed by their
+// sql text
+template<typename TStmt, typename TDeleter>
+class CStatementCache
+{
+public:
+	typedef std::unique_ptr<TStmt, TDeleter> CStmtPtr;
+
+	explicit CStatementCache(int Capacity) :
+		m_Capacity(Capacity)
+	{
+	}
+
+	// returns nullptr if the statement has to be prepared
+	TStmt *Find(const char *pQuery, CDbStatementCacheStats *pStats)
+	{
+		auto It = m_Lookup.find(pQuery);
+		if(It == m_Lookup.end())
+		{
+			pStats->m_Misses.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+		pStats->m_Hits.fetch_add(1, std::memory_order_relaxed);
+		m_Entries.splice(m_Entries.begin(), m_Entries, It->second);
+		return It->second->second.get();
+	}
+
+	// takes ownership, evicts the least recently used statement if full
+	TStmt *Add(const char *pQuery, CStmtPtr pStmt, CDbStatementCacheStats *pStats)
+	{
+		if((int)m_Entries.size() >= m_Capacity)
+		{
+			m_Lookup.erase(m_Entries.back().first);
+			m_Entries.pop_back();
+			pStats->m_Evictions.fetch_add(1, std::memory_order_relaxed);
+		}
+		m_Entries.emplace_front(pQuery, std::move(pStmt));
+		m_Lookup[m_Entries.front().first] = m_Entries.begin();
+		return m_Entries.front().second.get();
+	}
+
+	void Clear()
+	{
+		m_Lookup.clear();
+		m_Entries.clear();
+	}
+
+	int Size() const { return m_Entries.size(); }
+
+private:
+	typedef std::list<std::pair<std::string, CStmtPtr>> CEntries;
+
+	int m_Capacity;
+	// most recently used first
+	CEntries m_Entries;
+	std::unordered_map<std::string, typename CEntries::iterator> m_Lookup;
+};
+
 // can hold one PreparedStatement with Results
 class IDbConnection
 {
@@ -20,9 +81,19 @@ public:
 	IDbConnection &operator=(const IDbConnection &) = delete;
 	virtual void Print(IConsole *pConsole, const char *pMode) = 0;
 
+	enum
+	{
+		// prepared statements kept per connection
+		STATEMENT_CACHE_SIZE = 32,
+	};
+
 	// copies the credentials, not the active connection
 	virtual IDbConnection *Copy() = 0;
 
+	const CDbStatementCacheStats &StatementCacheStats() const { return *m_pStatementCacheStats; }
+	// copies of this connection count into the same statistics
+	void SetStatementCacheStats(std::shared_ptr<CDbStatementCacheStats> pStats) { m_pStatementCacheStats = std::move(pStats); }
+
 	// returns the database prefix
 	const char *GetPrefix() const { return m_aPrefix; }
 	virtual const char *BinaryCollate() const = 0;
@@ -50,7 +121,8 @@ public:
 	// has to be called to return the connection back to the pool
 	virtual void Disconnect() = 0;
 
-	// ? for Placeholders, connection has to be established, can overwrite previous prepared statements
+	// ? for Placeholders, connection has to be established, can overwrite previous prepared statements.
+	// Statements are cached per connection, preparing the same sql text again only resets its bindings.
 	//
 	// returns true on failure
 	virtual bool PrepareStatement(const char *pStmt, char *pError, int ErrorSize) = 0;
@@ -87,15 +159,26 @@ public:
 	// SQL statements, that can't be abstracted, has side effects to the result
 	virtual bool AddPoints(const char *pPlayer, int Points, char *pError, int ErrorSize) = 0;
 
+	// transactions, can overwrite previous prepared statements
+	//
+	// returns true on failure
+	virtual bool BeginTransaction(char *pError, int ErrorSize) = 0;
+	virtual bool CommitTransaction(char *pError, int ErrorSize) = 0;
+	virtual bool RollbackTransaction(char *pError, int ErrorSize) = 0;
+
 private:
 	char m_aPrefix[64];
 
 protected:
+	std::shared_ptr<CDbStatementCacheStats> m_pStatementCacheStats = std::make_shared<CDbStatementCacheStats>();
+
 	void FormatCreateRace(char *aBuf, unsigned int BufferSize, bool Backup);
 	void FormatCreateTeamrace(char *aBuf, unsigned int BufferSize, const char *pIdType, bool Backup);
 	void FormatCreateMaps(char *aBuf, unsigned int BufferSize);
 	void FormatCreateSaves(char *aBuf, unsigned int BufferSize, bool Backup);
 	void FormatCreatePoints(char *aBuf, unsigned int BufferSize);
+	void FormatCreateInfcRounds(char *aBuf, unsigned int BufferSize, bool Backup);
+	void FormatCreateInfcRoundScores(char *aBuf, unsigned int BufferSize, bool Backup);
 };
 
 bool MysqlAvailable();
@@ -1,10 +1,13 @@
 #include "connection_pool.h"
 #include "connection.h"
 
+#include <base/math.h>
 #include <base/system.h>
 #include <cstring>
 #include <engine/console.h>
 
+#include <cinttypes>
+
 #include <chrono>
 #include <iterator>
 #include <memory>
@@ -64,6 +67,7 @@ struct CSqlExecData
 
 	std::unique_ptr<const ISqlData> m_pThreadData;
 	const char *m_pName;
+	int64_t m_QueuedTime;
 };
 
 CSqlExecData::CSqlExecData(
@@ -72,7 +76,8 @@ CSqlExecData::CSqlExecData(
 	const char *pName) :
 	m_Mode(READ_ACCESS),
 	m_pThreadData(std::move(pThreadData)),
-	m_pName(pName)
+	m_pName(pName),
+	m_QueuedTime(time_get())
 {
 	m_Ptr.m_pReadFunc = pFunc;
 }
@@ -83,7 +88,8 @@ CSqlExecData::CSqlExecData(
 	const char *pName) :
 	m_Mode(WRITE_ACCESS),
 	m_pThreadData(std::move(pThreadData)),
-	m_pName(pName)
+	m_pName(pName),
+	m_QueuedTime(time_get())
 {
 	m_Ptr.m_pWriteFunc = pFunc;
 }
@@ -93,7 +99,8 @@ CSqlExecData::CSqlExecData(
 	const char aFileName[64]) :
 	m_Mode(ADD_SQLITE),
 	m_pThreadData(nullptr),
-	m_pName("add sqlite server")
+	m_pName("add sqlite server"),
+	m_QueuedTime(time_get())
 {
 	m_Ptr.m_Sqlite.m_Mode = m;
 	mem_copy(m_Ptr.m_Sqlite.m_FileName, aFileName, sizeof(m_Ptr.m_Sqlite.m_FileName));
@@ -102,7 +109,8 @@ CSqlExecData::CSqlExecData(CDbConnectionPool::Mode m,
 	const CMysqlConfig *pMysqlConfig) :
 	m_Mode(ADD_MYSQL),
 	m_pThreadData(nullptr),
-	m_pName("add mysql server")
+	m_pName("add mysql server"),
+	m_QueuedTime(time_get())
 {
 	m_Ptr.m_Mysql.m_Mode = m;
 	mem_copy(&m_Ptr.m_Mysql.m_Config, pMysqlConfig, sizeof(m_Ptr.m_Mysql.m_Config));
@@ -111,7 +119,8 @@ CSqlExecData::CSqlExecData(CDbConnectionPool::Mode m,
 CSqlExecData::CSqlExecData(IConsole *pConsole, CDbConnectionPool::Mode m) :
 	m_Mode(PRINT),
 	m_pThreadData(nullptr),
-	m_pName("print database server")
+	m_pName("print database server"),
+	m_QueuedTime(time_get())
 {
 	m_Ptr.m_Print.m_pConsole = pConsole;
 	m_Ptr.m_Print.m_Mode = m;
@@ -119,25 +128,143 @@ CSqlExecData::CSqlExecData(IConsole *pConsole, CDbConnectionPool::Mode m) :
 
 CDbConnectionPool::~CDbConnectionPool() = default;
 
+void CDbConnectionPool::CQueueStats::OnQueued()
+{
+	int Depth = ++m_Depth;
+	int MaxDepth = m_MaxDepth.load();
+	while(Depth > MaxDepth && !m_MaxDepth.compare_exchange_weak(MaxDepth, Depth))
+		;
+}
+
+void CDbConnectionPool::CQueueStats::OnDequeued()
+{
+	m_Depth--;
+}
+
+void CDbConnectionPool::CQueueStats::OnDone(int64_t QueuedTime, bool Success)
+{
+	int64_t Latency = time_get() - QueuedTime;
+	m_Processed++;
+	if(!Success)
+		m_Failed++;
+	m_TotalLatency += Latency;
+	int64_t MaxLatency = m_MaxLatency.load();
+	while(Latency > MaxLatency && !m_MaxLatency.compare_exchange_weak(MaxLatency, Latency))
+		;
+}
+
+void CDbConnectionPool::QueueWrite(std::unique_ptr<CSqlExecData> pData)
+{
+	// writes behind overflowed ones wait with them to keep the order
+	m_vpWriteOverflow.push_back(std::move(pData));
+	FlushWriteOverflow();
+	if(!m_vpWriteOverflow.empty())
+	{
+		m_pShared->m_WriteStats.m_Overflows++;
+		if(m_vpWriteOverflow.size() == 1)
+			dbg_msg("sql", "write queue is full, keeping writes until the write worker catches up");
+	}
+}
+
+void CDbConnectionPool::FlushWriteOverflow()
+{
+	// the slot is only free again once the write worker took the query out
+	while(!m_vpWriteOverflow.empty() && m_pShared->m_WriteStats.m_Depth.load() < (int)std::size(m_pShared->m_aQueries))
+	{
+		m_pShared->m_WriteStats.OnQueued();
+		m_pShared->m_aQueries[m_InsertIdx++] = std::move(m_vpWriteOverflow.front());
+		m_vpWriteOverflow.pop_front();
+		m_InsertIdx %= std::size(m_pShared->m_aQueries);
+		m_pShared->m_NumBackup.Signal();
+	}
+}
+
+void CDbConnectionPool::Update()
+{
+	FlushWriteOverflow();
+}
+
 void CDbConnectionPool::Print(IConsole *pConsole, Mode DatabaseMode)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(pConsole, DatabaseMode);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	if(DatabaseMode == Mode::READ)
+	{
+		std::unique_lock<std::mutex> Lock(m_pShared->m_ReadMutex);
+		for(auto &pReadConnection : m_pShared->m_vpReadConnections)
+			pReadConnection->Print(pConsole, "Read");
+		if(m_pShared->m_vpReadConnections.empty())
+			pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "There are no read databases");
+		return;
+	}
+	QueueWrite(std::make_unique<CSqlExecData>(pConsole, DatabaseMode));
+}
+
+void CDbConnectionPool::PrintStats(IConsole *pConsole)
+{
+	const struct
+	{
+		const char *m_pName;
+		const CQueueStats *m_pStats;
+	} aQueues[] = {
+		{"read", &m_pShared->m_ReadStats},
+		{"write", &m_pShared->m_WriteStats},
+	};
+	for(const auto &Queue : aQueues)
+	{
+		const CQueueStats *pStats = Queue.m_pStats;
+		int64_t Processed = pStats->m_Processed.load();
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf),
+			"%s queue: depth=%d max_depth=%d processed=%" PRId64 " failed=%" PRId64 " overflows=%" PRId64 " avg_latency=%.2fms max_latency=%.2fms",
+			Queue.m_pName, pStats->m_Depth.load(), pStats->m_MaxDepth.load(), Processed, pStats->m_Failed.load(), pStats->m_Overflows.load(),
+			Processed ? pStats->m_TotalLatency.load() * 1000.0 / Processed / time_freq() : 0.0,
+			pStats->m_MaxLatency.load() * 1000.0 / time_freq());
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+	}
+	const CDbStatementCacheStats &Statements = m_pShared->m_StatementCacheStats;
+	int64_t Hits = Statements.m_Hits.load();
+	int64_t Lookups = Hits + Statements.m_Misses.load();
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf),
+		"statement cache: hits=%" PRId64 " misses=%" PRId64 " hit_rate=%.1f%% evictions=%" PRId64 " invalidations=%" PRId64,
+		Hits, Lookups - Hits, Lookups ? Hits * 100.0 / Lookups : 0.0, Statements.m_Evictions.load(), Statements.m_Invalidations.load());
+	pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+	str_format(aBuf, sizeof(aBuf), "read workers: %d", m_pShared->m_NumReadWorkersRunning.load());
+	pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+}
+
+void CDbConnectionPool::ShareStatementCacheStats(IDbConnection *pConnection, const std::shared_ptr<CSharedData> &pShared)
+{
+	if(pConnection)
+		pConnection->SetStatementCacheStats(std::shared_ptr<CDbStatementCacheStats>(pShared, &pShared->m_StatementCacheStats));
+}
+
+void CDbConnectionPool::SetNumReadWorkers(int NumReadWorkers)
+{
+	m_NumReadWorkers = maximum(NumReadWorkers, 1);
 }
 
 void CDbConnectionPool::RegisterSqliteDatabase(Mode DatabaseMode, const char aFileName[64])
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(DatabaseMode, aFileName);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	if(DatabaseMode == Mode::READ)
+	{
+		std::unique_lock<std::mutex> Lock(m_pShared->m_ReadMutex);
+		m_pShared->m_vpReadConnections.push_back(CreateSqliteConnection(aFileName, true));
+		ShareStatementCacheStats(m_pShared->m_vpReadConnections.back().get(), m_pShared);
+		return;
+	}
+	QueueWrite(std::make_unique<CSqlExecData>(DatabaseMode, aFileName));
 }
 
 void CDbConnectionPool::RegisterMysqlDatabase(Mode DatabaseMode, const CMysqlConfig *pMysqlConfig)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(DatabaseMode, pMysqlConfig);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	if(DatabaseMode == Mode::READ)
+	{
+		std::unique_lock<std::mutex> Lock(m_pShared->m_ReadMutex);
+		m_pShared->m_vpReadConnections.push_back(CreateMysqlConnection(*pMysqlConfig));
+		ShareStatementCacheStats(m_pShared->m_vpReadConnections.back().get(), m_pShared);
+		return;
+	}
+	QueueWrite(std::make_unique<CSqlExecData>(DatabaseMode, pMysqlConfig));
 }
 
 void CDbConnectionPool::Execute(
@@ -145,9 +272,39 @@ void CDbConnectionPool::Execute(
 	std::unique_ptr<const ISqlData> pSqlRequestData,
 	const char *pName)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	if(!m_ReadWorkersStarted)
+		StartReadWorkers();
+
+	auto pData = std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName);
+	{
+		std::unique_lock<std::mutex> Lock(m_pShared->m_ReadMutex);
+		if(!m_pShared->m_ReadShutdown && m_pShared->m_vpReadQueries.size() < MAX_READ_QUERIES)
+		{
+			m_pShared->m_ReadStats.OnQueued();
+			m_pShared->m_vpReadQueries.push_back(std::move(pData));
+		}
+	}
+	if(pData == nullptr)
+	{
+		m_pShared->m_ReadCv.notify_one();
+		return;
+	}
+
+	// drop the newest query, the player can simply ask again
+	if(m_pShared->m_ReadShutdown)
+	{
+		dbg_msg("sql", "%s dismissed read request after shutdown", pName);
+	}
+	else
+	{
+		m_pShared->m_ReadStats.m_Overflows++;
+		dbg_msg("sql", "read queue is full, dropped %s", pName);
+	}
+	if(pData->m_pThreadData != nullptr && pData->m_pThreadData->m_pResult != nullptr)
+	{
+		pData->m_pThreadData->m_pResult->m_Success = false;
+		pData->m_pThreadData->m_pResult->m_Completed.store(true);
+	}
 }
 
 void CDbConnectionPool::ExecuteWrite(
@@ -155,17 +312,27 @@ void CDbConnectionPool::ExecuteWrite(
 	std::unique_ptr<const ISqlData> pSqlRequestData,
 	const char *pName)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	QueueWrite(std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName));
 }
 
 void CDbConnectionPool::OnShutdown()
 {
+	// the overflowed writes and a free slot for the end of the queue, waiting
+	// is fine now
+	while(!m_vpWriteOverflow.empty() || m_pShared->m_WriteStats.m_Depth.load() >= (int)std::size(m_pShared->m_aQueries))
+	{
+		FlushWriteOverflow();
+		std::this_thread::sleep_for(1ms);
+	}
 	m_pShared->m_Shutdown.store(true);
 	m_pShared->m_NumBackup.Signal();
+	{
+		m_pShared->m_ReadShutdown.store(true);
+		std::unique_lock<std::mutex> Lock(m_pShared->m_ReadMutex);
+		m_pShared->m_ReadCv.notify_all();
+	}
 	int i = 0;
-	while(m_pShared->m_Shutdown.load())
+	while(m_pShared->m_Shutdown.load() || m_pShared->m_NumReadWorkersRunning.load() > 0)
 	{
 		// print a log about every two seconds
 		if(i % 20 == 0 && i > 0)
@@ -223,6 +390,7 @@ void CBackup::ProcessQueries()
 			pThreadData->m_Ptr.m_Sqlite.m_Mode == CDbConnectionPool::Mode::WRITE_BACKUP)
 		{
 			m_pWriteBackup = CreateSqliteConnection(pThreadData->m_Ptr.m_Sqlite.m_FileName, true);
+			CDbConnectionPool::ShareStatementCacheStats(m_pWriteBackup.get(), m_pShared);
 		}
 		else if(pThreadData->m_Mode == CSqlExecData::WRITE_ACCESS && m_pWriteBackup.get())
 		{
@@ -233,14 +401,14 @@ void CBackup::ProcessQueries()
 	}
 }
 
-// the worker threads executes queries on mysql or sqlite. If we write on
-// a mysql server and have a backup server configured, we'll remove the
-// entry from the backup server after completing it on the write server.
-// static void Worker(void *pUser);
-class CWorker
+// the write worker executes write queries in order on mysql or sqlite. If
+// we write on a mysql server and have a backup server configured, we'll
+// remove the entry from the backup server after completing it on the write
+// server.
+class CWriteWorker
 {
 public:
-	CWorker(std::shared_ptr<CDbConnectionPool::CSharedData> pShared) :
+	CWriteWorker(std::shared_ptr<CDbConnectionPool::CSharedData> pShared) :
 		m_pShared(std::move(pShared)) {}
 	static void Start(void *pUser);
 	void ProcessQueries();
@@ -255,8 +423,7 @@ private:
 	//                most one WRITE server. The WRITE server for all DDNet
 	//                Servers must be the same (to counteract double loads).
 	//                There may be one WRITE_BACKUP sqlite server.
-	// This variable should only change, before the worker threads
-	std::vector<std::unique_ptr<IDbConnection>> m_vpReadConnections;
+	// The READ servers are owned by the read workers.
 	std::unique_ptr<IDbConnection> m_pWriteConnection;
 	std::unique_ptr<IDbConnection> m_pWriteBackup;
 
@@ -264,19 +431,17 @@ private:
 };
 
 /* static */
-void CWorker::Start(void *pUser)
+void CWriteWorker::Start(void *pUser)
 {
-	CWorker *pThis = (CWorker *)pUser;
+	CWriteWorker *pThis = (CWriteWorker *)pUser;
 	pThis->ProcessQueries();
 	delete pThis;
 }
 
-void CWorker::ProcessQueries()
+void CWriteWorker::ProcessQueries()
 {
-	// remember last working server and try to connect to it first
-	int ReadServer = 0;
-	// enter fail mode when a sql request fails, skip read request during it and
-	// write to the backup database until all requests are handled
+	// enter fail mode when a sql request fails, write to the backup database
+	// until all requests are handled
 	bool FailMode = false;
 	for(int JobNum = 0;; JobNum++)
 	{
@@ -292,38 +457,13 @@ void CWorker::ProcessQueries()
 			m_pShared->m_Shutdown.store(false);
 			return;
 		}
+		m_pShared->m_WriteStats.OnDequeued();
 		bool Success = false;
 		switch(pThreadData->m_Mode)
 		{
 		case CSqlExecData::READ_ACCESS:
-		{
-			for(size_t i = 0; i < m_vpReadConnections.size(); i++)
-			{
-				if(m_pShared->m_Shutdown)
-				{
-					dbg_msg("sql", "[%i] %s dismissed read request during shutdown", JobNum, pThreadData->m_pName);
-					break;
-				}
-				if(FailMode)
-				{
-					dbg_msg("sql", "[%i] %s dismissed read request during FailMode", JobNum, pThreadData->m_pName);
-					break;
-				}
-				int CurServer = (ReadServer + i) % (int)m_vpReadConnections.size();
-				if(CDbConnectionPool::ExecSqlFunc(m_vpReadConnections[CurServer].get(), pThreadData.get(), Write::NORMAL))
-				{
-					ReadServer = CurServer;
-					dbg_msg("sql", "[%i] %s done on read database %d", JobNum, pThreadData->m_pName, CurServer);
-					Success = true;
-					break;
-				}
-			}
-			if(!Success)
-			{
-				FailMode = true;
-			}
-		}
-		break;
+			dbg_assert(false, "read query in the write queue");
+			break;
 		case CSqlExecData::WRITE_ACCESS:
 		{
 			if(m_pShared->m_Shutdown && m_pWriteBackup != nullptr)
@@ -347,22 +487,22 @@ void CWorker::ProcessQueries()
 				dbg_msg("sql", "[%i] %s done move write on backup database to non-backup table", JobNum, pThreadData->m_pName);
 				Success = true;
 			}
+			m_pShared->m_WriteStats.OnDone(pThreadData->m_QueuedTime, Success);
 		}
 		break;
 		case CSqlExecData::ADD_MYSQL:
 		{
 			auto pMysql = CreateMysqlConnection(pThreadData->m_Ptr.m_Mysql.m_Config);
+			CDbConnectionPool::ShareStatementCacheStats(pMysql.get(), m_pShared);
 			switch(pThreadData->m_Ptr.m_Mysql.m_Mode)
 			{
-			case CDbConnectionPool::Mode::READ:
-				m_vpReadConnections.push_back(std::move(pMysql));
-				break;
 			case CDbConnectionPool::Mode::WRITE:
 				m_pWriteConnection = std::move(pMysql);
 				break;
 			case CDbConnectionPool::Mode::WRITE_BACKUP:
 				m_pWriteBackup = std::move(pMysql);
 				break;
+			case CDbConnectionPool::Mode::READ:
 			case CDbConnectionPool::Mode::NUM_MODES:
 				break;
 			}
@@ -372,17 +512,16 @@ void CWorker::ProcessQueries()
 		case CSqlExecData::ADD_SQLITE:
 		{
 			auto pSqlite = CreateSqliteConnection(pThreadData->m_Ptr.m_Sqlite.m_FileName, true);
+			CDbConnectionPool::ShareStatementCacheStats(pSqlite.get(), m_pShared);
 			switch(pThreadData->m_Ptr.m_Sqlite.m_Mode)
 			{
-			case CDbConnectionPool::Mode::READ:
-				m_vpReadConnections.push_back(std::move(pSqlite));
-				break;
 			case CDbConnectionPool::Mode::WRITE:
 				m_pWriteConnection = std::move(pSqlite);
 				break;
 			case CDbConnectionPool::Mode::WRITE_BACKUP:
 				m_pWriteBackup = std::move(pSqlite);
 				break;
+			case CDbConnectionPool::Mode::READ:
 			case CDbConnectionPool::Mode::NUM_MODES:
 				break;
 			}
@@ -404,16 +543,9 @@ void CWorker::ProcessQueries()
 	}
 }
 
-void CWorker::Print(IConsole *pConsole, CDbConnectionPool::Mode DatabaseMode)
+void CWriteWorker::Print(IConsole *pConsole, CDbConnectionPool::Mode DatabaseMode)
 {
-	if(DatabaseMode == CDbConnectionPool::Mode::READ)
-	{
-		for(auto &pReadConnection : m_vpReadConnections)
-			pReadConnection->Print(pConsole, "Read");
-		if(m_vpReadConnections.empty())
-			pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "There are no read databases");
-	}
-	else if(DatabaseMode == CDbConnectionPool::Mode::WRITE)
+	if(DatabaseMode == CDbConnectionPool::Mode::WRITE)
 	{
 		if(m_pWriteConnection)
 			m_pWriteConnection->Print(pConsole, "Write");
@@ -429,6 +561,86 @@ void CWorker::Print(IConsole *pConsole, CDbConnectionPool::Mode DatabaseMode)
 	}
 }
 
+// The read workers execute read queries concurrently, so a slow write or a
+// reconnect of the write server doesn't delay rank lookups. Every worker has
+// its own copies of the read connections.
+class CReadWorker
+{
+public:
+	CReadWorker(std::shared_ptr<CDbConnectionPool::CSharedData> pShared) :
+		m_pShared(std::move(pShared)) {}
+	static void Start(void *pUser);
+	void ProcessQueries();
+
+private:
+	std::vector<std::unique_ptr<IDbConnection>> m_vpReadConnections;
+
+	std::shared_ptr<CDbConnectionPool::CSharedData> m_pShared;
+};
+
+/* static */
+void CReadWorker::Start(void *pUser)
+{
+	CReadWorker *pThis = (CReadWorker *)pUser;
+	pThis->ProcessQueries();
+	pThis->m_pShared->m_NumReadWorkersRunning--;
+	delete pThis;
+}
+
+void CReadWorker::ProcessQueries()
+{
+	// remember last working server and try to connect to it first
+	int ReadServer = 0;
+	for(int JobNum = 0;; JobNum++)
+	{
+		std::unique_ptr<CSqlExecData> pThreadData;
+		{
+			std::unique_lock<std::mutex> Lock(m_pShared->m_ReadMutex);
+			m_pShared->m_ReadCv.wait(Lock, [this]() { return !m_pShared->m_vpReadQueries.empty() || m_pShared->m_ReadShutdown; });
+			if(m_pShared->m_vpReadQueries.empty())
+				return;
+			pThreadData = std::move(m_pShared->m_vpReadQueries.front());
+			m_pShared->m_vpReadQueries.pop_front();
+			m_pShared->m_ReadStats.OnDequeued();
+
+			// servers are only ever added
+			for(size_t i = m_vpReadConnections.size(); i < m_pShared->m_vpReadConnections.size(); i++)
+			{
+				if(m_pShared->m_vpReadConnections[i])
+					m_vpReadConnections.emplace_back(m_pShared->m_vpReadConnections[i]->Copy());
+				else
+					m_vpReadConnections.emplace_back(nullptr);
+			}
+		}
+
+		bool Success = false;
+		for(size_t i = 0; i < m_vpReadConnections.size(); i++)
+		{
+			if(m_pShared->m_ReadShutdown)
+			{
+				dbg_msg("sql", "[%i] %s dismissed read request during shutdown", JobNum, pThreadData->m_pName);
+				break;
+			}
+			int CurServer = (ReadServer + i) % (int)m_vpReadConnections.size();
+			if(CDbConnectionPool::ExecSqlFunc(m_vpReadConnections[CurServer].get(), pThreadData.get(), Write::NORMAL))
+			{
+				ReadServer = CurServer;
+				dbg_msg("sql", "[%i] %s done on read database %d", JobNum, pThreadData->m_pName, CurServer);
+				Success = true;
+				break;
+			}
+		}
+		if(!Success)
+			dbg_msg("sql", "[%i] %s failed on all databases", JobNum, pThreadData->m_pName);
+		m_pShared->m_ReadStats.OnDone(pThreadData->m_QueuedTime, Success);
+		if(pThreadData->m_pThreadData != nullptr && pThreadData->m_pThreadData->m_pResult != nullptr)
+		{
+			pThreadData->m_pThreadData->m_pResult->m_Success = Success;
+			pThreadData->m_pThreadData->m_pResult->m_Completed.store(true);
+		}
+	}
+}
+
 /* static */
 bool CDbConnectionPool::ExecSqlFunc(IDbConnection *pConnection, CSqlExecData *pData, Write w)
 {
@@ -467,6 +679,16 @@ CDbConnectionPool::CDbConnectionPool()
 {
 	m_pShared = std::make_shared<CSharedData>();
 
-	thread_init_and_detach(CWorker::Start, new CWorker(m_pShared), "database worker thread");
+	thread_init_and_detach(CWriteWorker::Start, new CWriteWorker(m_pShared), "database write worker thread");
 	thread_init_and_detach(CBackup::Start, new CBackup(m_pShared), "database backup worker thread");
 }
+
+void CDbConnectionPool::StartReadWorkers()
+{
+	m_ReadWorkersStarted = true;
+	for(int i = 0; i < m_NumReadWorkers; i++)
+	{
+		m_pShared->m_NumReadWorkersRunning++;
+		thread_init_and_detach(CReadWorker::Start, new CReadWorker(m_pShared), "database read worker thread");
+	}
+}
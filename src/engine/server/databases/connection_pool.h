@@ -3,7 +3,10 @@
 
 #include <atomic>
 #include <base/tl/threading.h>
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 class IDbConnection;
@@ -45,6 +48,16 @@ enum Write
 
 class IConsole;
 
+// counters of the prepared statement caches of all connections of a pool
+struct CDbStatementCacheStats
+{
+	std::atomic<int64_t> m_Hits{0};
+	std::atomic<int64_t> m_Misses{0};
+	std::atomic<int64_t> m_Evictions{0};
+	// whole caches dropped because the connection was lost
+	std::atomic<int64_t> m_Invalidations{0};
+};
+
 struct CMysqlConfig
 {
 	char m_aDatabase[64];
@@ -77,32 +90,73 @@ public:
 	};
 
 	void Print(IConsole *pConsole, Mode DatabaseMode);
+	void PrintStats(IConsole *pConsole);
+
+	// number of read worker threads, takes effect when the first read query
+	// is executed
+	void SetNumReadWorkers(int NumReadWorkers);
 
 	void RegisterSqliteDatabase(Mode DatabaseMode, const char FileName[64]);
 	void RegisterMysqlDatabase(Mode DatabaseMode, const CMysqlConfig *pMysqlConfig);
 
+	// Read queries run concurrently on the read workers, each with its own
+	// connections. When the read queue is full, the query is dropped and its
+	// result completes unsuccessfully.
 	void Execute(
 		FRead pFunc,
 		std::unique_ptr<const ISqlData> pSqlRequestData,
 		const char *pName);
 	// writes to WRITE_BACKUP first and removes it from there when successfully
-	// executed on WRITE server
+	// executed on WRITE server. Writes are executed in order by a single
+	// worker. When the write queue is full, writes wait in an overflow list
+	// until Update moves them into the queue, the caller never blocks.
 	void ExecuteWrite(
 		FWrite pFunc,
 		std::unique_ptr<const ISqlData> pSqlRequestData,
 		const char *pName);
+	// moves overflowed writes into the write queue, call regularly from the
+	// main thread
+	void Update();
 
 	void OnShutdown();
 
-	friend class CWorker;
+	friend class CWriteWorker;
+	friend class CReadWorker;
 	friend class CBackup;
 
 private:
 	static bool ExecSqlFunc(IDbConnection *pConnection, struct CSqlExecData *pData, Write w);
 
+	void StartReadWorkers();
+	// adds a query or command to the ordered write queue
+	void QueueWrite(std::unique_ptr<struct CSqlExecData> pData);
+	// moves writes from the overflow list into free slots of the write queue
+	void FlushWriteOverflow();
+
 	// Only the main thread accesses this variable. It points to the index,
 	// where the next query is added to the queue.
 	int m_InsertIdx = 0;
+	// writes that didn't fit into the write queue, in order. Only the main
+	// thread accesses this.
+	std::deque<std::unique_ptr<struct CSqlExecData>> m_vpWriteOverflow;
+	int m_NumReadWorkers = 1;
+	bool m_ReadWorkersStarted = false;
+
+	struct CQueueStats
+	{
+		std::atomic_int m_Depth{0};
+		std::atomic_int m_MaxDepth{0};
+		std::atomic<int64_t> m_Processed{0};
+		std::atomic<int64_t> m_Failed{0};
+		std::atomic<int64_t> m_Overflows{0};
+		// time_get() ticks from queueing to completion
+		std::atomic<int64_t> m_TotalLatency{0};
+		std::atomic<int64_t> m_MaxLatency{0};
+
+		void OnQueued();
+		void OnDequeued();
+		void OnDone(int64_t QueuedTime, bool Success);
+	};
 
 	struct CSharedData
 	{
@@ -121,6 +175,28 @@ private:
 
 		// spsc queue with additional backup worker to look at queries first.
 		std::unique_ptr<struct CSqlExecData> m_aQueries[512];
+
+		// mpmc queue of read queries, bounded by MAX_READ_QUERIES
+		std::mutex m_ReadMutex;
+		std::condition_variable m_ReadCv;
+		std::deque<std::unique_ptr<struct CSqlExecData>> m_vpReadQueries;
+		// read servers, copied by every read worker for its own connections
+		std::vector<std::unique_ptr<IDbConnection>> m_vpReadConnections;
+		std::atomic_int m_NumReadWorkersRunning{0};
+		// unlike m_Shutdown, this stays set after shutdown
+		std::atomic_bool m_ReadShutdown{false};
+
+		CQueueStats m_ReadStats;
+		CQueueStats m_WriteStats;
+		CDbStatementCacheStats m_StatementCacheStats;
+	};
+
+	// lets the connection count into the statistics of the pool
+	static void ShareStatementCacheStats(IDbConnection *pConnection, const std::shared_ptr<CSharedData> &pShared);
+
+	enum
+	{
+		MAX_READ_QUERIES = 512,
 	};
 
 	std::shared_ptr<CSharedData> m_pShared;
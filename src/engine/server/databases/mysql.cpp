@@ -3,6 +3,7 @@
 #include <engine/server/databases/connection_pool.h>
 
 #if defined(CONF_MYSQL)
+#include <errmsg.h>
 #include <mysql.h>
 
 #include <base/tl/threading.h>
@@ -105,6 +106,10 @@ public:
 
 	bool AddPoints(const char *pPlayer, int Points, char *pError, int ErrorSize) override;
 
+	bool BeginTransaction(char *pError, int ErrorSize) override;
+	bool CommitTransaction(char *pError, int ErrorSize) override;
+	bool RollbackTransaction(char *pError, int ErrorSize) override;
+
 private:
 	class CStmtDeleter
 	{
@@ -114,9 +119,14 @@ private:
 
 	char m_aErrorDetail[128];
 	void StoreErrorMysql(const char *pContext);
-	void StoreErrorStmt(const char *pContext);
+	void StoreErrorStmt(const char *pContext, MYSQL_STMT *pStmt);
 	bool ConnectImpl();
+	// for statements that run only once, not cached
 	bool PrepareAndExecuteStatement(const char *pStmt);
+	// after a lost connection, the server forgot all prepared statements
+	void InvalidateStatements();
+	// a failed execute only drops the cache if the connection was lost
+	void ExecuteFailed(unsigned long ThreadId);
 	//static void DeleteResult(MYSQL_RES *pResult);
 
 	union UParameterExtra
@@ -129,7 +139,9 @@ private:
 	bool m_NewQuery = false;
 	bool m_HaveConnection = false;
 	MYSQL m_Mysql;
-	std::unique_ptr<MYSQL_STMT, CStmtDeleter> m_pStmt = nullptr;
+	CStatementCache<MYSQL_STMT, CStmtDeleter> m_Statements{STATEMENT_CACHE_SIZE};
+	// current statement, owned by m_Statements
+	MYSQL_STMT *m_pStmt = nullptr;
 	std::vector<MYSQL_BIND> m_vStmtParameters;
 	std::vector<UParameterExtra> m_vStmtParameterExtras;
 
@@ -159,6 +171,8 @@ CMysqlConnection::CMysqlConnection(CMysqlConfig Config) :
 
 CMysqlConnection::~CMysqlConnection()
 {
+	m_pStmt = nullptr;
+	m_Statements.Clear();
 	mysql_close(&m_Mysql);
 	g_MysqlNumConnections -= 1;
 }
@@ -168,26 +182,50 @@ void CMysqlConnection::StoreErrorMysql(const char *pContext)
 	str_format(m_aErrorDetail, sizeof(m_aErrorDetail), "(%s:mysql:%d): %s", pContext, mysql_errno(&m_Mysql), mysql_error(&m_Mysql));
 }
 
-void CMysqlConnection::StoreErrorStmt(const char *pContext)
+void CMysqlConnection::StoreErrorStmt(const char *pContext, MYSQL_STMT *pStmt)
 {
-	str_format(m_aErrorDetail, sizeof(m_aErrorDetail), "(%s:stmt:%d): %s", pContext, mysql_stmt_errno(m_pStmt.get()), mysql_stmt_error(m_pStmt.get()));
+	str_format(m_aErrorDetail, sizeof(m_aErrorDetail), "(%s:stmt:%d): %s", pContext, mysql_stmt_errno(pStmt), mysql_stmt_error(pStmt));
 }
 
 bool CMysqlConnection::PrepareAndExecuteStatement(const char *pStmt)
 {
-	if(mysql_stmt_prepare(m_pStmt.get(), pStmt, str_length(pStmt)))
+	std::unique_ptr<MYSQL_STMT, CStmtDeleter> pOnceStmt(mysql_stmt_init(&m_Mysql));
+	if(!pOnceStmt)
+	{
+		StoreErrorMysql("stmt_init");
+		return true;
+	}
+	if(mysql_stmt_prepare(pOnceStmt.get(), pStmt, str_length(pStmt)))
 	{
-		StoreErrorStmt("prepare");
+		StoreErrorStmt("prepare", pOnceStmt.get());
 		return true;
 	}
-	if(mysql_stmt_execute(m_pStmt.get()))
+	if(mysql_stmt_execute(pOnceStmt.get()))
 	{
-		StoreErrorStmt("execute");
+		StoreErrorStmt("execute", pOnceStmt.get());
 		return true;
 	}
 	return false;
 }
 
+void CMysqlConnection::InvalidateStatements()
+{
+	if(m_Statements.Size() > 0)
+		m_pStatementCacheStats->m_Invalidations.fetch_add(1, std::memory_order_relaxed);
+	m_pStmt = nullptr;
+	m_Statements.Clear();
+}
+
+void CMysqlConnection::ExecuteFailed(unsigned long ThreadId)
+{
+	// other errors, such as a duplicate key, only concern this statement
+	const unsigned Errno = mysql_stmt_errno(m_pStmt);
+	if(Errno == CR_SERVER_LOST || Errno == CR_SERVER_GONE_ERROR || mysql_thread_id(&m_Mysql) != ThreadId)
+		InvalidateStatements();
+	else
+		mysql_stmt_reset(m_pStmt);
+}
+
 void CMysqlConnection::Print(IConsole *pConsole, const char *pMode)
 {
 	char aBuf[512];
@@ -199,7 +237,9 @@ void CMysqlConnection::Print(IConsole *pConsole, const char *pMode)
 
 CMysqlConnection *CMysqlConnection::Copy()
 {
-	return new CMysqlConnection(m_Config);
+	CMysqlConnection *pCopy = new CMysqlConnection(m_Config);
+	pCopy->SetStatementCacheStats(m_pStatementCacheStats);
+	return pCopy;
 }
 
 void CMysqlConnection::ToUnixTimestamp(const char *pTimestamp, char *aBuf, unsigned int BufferSize)
@@ -228,9 +268,9 @@ bool CMysqlConnection::ConnectImpl()
 {
 	if(m_HaveConnection)
 	{
-		if(m_pStmt && mysql_stmt_free_result(m_pStmt.get()))
+		if(m_pStmt && mysql_stmt_free_result(m_pStmt))
 		{
-			StoreErrorStmt("free_result");
+			StoreErrorStmt("free_result", m_pStmt);
 			dbg_msg("mysql", "can't free last result %s", m_aErrorDetail);
 		}
 		if(!mysql_select_db(&m_Mysql, m_Config.m_aDatabase))
@@ -240,12 +280,13 @@ bool CMysqlConnection::ConnectImpl()
 		}
 		StoreErrorMysql("select_db");
 		dbg_msg("mysql", "ping error, trying to reconnect %s", m_aErrorDetail);
+		InvalidateStatements();
 		mysql_close(&m_Mysql);
 		mem_zero(&m_Mysql, sizeof(m_Mysql));
 		mysql_init(&m_Mysql);
 	}
 
-	m_pStmt = nullptr;
+	InvalidateStatements();
 	unsigned int OptConnectTimeout = 60;
 	unsigned int OptReadTimeout = 60;
 	unsigned int OptWriteTimeout = 120;
@@ -267,8 +308,6 @@ bool CMysqlConnection::ConnectImpl()
 	}
 	m_HaveConnection = true;
 
-	m_pStmt = std::unique_ptr<MYSQL_STMT, CStmtDeleter>(mysql_stmt_init(&m_Mysql));
-
 	// Apparently MYSQL_SET_CHARSET_NAME is not enough
 	if(PrepareAndExecuteStatement("SET CHARACTER SET utf8mb4"))
 	{
@@ -300,17 +339,23 @@ bool CMysqlConnection::ConnectImpl()
 		char aCreateMaps[1024];
 		char aCreateSaves[1024];
 		char aCreatePoints[1024];
+		char aCreateInfcRounds[1024];
+		char aCreateInfcRoundScores[1024];
 		FormatCreateRace(aCreateRace, sizeof(aCreateRace), /* Backup */ false);
 		FormatCreateTeamrace(aCreateTeamrace, sizeof(aCreateTeamrace), "VARBINARY(16)", /* Backup */ false);
 		FormatCreateMaps(aCreateMaps, sizeof(aCreateMaps));
 		FormatCreateSaves(aCreateSaves, sizeof(aCreateSaves), /* Backup */ false);
 		FormatCreatePoints(aCreatePoints, sizeof(aCreatePoints));
+		FormatCreateInfcRounds(aCreateInfcRounds, sizeof(aCreateInfcRounds), /* Backup */ false);
+		FormatCreateInfcRoundScores(aCreateInfcRoundScores, sizeof(aCreateInfcRoundScores), /* Backup */ false);
 
 		if(PrepareAndExecuteStatement(aCreateRace) ||
 			PrepareAndExecuteStatement(aCreateTeamrace) ||
 			PrepareAndExecuteStatement(aCreateMaps) ||
 			PrepareAndExecuteStatement(aCreateSaves) ||
-			PrepareAndExecuteStatement(aCreatePoints))
+			PrepareAndExecuteStatement(aCreatePoints) ||
+			PrepareAndExecuteStatement(aCreateInfcRounds) ||
+			PrepareAndExecuteStatement(aCreateInfcRoundScores))
 		{
 			return true;
 		}
@@ -327,14 +372,29 @@ void CMysqlConnection::Disconnect()
 
 bool CMysqlConnection::PrepareStatement(const char *pStmt, char *pError, int ErrorSize)
 {
-	if(mysql_stmt_prepare(m_pStmt.get(), pStmt, str_length(pStmt)))
+	// unread rows of the previous statement would block the connection
+	if(m_pStmt)
+		mysql_stmt_free_result(m_pStmt);
+	m_pStmt = m_Statements.Find(pStmt, m_pStatementCacheStats.get());
+	if(!m_pStmt)
 	{
-		StoreErrorStmt("prepare");
-		str_copy(pError, m_aErrorDetail, ErrorSize);
-		return true;
+		std::unique_ptr<MYSQL_STMT, CStmtDeleter> pNewStmt(mysql_stmt_init(&m_Mysql));
+		if(!pNewStmt)
+		{
+			StoreErrorMysql("stmt_init");
+			str_copy(pError, m_aErrorDetail, ErrorSize);
+			return true;
+		}
+		if(mysql_stmt_prepare(pNewStmt.get(), pStmt, str_length(pStmt)))
+		{
+			StoreErrorStmt("prepare", pNewStmt.get());
+			str_copy(pError, m_aErrorDetail, ErrorSize);
+			return true;
+		}
+		m_pStmt = m_Statements.Add(pStmt, std::move(pNewStmt), m_pStatementCacheStats.get());
 	}
 	m_NewQuery = true;
-	unsigned NumParameters = mysql_stmt_param_count(m_pStmt.get());
+	unsigned NumParameters = mysql_stmt_param_count(m_pStmt);
 	m_vStmtParameters.resize(NumParameters);
 	m_vStmtParameterExtras.resize(NumParameters);
 	mem_zero(&m_vStmtParameters[0], sizeof(m_vStmtParameters[0]) * m_vStmtParameters.size());
@@ -433,23 +493,26 @@ bool CMysqlConnection::Step(bool *pEnd, char *pError, int ErrorSize)
 	if(m_NewQuery)
 	{
 		m_NewQuery = false;
-		if(mysql_stmt_bind_param(m_pStmt.get(), &m_vStmtParameters[0]))
+		if(mysql_stmt_bind_param(m_pStmt, &m_vStmtParameters[0]))
 		{
-			StoreErrorStmt("bind_param");
+			StoreErrorStmt("bind_param", m_pStmt);
 			str_copy(pError, m_aErrorDetail, ErrorSize);
 			return true;
 		}
-		if(mysql_stmt_execute(m_pStmt.get()))
+		// an automatic reconnect changes the thread id
+		const unsigned long ThreadId = mysql_thread_id(&m_Mysql);
+		if(mysql_stmt_execute(m_pStmt))
 		{
-			StoreErrorStmt("execute");
+			StoreErrorStmt("execute", m_pStmt);
 			str_copy(pError, m_aErrorDetail, ErrorSize);
+			ExecuteFailed(ThreadId);
 			return true;
 		}
 	}
-	int Result = mysql_stmt_fetch(m_pStmt.get());
+	int Result = mysql_stmt_fetch(m_pStmt);
 	if(Result == 1)
 	{
-		StoreErrorStmt("fetch");
+		StoreErrorStmt("fetch", m_pStmt);
 		str_copy(pError, m_aErrorDetail, ErrorSize);
 		return true;
 	}
@@ -464,19 +527,22 @@ bool CMysqlConnection::ExecuteUpdate(int *pNumUpdated, char *pError, int ErrorSi
 	if(m_NewQuery)
 	{
 		m_NewQuery = false;
-		if(mysql_stmt_bind_param(m_pStmt.get(), &m_vStmtParameters[0]))
+		if(mysql_stmt_bind_param(m_pStmt, &m_vStmtParameters[0]))
 		{
-			StoreErrorStmt("bind_param");
+			StoreErrorStmt("bind_param", m_pStmt);
 			str_copy(pError, m_aErrorDetail, ErrorSize);
 			return true;
 		}
-		if(mysql_stmt_execute(m_pStmt.get()))
+		// an automatic reconnect changes the thread id
+		const unsigned long ThreadId = mysql_thread_id(&m_Mysql);
+		if(mysql_stmt_execute(m_pStmt))
 		{
-			StoreErrorStmt("execute");
+			StoreErrorStmt("execute", m_pStmt);
 			str_copy(pError, m_aErrorDetail, ErrorSize);
+			ExecuteFailed(ThreadId);
 			return true;
 		}
-		*pNumUpdated = mysql_stmt_affected_rows(m_pStmt.get());
+		*pNumUpdated = mysql_stmt_affected_rows(m_pStmt);
 		return false;
 	}
 	str_copy(pError, "tried to execute update without query", ErrorSize);
@@ -497,9 +563,9 @@ bool CMysqlConnection::IsNull(int Col)
 	Bind.is_null = &IsNull;
 	Bind.is_unsigned = false;
 	Bind.error = nullptr;
-	if(mysql_stmt_fetch_column(m_pStmt.get(), &Bind, Col, 0))
+	if(mysql_stmt_fetch_column(m_pStmt, &Bind, Col, 0))
 	{
-		StoreErrorStmt("fetch_column:null");
+		StoreErrorStmt("fetch_column:null", m_pStmt);
 		dbg_msg("mysql", "error fetching column %s", m_aErrorDetail);
 		dbg_assert(0, "error in IsNull");
 	}
@@ -521,9 +587,9 @@ float CMysqlConnection::GetFloat(int Col)
 	Bind.is_null = &IsNull;
 	Bind.is_unsigned = false;
 	Bind.error = nullptr;
-	if(mysql_stmt_fetch_column(m_pStmt.get(), &Bind, Col, 0))
+	if(mysql_stmt_fetch_column(m_pStmt, &Bind, Col, 0))
 	{
-		StoreErrorStmt("fetch_column:float");
+		StoreErrorStmt("fetch_column:float", m_pStmt);
 		dbg_msg("mysql", "error fetching column %s", m_aErrorDetail);
 		dbg_assert(0, "error in GetFloat");
 	}
@@ -549,9 +615,9 @@ int CMysqlConnection::GetInt(int Col)
 	Bind.is_null = &IsNull;
 	Bind.is_unsigned = false;
 	Bind.error = nullptr;
-	if(mysql_stmt_fetch_column(m_pStmt.get(), &Bind, Col, 0))
+	if(mysql_stmt_fetch_column(m_pStmt, &Bind, Col, 0))
 	{
-		StoreErrorStmt("fetch_column:int");
+		StoreErrorStmt("fetch_column:int", m_pStmt);
 		dbg_msg("mysql", "error fetching column %s", m_aErrorDetail);
 		dbg_assert(0, "error in GetInt");
 	}
@@ -577,9 +643,9 @@ int64_t CMysqlConnection::GetInt64(int Col)
 	Bind.is_null = &IsNull;
 	Bind.is_unsigned = false;
 	Bind.error = nullptr;
-	if(mysql_stmt_fetch_column(m_pStmt.get(), &Bind, Col, 0))
+	if(mysql_stmt_fetch_column(m_pStmt, &Bind, Col, 0))
 	{
-		StoreErrorStmt("fetch_column:int64");
+		StoreErrorStmt("fetch_column:int64", m_pStmt);
 		dbg_msg("mysql", "error fetching column %s", m_aErrorDetail);
 		dbg_assert(0, "error in GetInt64");
 	}
@@ -612,9 +678,9 @@ void CMysqlConnection::GetString(int Col, char *pBuffer, int BufferSize)
 	Bind.is_null = &IsNull;
 	Bind.is_unsigned = false;
 	Bind.error = &Error;
-	if(mysql_stmt_fetch_column(m_pStmt.get(), &Bind, Col, 0))
+	if(mysql_stmt_fetch_column(m_pStmt, &Bind, Col, 0))
 	{
-		StoreErrorStmt("fetch_column:string");
+		StoreErrorStmt("fetch_column:string", m_pStmt);
 		dbg_msg("mysql", "error fetching column %s", m_aErrorDetail);
 		dbg_assert(0, "error in GetString");
 	}
@@ -644,9 +710,9 @@ int CMysqlConnection::GetBlob(int Col, unsigned char *pBuffer, int BufferSize)
 	Bind.is_null = &IsNull;
 	Bind.is_unsigned = false;
 	Bind.error = &Error;
-	if(mysql_stmt_fetch_column(m_pStmt.get(), &Bind, Col, 0))
+	if(mysql_stmt_fetch_column(m_pStmt, &Bind, Col, 0))
 	{
-		StoreErrorStmt("fetch_column:blob");
+		StoreErrorStmt("fetch_column:blob", m_pStmt);
 		dbg_msg("mysql", "error fetching column %s", m_aErrorDetail);
 		dbg_assert(0, "error in GetBlob");
 	}
@@ -692,6 +758,42 @@ bool CMysqlConnection::AddPoints(const char *pPlayer, int Points, char *pError,
 	return ExecuteUpdate(&NumUpdated, pError, ErrorSize);
 }
 
+bool CMysqlConnection::BeginTransaction(char *pError, int ErrorSize)
+{
+	if(mysql_autocommit(&m_Mysql, false))
+	{
+		StoreErrorMysql("autocommit");
+		str_copy(pError, m_aErrorDetail, ErrorSize);
+		return true;
+	}
+	return false;
+}
+
+bool CMysqlConnection::CommitTransaction(char *pError, int ErrorSize)
+{
+	if(mysql_commit(&m_Mysql))
+	{
+		StoreErrorMysql("commit");
+		str_copy(pError, m_aErrorDetail, ErrorSize);
+		mysql_autocommit(&m_Mysql, true);
+		return true;
+	}
+	mysql_autocommit(&m_Mysql, true);
+	return false;
+}
+
+bool CMysqlConnection::RollbackTransaction(char *pError, int ErrorSize)
+{
+	bool Failed = mysql_rollback(&m_Mysql);
+	if(Failed)
+	{
+		StoreErrorMysql("rollback");
+		str_copy(pError, m_aErrorDetail, ErrorSize);
+	}
+	mysql_autocommit(&m_Mysql, true);
+	return Failed;
+}
+
 std::unique_ptr<IDbConnection> CreateMysqlConnection(CMysqlConfig Config)
 {
 	return std::make_unique<CMysqlConnection>(Config);
@@ -54,17 +54,30 @@ public:
 
 	bool AddPoints(const char *pPlayer, int Points, char *pError, int ErrorSize) override;
 
+	bool BeginTransaction(char *pError, int ErrorSize) override;
+	bool CommitTransaction(char *pError, int ErrorSize) override;
+	bool RollbackTransaction(char *pError, int ErrorSize) override;
+
 	// fail safe
 	bool CreateFailsafeTables();
 
 private:
+	class CStmtDeleter
+	{
+	public:
+		void operator()(sqlite3_stmt *pStmt) const { sqlite3_finalize(pStmt); }
+	};
+
 	// copy of config vars
 	char m_aFilename[IO_MAX_PATH_LENGTH];
 	bool m_Setup;
 
 	sqlite3 *m_pDb;
+	CStatementCache<sqlite3_stmt, CStmtDeleter> m_Statements;
+	// current statement, owned by m_Statements
 	sqlite3_stmt *m_pStmt;
 	bool m_Done; // no more rows available for Step
+	void ResetStatement();
 	// returns false, if the query succeeded
 	bool Execute(const char *pQuery, char *pError, int ErrorSize);
 
@@ -79,6 +92,7 @@ CSqliteConnection::CSqliteConnection(const char *pFilename, bool Setup) :
 	IDbConnection("record"),
 	m_Setup(Setup),
 	m_pDb(nullptr),
+	m_Statements(STATEMENT_CACHE_SIZE),
 	m_pStmt(nullptr),
 	m_Done(true),
 	m_InUse(false)
@@ -88,8 +102,9 @@ CSqliteConnection::CSqliteConnection(const char *pFilename, bool Setup) :
 
 CSqliteConnection::~CSqliteConnection()
 {
-	if(m_pStmt != nullptr)
-		sqlite3_finalize(m_pStmt);
+	// the database can't be closed with unfinalized statements
+	m_pStmt = nullptr;
+	m_Statements.Clear();
 	sqlite3_close(m_pDb);
 	m_pDb = nullptr;
 }
@@ -110,7 +125,9 @@ void CSqliteConnection::ToUnixTimestamp(const char *pTimestamp, char *aBuf, unsi
 
 CSqliteConnection *CSqliteConnection::Copy()
 {
-	return new CSqliteConnection(m_aFilename, m_Setup);
+	CSqliteConnection *pCopy = new CSqliteConnection(m_aFilename, m_Setup);
+	pCopy->SetStatementCacheStats(m_pStatementCacheStats);
+	return pCopy;
 }
 
 bool CSqliteConnection::Connect(char *pError, int ErrorSize)
@@ -158,6 +175,12 @@ bool CSqliteConnection::Connect(char *pError, int ErrorSize)
 		if(Execute(aBuf, pError, ErrorSize))
 			return true;
 		FormatCreatePoints(aBuf, sizeof(aBuf));
+		if(Execute(aBuf, pError, ErrorSize))
+			return true;
+		FormatCreateInfcRounds(aBuf, sizeof(aBuf), /* Backup */ false);
+		if(Execute(aBuf, pError, ErrorSize))
+			return true;
+		FormatCreateInfcRoundScores(aBuf, sizeof(aBuf), /* Backup */ false);
 		if(Execute(aBuf, pError, ErrorSize))
 			return true;
 
@@ -168,6 +191,12 @@ bool CSqliteConnection::Connect(char *pError, int ErrorSize)
 		if(Execute(aBuf, pError, ErrorSize))
 			return true;
 		FormatCreateSaves(aBuf, sizeof(aBuf), /* Backup */ true);
+		if(Execute(aBuf, pError, ErrorSize))
+			return true;
+		FormatCreateInfcRounds(aBuf, sizeof(aBuf), /* Backup */ true);
+		if(Execute(aBuf, pError, ErrorSize))
+			return true;
+		FormatCreateInfcRoundScores(aBuf, sizeof(aBuf), /* Backup */ true);
 		if(Execute(aBuf, pError, ErrorSize))
 			return true;
 		m_Setup = false;
@@ -177,27 +206,43 @@ bool CSqliteConnection::Connect(char *pError, int ErrorSize)
 
 void CSqliteConnection::Disconnect()
 {
+	ResetStatement();
+	m_InUse.store(false);
+}
+
+void CSqliteConnection::ResetStatement()
+{
+	// a statement that isn't reset keeps its read transaction open
 	if(m_pStmt != nullptr)
-		sqlite3_finalize(m_pStmt);
+		sqlite3_reset(m_pStmt);
 	m_pStmt = nullptr;
-	m_InUse.store(false);
 }
 
 bool CSqliteConnection::PrepareStatement(const char *pStmt, char *pError, int ErrorSize)
 {
+	ResetStatement();
+	m_pStmt = m_Statements.Find(pStmt, m_pStatementCacheStats.get());
 	if(m_pStmt != nullptr)
-		sqlite3_finalize(m_pStmt);
-	m_pStmt = nullptr;
+	{
+		// the bound strings and blobs aren't copied, don't keep pointers to them
+		sqlite3_clear_bindings(m_pStmt);
+		m_Done = false;
+		return false;
+	}
+
+	sqlite3_stmt *pNewStmt = nullptr;
 	int Result = sqlite3_prepare_v2(
 		m_pDb,
 		pStmt,
 		-1, // pStmt can be any length
-		&m_pStmt,
+		&pNewStmt,
 		NULL);
 	if(FormatError(Result, pError, ErrorSize))
 	{
+		sqlite3_finalize(pNewStmt);
 		return true;
 	}
+	m_pStmt = m_Statements.Add(pStmt, decltype(m_Statements)::CStmtPtr(pNewStmt), m_pStatementCacheStats.get());
 	m_Done = false;
 	return false;
 }
@@ -350,6 +395,8 @@ const char *CSqliteConnection::MedianMapTime(char *pBuffer, int BufferSize) cons
 
 bool CSqliteConnection::Execute(const char *pQuery, char *pError, int ErrorSize)
 {
+	// a pending statement would make COMMIT fail
+	ResetStatement();
 	char *pErrorMsg;
 	int Result = sqlite3_exec(m_pDb, pQuery, NULL, NULL, &pErrorMsg);
 	if(Result != SQLITE_OK)
@@ -400,6 +447,21 @@ bool CSqliteConnection::AddPoints(const char *pPlayer, int Points, char *pError,
 	return Step(&End, pError, ErrorSize);
 }
 
+bool CSqliteConnection::BeginTransaction(char *pError, int ErrorSize)
+{
+	return Execute("BEGIN", pError, ErrorSize);
+}
+
+bool CSqliteConnection::CommitTransaction(char *pError, int ErrorSize)
+{
+	return Execute("COMMIT", pError, ErrorSize);
+}
+
+bool CSqliteConnection::RollbackTransaction(char *pError, int ErrorSize)
+{
+	return Execute("ROLLBACK", pError, ErrorSize);
+}
+
 std::unique_ptr<IDbConnection> CreateSqliteConnection(const char *pFilename, bool Setup)
 {
 	return std::make_unique<CSqliteConnection>(pFilename, Setup);
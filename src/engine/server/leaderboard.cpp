@@ -0,0 +1,117 @@
+#include "leaderboard.h"
+
+#include <base/math.h>
+
+#include <algorithm>
+
+bool CLeaderboard::Before(const CEntry &Left, const CEntry &Right)
+{
+	if(Left.m_Score != Right.m_Score)
+		return Left.m_Score > Right.m_Score;
+	return str_comp(Left.m_aName, Right.m_aName) < 0;
+}
+
+void CLeaderboard::AddScore(CPlayer *pPlayer, int Score)
+{
+	std::vector<int> &vBest = pPlayer->m_vBestScores;
+	if((int)vBest.size() == NUM_BEST_ROUNDS)
+	{
+		if(Score <= vBest.back())
+			return;
+		pPlayer->m_Score -= vBest.back();
+		vBest.pop_back();
+	}
+	vBest.insert(std::upper_bound(vBest.begin(), vBest.end(), Score, std::greater<int>()), Score);
+	pPlayer->m_Score += Score;
+}
+
+void CLeaderboard::AddRound(int ScoreType, const char *pName, int Score)
+{
+	CTable &Table = m_Tables[ScoreType];
+	CPlayer &Player = Table.m_Players[pName];
+
+	CEntry Entry;
+	str_copy(Entry.m_aName, pName);
+	if(!Player.m_vBestScores.empty())
+	{
+		Entry.m_Score = Player.m_Score;
+		auto It = std::lower_bound(Table.m_vSorted.begin(), Table.m_vSorted.end(), Entry, Before);
+		dbg_assert(It != Table.m_vSorted.end() && str_comp(It->m_aName, pName) == 0, "leaderboard out of sync");
+		Table.m_vSorted.erase(It);
+	}
+
+	AddScore(&Player, Score);
+	Entry.m_Score = Player.m_Score;
+	Entry.m_NumRounds = Player.m_vBestScores.size();
+	Table.m_vSorted.insert(std::lower_bound(Table.m_vSorted.begin(), Table.m_vSorted.end(), Entry, Before), Entry);
+}
+
+void CLeaderboard::AddRoundUnsorted(int ScoreType, const char *pName, int Score)
+{
+	AddScore(&m_Tables[ScoreType].m_Players[pName], Score);
+}
+
+void CLeaderboard::Sort()
+{
+	for(auto &[ScoreType, Table] : m_Tables)
+	{
+		Table.m_vSorted.clear();
+		Table.m_vSorted.reserve(Table.m_Players.size());
+		for(const auto &[Name, Player] : Table.m_Players)
+		{
+			CEntry Entry;
+			str_copy(Entry.m_aName, Name.c_str());
+			Entry.m_Score = Player.m_Score;
+			Entry.m_NumRounds = Player.m_vBestScores.size();
+			Table.m_vSorted.push_back(Entry);
+		}
+		std::sort(Table.m_vSorted.begin(), Table.m_vSorted.end(), Before);
+	}
+}
+
+const CLeaderboard::CEntry *CLeaderboard::Find(const CTable &Table, int Score, const char *pName) const
+{
+	CEntry Key;
+	str_copy(Key.m_aName, pName);
+	Key.m_Score = Score;
+	auto It = std::lower_bound(Table.m_vSorted.begin(), Table.m_vSorted.end(), Key, Before);
+	if(It == Table.m_vSorted.end() || str_comp(It->m_aName, pName) != 0)
+		return nullptr;
+	return &*It;
+}
+
+int CLeaderboard::Rank(int ScoreType, const char *pName, const CEntry **ppEntry) const
+{
+	auto TableIt = m_Tables.find(ScoreType);
+	if(TableIt == m_Tables.end())
+		return 0;
+	const CTable &Table = TableIt->second;
+	auto PlayerIt = Table.m_Players.find(pName);
+	if(PlayerIt == Table.m_Players.end())
+		return 0;
+
+	const CEntry *pEntry = Find(Table, PlayerIt->second.m_Score, pName);
+	if(!pEntry)
+		return 0;
+	if(ppEntry)
+		*ppEntry = pEntry;
+	return pEntry - Table.m_vSorted.data() + 1;
+}
+
+int CLeaderboard::Top(int ScoreType, const CEntry **ppEntries, int MaxEntries) const
+{
+	auto TableIt = m_Tables.find(ScoreType);
+	if(TableIt == m_Tables.end())
+		return 0;
+	const std::vector<CEntry> &vSorted = TableIt->second.m_vSorted;
+	int NumEntries = minimum((int)vSorted.size(), MaxEntries);
+	for(int i = 0; i < NumEntries; i++)
+		ppEntries[i] = &vSorted[i];
+	return NumEntries;
+}
+
+int CLeaderboard::NumPlayers(int ScoreType) const
+{
+	auto TableIt = m_Tables.find(ScoreType);
+	return TableIt == m_Tables.end() ? 0 : TableIt->second.m_vSorted.size();
+}
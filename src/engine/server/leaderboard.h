@@ -0,0 +1,69 @@
+#ifndef ENGINE_SERVER_LEADERBOARD_H
+#define ENGINE_SERVER_LEADERBOARD_H
+
+#include <base/system.h>
+#include <engine/shared/protocol.h>
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+	Leaderboard of one map: for every score type, the players ordered by the
+	sum of their best rounds. Ranks are found by binary search and the top
+	entries are the front of the sorted array, so rank and top requests don't
+	need the database.
+*/
+class CLeaderboard
+{
+public:
+	enum
+	{
+		NUM_BEST_ROUNDS = 32,
+	};
+
+	class CEntry
+	{
+	public:
+		char m_aName[MAX_NAME_LENGTH];
+		int m_Score;
+		int m_NumRounds;
+	};
+
+	// adds a round score of a player and keeps the order
+	void AddRound(int ScoreType, const char *pName, int Score);
+	// bulk loading: adds the score unordered, Sort() has to be called afterwards
+	void AddRoundUnsorted(int ScoreType, const char *pName, int Score);
+	void Sort();
+
+	// returns the 1-based rank or 0 if the player has no score yet
+	int Rank(int ScoreType, const char *pName, const CEntry **ppEntry = nullptr) const;
+	// returns the number of entries written, in order
+	int Top(int ScoreType, const CEntry **ppEntries, int MaxEntries) const;
+	int NumPlayers(int ScoreType) const;
+
+private:
+	class CPlayer
+	{
+	public:
+		std::vector<int> m_vBestScores; // descending, at most NUM_BEST_ROUNDS
+		int m_Score = 0;
+	};
+
+	class CTable
+	{
+	public:
+		std::unordered_map<std::string, CPlayer> m_Players;
+		// by score descending, then name ascending
+		std::vector<CEntry> m_vSorted;
+	};
+
+	static bool Before(const CEntry &Left, const CEntry &Right);
+	static void AddScore(CPlayer *pPlayer, int Score);
+	const CEntry *Find(const CTable &Table, int Score, const char *pName) const;
+
+	std::map<int, CTable> m_Tables;
+};
+
+#endif // ENGINE_SERVER_LEADERBOARD_H
@@ -0,0 +1,53 @@
+#include "login_throttle.h"
+
+#include <algorithm>
+
+int CLoginThrottle::Find(const NETADDR *pAddr) const
+{
+	for(int i = 0; i < (int)m_vEntries.size(); i++)
+	{
+		if(net_addr_comp_noport(&m_vEntries[i].m_Addr, pAddr) == 0)
+			return i;
+	}
+	return -1;
+}
+
+int CLoginThrottle::BlockedFor(const NETADDR *pAddr, int64_t Now) const
+{
+	int Index = Find(pAddr);
+	if(Index < 0)
+		return 0;
+	const CEntry *pEntry = &m_vEntries[Index];
+	if(pEntry->m_NumFailures < MAX_FAILURES || pEntry->m_WindowEnd <= Now)
+		return 0;
+	return (pEntry->m_WindowEnd - Now + time_freq() - 1) / time_freq();
+}
+
+void CLoginThrottle::OnFailure(const NETADDR *pAddr, int64_t Now)
+{
+	int Index = Find(pAddr);
+	if(Index < 0)
+	{
+		CEntry Entry;
+		Entry.m_Addr = *pAddr;
+		Entry.m_Addr.port = 0;
+		Entry.m_WindowEnd = 0;
+		m_vEntries.push_back(Entry);
+		Index = m_vEntries.size() - 1;
+	}
+	CEntry *pEntry = &m_vEntries[Index];
+	if(pEntry->m_WindowEnd <= Now)
+	{
+		pEntry->m_WindowEnd = Now + FAILURE_WINDOW * time_freq();
+		pEntry->m_NumFailures = 0;
+	}
+	pEntry->m_NumFailures++;
+}
+
+void CLoginThrottle::Prune(int64_t Now)
+{
+	m_vEntries.erase(std::remove_if(m_vEntries.begin(), m_vEntries.end(), [Now](const CEntry &Entry) {
+		return Entry.m_WindowEnd <= Now;
+	}),
+		m_vEntries.end());
+}
@@ -0,0 +1,45 @@
+#ifndef ENGINE_SERVER_LOGIN_THROTTLE_H
+#define ENGINE_SERVER_LOGIN_THROTTLE_H
+
+#include <base/system.h>
+
+#include <vector>
+
+/*
+	Failed login attempts per address. After MAX_FAILURES failures within
+	FAILURE_WINDOW seconds the address is blocked until the window of its
+	first failure ended. A successful login doesn't reset the failures,
+	otherwise logging into an own account between guesses would avoid the
+	block. Only used from the game thread.
+*/
+class CLoginThrottle
+{
+public:
+	enum
+	{
+		MAX_FAILURES = 5,
+		FAILURE_WINDOW = 60, // seconds
+	};
+
+	// returns the remaining seconds of the block, 0 if the address may try to log in
+	int BlockedFor(const NETADDR *pAddr, int64_t Now) const;
+	void OnFailure(const NETADDR *pAddr, int64_t Now);
+	// forgets addresses whose window ended
+	void Prune(int64_t Now);
+
+private:
+	class CEntry
+	{
+	public:
+		NETADDR m_Addr;
+		int64_t m_WindowEnd;
+		int m_NumFailures;
+	};
+
+	// returns -1 if the address has no failures
+	int Find(const NETADDR *pAddr) const;
+
+	std::vector<CEntry> m_vEntries;
+};
+
+#endif // ENGINE_SERVER_LOGIN_THROTTLE_H
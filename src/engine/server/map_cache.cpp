@@ -0,0 +1,135 @@
+#include "map_cache.h"
+
+#include <engine/console.h>
+#include <engine/storage.h>
+
+#include <engine/server/mapconverter.h>
+#include <engine/shared/datafile.h>
+
+bool CClientMap::Generate(IStorage *pStorage, IConsole *pConsole, IEngineMap *pMap, bool ForceRegeneration)
+{
+	m_ServerMapCrc = pMap->Crc();
+
+	char aClientMapDir[256];
+	char aClientMapName[256];
+	str_format(aClientMapDir, sizeof(aClientMapDir), "clientmaps/%s", m_aConverterId);
+	str_format(aClientMapName, sizeof(aClientMapName), "%s/%s_%08x.map", aClientMapDir, m_aName, m_ServerMapCrc);
+
+	CMapConverter MapConverter(pStorage, pMap, pConsole);
+	if(!MapConverter.Load())
+		return false;
+
+	m_TimeShiftUnit = MapConverter.GetTimeShiftUnit();
+
+	CDataFileReader dfClientMap;
+	//First, try to find if the client map is already generated
+	if(!ForceRegeneration && dfClientMap.Open(pStorage, aClientMapName, IStorage::TYPE_ALL))
+	{
+		m_Crc = dfClientMap.Crc();
+		m_Sha256 = dfClientMap.Sha256();
+		dfClientMap.Close();
+	}
+	//The map must be converted
+	else
+	{
+		char aFullPath[512];
+		pStorage->GetCompletePath(IStorage::TYPE_SAVE, aClientMapDir, aFullPath, sizeof(aFullPath));
+		if(fs_makedir_rec_for(aFullPath) != 0 || fs_makedir(aFullPath) != 0)
+		{
+			dbg_msg("infclass", "Can't create the directory '%s'", aClientMapDir);
+		}
+
+		if(!MapConverter.CreateMap(aClientMapName))
+			return false;
+
+		CDataFileReader dfGeneratedMap;
+		dfGeneratedMap.Open(pStorage, aClientMapName, IStorage::TYPE_ALL);
+		m_Crc = dfGeneratedMap.Crc();
+		m_Sha256 = dfGeneratedMap.Sha256();
+		dfGeneratedMap.Close();
+	}
+
+	// load complete map into memory for download
+	void *pData;
+	if(!pStorage->ReadFile(aClientMapName, IStorage::TYPE_ALL, &pData, &m_DataSize))
+		return false;
+	m_pData = (unsigned char *)pData;
+	return true;
+}
+
+bool CMapCache::MapFileModified(IStorage *pStorage, const char *pMapFilePath, time_t *pModified)
+{
+	char aFullPath[IO_MAX_PATH_LENGTH];
+	IOHANDLE File = pStorage->OpenFile(pMapFilePath, IOFLAG_READ, IStorage::TYPE_ALL, aFullPath, sizeof(aFullPath));
+	if(!File)
+		return false;
+	io_close(File);
+
+	time_t Created;
+	return fs_file_time(aFullPath, &Created, pModified) == 0;
+}
+
+std::unique_ptr<CPreparedMap> CMapCache::Take(const char *pMapFilePath, const char *pConverterId, time_t Modified)
+{
+	for(auto It = m_lpMaps.begin(); It != m_lpMaps.end(); ++It)
+	{
+		if(!(*It)->Matches(pMapFilePath, pConverterId))
+			continue;
+
+		std::unique_ptr<CPreparedMap> pMap = std::move(*It);
+		m_lpMaps.erase(It);
+		m_MemoryUsage -= pMap->m_MemoryUsage;
+		// the map file was replaced since
+		if(pMap->m_Modified != Modified)
+			break;
+
+		m_Hits++;
+		return pMap;
+	}
+
+	m_Misses++;
+	return nullptr;
+}
+
+bool CMapCache::Contains(const char *pMapFilePath, const char *pConverterId) const
+{
+	for(const auto &pMap : m_lpMaps)
+	{
+		if(pMap->Matches(pMapFilePath, pConverterId))
+			return true;
+	}
+	return false;
+}
+
+void CMapCache::Add(std::unique_ptr<CPreparedMap> pMap, size_t Budget)
+{
+	for(auto It = m_lpMaps.begin(); It != m_lpMaps.end(); ++It)
+	{
+		if((*It)->Matches(pMap->m_aMapFilePath, pMap->m_ClientMap.m_aConverterId))
+		{
+			m_MemoryUsage -= (*It)->m_MemoryUsage;
+			m_lpMaps.erase(It);
+			break;
+		}
+	}
+
+	pMap->m_MemoryUsage = pMap->m_Map.MemoryUsage() + pMap->m_ClientMap.m_DataSize;
+	m_MemoryUsage += pMap->m_MemoryUsage;
+	m_lpMaps.push_front(std::move(pMap));
+	Shrink(Budget);
+}
+
+void CMapCache::Shrink(size_t Budget)
+{
+	while(!m_lpMaps.empty() && m_MemoryUsage > Budget)
+	{
+		m_MemoryUsage -= m_lpMaps.back()->m_MemoryUsage;
+		m_lpMaps.pop_back();
+	}
+}
+
+void CMapCache::Clear()
+{
+	m_lpMaps.clear();
+	m_MemoryUsage = 0;
+}
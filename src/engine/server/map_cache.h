@@ -0,0 +1,89 @@
+#ifndef ENGINE_SERVER_MAP_CACHE_H
+#define ENGINE_SERVER_MAP_CACHE_H
+
+#include <base/hash.h>
+#include <base/system.h>
+#include <engine/shared/map.h>
+
+#include <ctime>
+#include <list>
+#include <memory>
+
+class IConsole;
+class IStorage;
+
+// The map format of InfectionClass is different from the vanilla format.
+// A client map is the converted map the clients download.
+class CClientMap
+{
+public:
+	char m_aName[IO_MAX_PATH_LENGTH];
+	char m_aConverterId[64];
+	unsigned m_ServerMapCrc = 0;
+	unsigned m_Crc = 0;
+	SHA256_DIGEST m_Sha256;
+	unsigned char *m_pData = nullptr;
+	unsigned m_DataSize = 0;
+	int m_TimeShiftUnit = 0;
+
+	CClientMap(const char *pMapName, const char *pConverterId)
+	{
+		str_copy(m_aName, pMapName);
+		str_copy(m_aConverterId, pConverterId);
+	}
+	~CClientMap() { free(m_pData); }
+
+	bool Generate(IStorage *pStorage, IConsole *pConsole, IEngineMap *pMap, bool ForceRegeneration);
+};
+
+// A loaded server map together with its client map, ready to be switched to.
+class CPreparedMap
+{
+public:
+	char m_aMapFilePath[IO_MAX_PATH_LENGTH];
+	time_t m_Modified;
+	CMap m_Map;
+	CClientMap m_ClientMap;
+	bool m_Cacheable = true;
+	size_t m_MemoryUsage = 0;
+
+	CPreparedMap(const char *pMapFilePath, time_t Modified, const char *pMapName, const char *pConverterId) :
+		m_Modified(Modified),
+		m_ClientMap(pMapName, pConverterId)
+	{
+		str_copy(m_aMapFilePath, pMapFilePath);
+	}
+
+	bool Matches(const char *pMapFilePath, const char *pConverterId) const
+	{
+		return str_comp(m_aMapFilePath, pMapFilePath) == 0 && str_comp(m_ClientMap.m_aConverterId, pConverterId) == 0;
+	}
+};
+
+// Bounded LRU of recently played maps, so switching back to one of them
+// skips loading, decompressing and converting it again.
+class CMapCache
+{
+	std::list<std::unique_ptr<CPreparedMap>> m_lpMaps; // most recently used first
+	size_t m_MemoryUsage = 0;
+	int m_Hits = 0;
+	int m_Misses = 0;
+
+	void Shrink(size_t Budget);
+
+public:
+	static bool MapFileModified(IStorage *pStorage, const char *pMapFilePath, time_t *pModified);
+
+	// removes the map from the cache if it is there and still matches the file
+	std::unique_ptr<CPreparedMap> Take(const char *pMapFilePath, const char *pConverterId, time_t Modified);
+	bool Contains(const char *pMapFilePath, const char *pConverterId) const;
+	void Add(std::unique_ptr<CPreparedMap> pMap, size_t Budget);
+	void Clear();
+
+	const std::list<std::unique_ptr<CPreparedMap>> &Maps() const { return m_lpMaps; }
+	size_t MemoryUsage() const { return m_MemoryUsage; }
+	int Hits() const { return m_Hits; }
+	int Misses() const { return m_Misses; }
+};
+
+#endif
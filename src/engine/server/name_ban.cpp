@@ -1,21 +1,174 @@
 #include "name_ban.h"
 
-CNameBan *IsNameBanned(const char *pName, std::vector<CNameBan> &vNameBans)
+#include <base/math.h>
+
+#include <algorithm>
+#include <bit>
+
+static uint64_t SkeletonMask(const int *pSkeleton, int Length)
+{
+	uint64_t Mask = 0;
+	for(int i = 0; i < Length; i++)
+		Mask |= (uint64_t)1 << ((unsigned)pSkeleton[i] * 2654435761u >> 26);
+	return Mask;
+}
+
+// Lower bound of the edit distance: each character set bit missing on one
+// side needs at least one edit.
+static int MaskDistance(uint64_t MaskA, uint64_t MaskB)
+{
+	return maximum(std::popcount(MaskA & ~MaskB), std::popcount(MaskB & ~MaskA));
+}
+
+CNameBan::CNameBan(const char *pName, int Distance, int IsSubstring, const char *pReason) :
+	m_Distance(Distance), m_IsSubstring(IsSubstring)
+{
+	str_copy(m_aName, pName);
+	m_SkeletonLength = str_utf8_to_skeleton(m_aName, m_aSkeleton, std::size(m_aSkeleton));
+	std::copy(m_aSkeleton, m_aSkeleton + m_SkeletonLength, m_aSortedSkeleton);
+	std::sort(m_aSortedSkeleton, m_aSortedSkeleton + m_SkeletonLength);
+	m_SkeletonMask = SkeletonMask(m_aSkeleton, m_SkeletonLength);
+	str_copy(m_aReason, pReason);
+}
+
+// Lower bound of the edit distance: every edit changes the character
+// counts of the two strings by at most two.
+static int CountDistance(const int *pA, int LengthA, const int *pB, int LengthB)
 {
+	int Diff = 0;
+	int i = 0, j = 0;
+	while(i < LengthA && j < LengthB)
+	{
+		if(pA[i] == pB[j])
+		{
+			i++;
+			j++;
+		}
+		else if(pA[i] < pB[j])
+		{
+			i++;
+			Diff++;
+		}
+		else
+		{
+			j++;
+			Diff++;
+		}
+	}
+	Diff += (LengthA - i) + (LengthB - j);
+	return (Diff + 1) / 2;
+}
+
+void CNameBans::IndexBan(int Ban)
+{
+	const CNameBan &NameBan = m_vNameBans[Ban];
+	m_avLengthBuckets[NameBan.m_SkeletonLength].push_back({Ban, NameBan.m_Distance, NameBan.m_SkeletonMask});
+	if(NameBan.m_IsSubstring == 1)
+		m_vSubstringBans.push_back(Ban);
+	m_MaxDistance = maximum(m_MaxDistance, NameBan.m_Distance);
+}
+
+void CNameBans::RebuildIndex()
+{
+	for(auto &vBucket : m_avLengthBuckets)
+		vBucket.clear();
+	m_vSubstringBans.clear();
+	m_MaxDistance = -1;
+
+	for(int i = 0; i < (int)m_vNameBans.size(); i++)
+		IndexBan(i);
+}
+
+const CNameBan *CNameBans::Find(const char *pName) const
+{
+	for(const CNameBan &Ban : m_vNameBans)
+	{
+		if(str_comp(Ban.m_aName, pName) == 0)
+			return &Ban;
+	}
+	return nullptr;
+}
+
+void CNameBans::Set(const char *pName, int Distance, int IsSubstring, const char *pReason)
+{
+	for(CNameBan &Ban : m_vNameBans)
+	{
+		if(str_comp(Ban.m_aName, pName) == 0)
+		{
+			Ban.m_Distance = Distance;
+			Ban.m_IsSubstring = IsSubstring;
+			str_copy(Ban.m_aReason, pReason);
+			RebuildIndex();
+			return;
+		}
+	}
+
+	m_vNameBans.emplace_back(pName, Distance, IsSubstring, pReason);
+	IndexBan(m_vNameBans.size() - 1);
+}
+
+bool CNameBans::Remove(const char *pName)
+{
+	auto It = std::find_if(m_vNameBans.begin(), m_vNameBans.end(), [pName](const CNameBan &Ban) {
+		return str_comp(Ban.m_aName, pName) == 0;
+	});
+	if(It == m_vNameBans.end())
+		return false;
+
+	m_vNameBans.erase(It);
+	RebuildIndex();
+	return true;
+}
+
+const CNameBan *CNameBans::IsBanned(const char *pName) const
+{
+	if(m_vNameBans.empty())
+		return nullptr;
+
 	char aTrimmed[MAX_NAME_LENGTH];
 	str_copy(aTrimmed, str_utf8_skip_whitespaces(pName));
 	str_utf8_trim_right(aTrimmed);
 
 	int aSkeleton[MAX_NAME_SKELETON_LENGTH];
 	int SkeletonLength = str_utf8_to_skeleton(aTrimmed, aSkeleton, std::size(aSkeleton));
+	int aSortedSkeleton[MAX_NAME_SKELETON_LENGTH];
+	std::copy(aSkeleton, aSkeleton + SkeletonLength, aSortedSkeleton);
+	std::sort(aSortedSkeleton, aSortedSkeleton + SkeletonLength);
+	const uint64_t Mask = SkeletonMask(aSkeleton, SkeletonLength);
 	int aBuffer[MAX_NAME_SKELETON_LENGTH * 2 + 2];
 
-	CNameBan *pResult = nullptr;
-	for(CNameBan &Ban : vNameBans)
+	// later bans take precedence, so only look for matches after the best one so far
+	int Best = -1;
+	for(auto It = m_vSubstringBans.rbegin(); It != m_vSubstringBans.rend(); ++It)
 	{
-		int Distance = str_utf32_dist_buffer(aSkeleton, SkeletonLength, Ban.m_aSkeleton, Ban.m_SkeletonLength, aBuffer, std::size(aBuffer));
-		if(Distance <= Ban.m_Distance || (Ban.m_IsSubstring == 1 && str_utf8_find_nocase(pName, Ban.m_aName)))
-			pResult = &Ban;
+		if(str_utf8_find_nocase(pName, m_vNameBans[*It].m_aName))
+		{
+			Best = *It;
+			break;
+		}
 	}
-	return pResult;
+
+	const int MinLength = maximum(0, SkeletonLength - m_MaxDistance);
+	const int MaxLength = minimum((int)MAX_NAME_SKELETON_LENGTH, SkeletonLength + m_MaxDistance);
+	for(int Length = MinLength; Length <= MaxLength; Length++)
+	{
+		const std::vector<CIndexEntry> &vBucket = m_avLengthBuckets[Length];
+		for(auto It = vBucket.rbegin(); It != vBucket.rend() && It->m_Ban > Best; ++It)
+		{
+			if(absolute(Length - SkeletonLength) > It->m_Distance)
+				continue;
+			if(MaskDistance(Mask, It->m_SkeletonMask) > It->m_Distance)
+				continue;
+			const CNameBan &Ban = m_vNameBans[It->m_Ban];
+			if(CountDistance(aSortedSkeleton, SkeletonLength, Ban.m_aSortedSkeleton, Ban.m_SkeletonLength) > Ban.m_Distance)
+				continue;
+			if(str_utf32_dist_buffer(aSkeleton, SkeletonLength, Ban.m_aSkeleton, Ban.m_SkeletonLength, aBuffer, std::size(aBuffer)) <= Ban.m_Distance)
+			{
+				Best = It->m_Ban;
+				break;
+			}
+		}
+	}
+
+	return Best >= 0 ? &m_vNameBans[Best] : nullptr;
 }
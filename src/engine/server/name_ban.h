@@ -16,21 +16,52 @@ class CNameBan
 {
 public:
 	CNameBan() {}
-	CNameBan(const char *pName, int Distance, int IsSubstring, const char *pReason = "") :
-		m_Distance(Distance), m_IsSubstring(IsSubstring)
-	{
-		str_copy(m_aName, pName);
-		m_SkeletonLength = str_utf8_to_skeleton(m_aName, m_aSkeleton, std::size(m_aSkeleton));
-		str_copy(m_aReason, pReason);
-	}
+	CNameBan(const char *pName, int Distance, int IsSubstring, const char *pReason = "");
+
 	char m_aName[MAX_NAME_LENGTH];
 	char m_aReason[MAX_NAMEBAN_REASON_LENGTH];
 	int m_aSkeleton[MAX_NAME_SKELETON_LENGTH];
+	int m_aSortedSkeleton[MAX_NAME_SKELETON_LENGTH]; // for the character count prefilter
+	uint64_t m_SkeletonMask; // set of hashed skeleton characters
 	int m_SkeletonLength;
 	int m_Distance;
 	int m_IsSubstring;
 };
 
-CNameBan *IsNameBanned(const char *pName, std::vector<CNameBan> &vNameBans);
+/*
+	Name bans indexed by skeleton length. A lookup only runs the edit
+	distance on bans whose length and character counts are within the ban's
+	distance, and only tests substring bans with a substring search.
+*/
+class CNameBans
+{
+	std::vector<CNameBan> m_vNameBans;
+
+	// compact copy of what the prefilters need, so rejected bans are never touched
+	struct CIndexEntry
+	{
+		int m_Ban; // index into m_vNameBans
+		int m_Distance;
+		uint64_t m_SkeletonMask;
+	};
+	// ascending ban indices per skeleton length
+	std::vector<CIndexEntry> m_avLengthBuckets[MAX_NAME_SKELETON_LENGTH + 1];
+	std::vector<int> m_vSubstringBans;
+	int m_MaxDistance = -1;
+
+	void IndexBan(int Ban);
+	void RebuildIndex();
+
+public:
+	const std::vector<CNameBan> &Bans() const { return m_vNameBans; }
+	const CNameBan *Find(const char *pName) const;
+
+	// adds a ban or changes the one with the same name
+	void Set(const char *pName, int Distance, int IsSubstring, const char *pReason);
+	bool Remove(const char *pName);
+
+	// returns the most recently added ban matching the name, as a linear scan would
+	const CNameBan *IsBanned(const char *pName) const;
+};
 
 #endif // ENGINE_SERVER_NAME_BAN_H
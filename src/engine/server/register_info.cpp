@@ -0,0 +1,76 @@
+#include "register_info.h"
+
+#include <base/system.h>
+#include <engine/shared/json.h>
+
+CRegisterServerInfo::CRegisterServerInfo()
+{
+	m_Info.reserve(16384);
+}
+
+void CRegisterServerInfo::Start(const char *pServerFields)
+{
+	m_Info.assign(pServerFields);
+	m_FirstClient = true;
+}
+
+bool CRegisterServerInfo::Matches(const CFragment &Fragment, const CClientInfo &Info)
+{
+	return Fragment.m_Valid &&
+	       Fragment.m_Score == Info.m_Score &&
+	       Fragment.m_Country == Info.m_Country &&
+	       Fragment.m_IsPlayer == Info.m_IsPlayer &&
+	       str_comp(Fragment.m_aName, Info.m_pName) == 0 &&
+	       str_comp(Fragment.m_aClan, Info.m_pClan) == 0 &&
+	       Fragment.m_Extra == Info.m_pExtra;
+}
+
+void CRegisterServerInfo::Rebuild(CFragment *pFragment, const CClientInfo &Info)
+{
+	pFragment->m_Valid = true;
+	str_copy(pFragment->m_aName, Info.m_pName);
+	str_copy(pFragment->m_aClan, Info.m_pClan);
+	pFragment->m_Country = Info.m_Country;
+	pFragment->m_Score = Info.m_Score;
+	pFragment->m_IsPlayer = Info.m_IsPlayer;
+	pFragment->m_Extra.assign(Info.m_pExtra);
+
+	char aCName[32];
+	char aCClan[32];
+	char aClientInfo[1024];
+	str_format(aClientInfo, sizeof(aClientInfo),
+		"{"
+		"\"name\":\"%s\","
+		"\"clan\":\"%s\","
+		"\"country\":%d,"
+		"\"score\":%d,"
+		"\"is_player\":%s"
+		"%s"
+		"}",
+		EscapeJson(aCName, sizeof(aCName), Info.m_pName),
+		EscapeJson(aCClan, sizeof(aCClan), Info.m_pClan),
+		Info.m_Country,
+		Info.m_Score,
+		JsonBool(Info.m_IsPlayer),
+		Info.m_pExtra);
+	pFragment->m_Json.assign(aClientInfo);
+	m_NumRebuilt++;
+}
+
+void CRegisterServerInfo::AddClient(int ClientId, const CClientInfo &Info)
+{
+	CFragment *pFragment = &m_aFragments[ClientId];
+	if(!Matches(*pFragment, Info))
+		Rebuild(pFragment, Info);
+
+	if(!m_FirstClient)
+		m_Info += ',';
+	m_Info += pFragment->m_Json;
+	m_FirstClient = false;
+}
+
+const char *CRegisterServerInfo::Finish()
+{
+	m_Info += "]}";
+	return m_Info.c_str();
+}
@@ -0,0 +1,63 @@
+#ifndef ENGINE_SERVER_REGISTER_INFO_H
+#define ENGINE_SERVER_REGISTER_INFO_H
+
+#include <engine/shared/protocol.h>
+
+#include <string>
+
+/*
+	JSON server info sent to the masters. The fragment of every client is
+	kept with the fields it was made of, only clients whose fields changed
+	are escaped and formatted again. The info is assembled in a buffer that
+	keeps its capacity between updates.
+*/
+class CRegisterServerInfo
+{
+public:
+	class CClientInfo
+	{
+	public:
+		const char *m_pName;
+		const char *m_pClan;
+		int m_Country;
+		int m_Score;
+		bool m_IsPlayer;
+		// already formatted JSON members, prefixed by a comma
+		const char *m_pExtra;
+	};
+
+	CRegisterServerInfo();
+
+	// starts the info with the formatted server fields, up to `"clients":[`
+	void Start(const char *pServerFields);
+	void AddClient(int ClientId, const CClientInfo &Info);
+	// valid until the next Start
+	const char *Finish();
+
+	// client fragments formatted again since the start of the server
+	int64_t NumRebuilt() const { return m_NumRebuilt; }
+
+private:
+	class CFragment
+	{
+	public:
+		bool m_Valid = false;
+		char m_aName[MAX_NAME_LENGTH];
+		char m_aClan[MAX_CLAN_LENGTH];
+		int m_Country;
+		int m_Score;
+		bool m_IsPlayer;
+		std::string m_Extra;
+		std::string m_Json;
+	};
+
+	static bool Matches(const CFragment &Fragment, const CClientInfo &Info);
+	void Rebuild(CFragment *pFragment, const CClientInfo &Info);
+
+	CFragment m_aFragments[MAX_CLIENTS];
+	std::string m_Info;
+	bool m_FirstClient = true;
+	int64_t m_NumRebuilt = 0;
+};
+
+#endif // ENGINE_SERVER_REGISTER_INFO_H
@@ -210,3 +210,53 @@ bool CRoundStatistics::IsValidePlayer(int ClientId)
 	else
 		return false;
 }
+
+static const struct
+{
+	int m_ScoreType;
+	const char *m_pName;
+} s_aRoundScoreTypes[] = {
+	{ROUNDSCORE_TYPE_ROUND, "Player"},
+	{ROUNDSCORE_TYPE_ENGINEER, "Engineer"},
+	{ROUNDSCORE_TYPE_SOLDIER, "Soldier"},
+	{ROUNDSCORE_TYPE_SCIENTIST, "Scientist"},
+	{ROUNDSCORE_TYPE_BIOLOGIST, "Biologist"},
+	{ROUNDSCORE_TYPE_LOOPER, "Looper"},
+	{ROUNDSCORE_TYPE_MEDIC, "Medic"},
+	{ROUNDSCORE_TYPE_HERO, "Hero"},
+	{ROUNDSCORE_TYPE_NINJA, "Ninja"},
+	{ROUNDSCORE_TYPE_MERCENARY, "Mercenary"},
+	{ROUNDSCORE_TYPE_SNIPER, "Sniper"},
+	{ROUNDSCORE_TYPE_SMOKER, "Smoker"},
+	{ROUNDSCORE_TYPE_HUNTER, "Hunter"},
+	{ROUNDSCORE_TYPE_BAT, "Bat"},
+	{ROUNDSCORE_TYPE_BOOMER, "Boomer"},
+	{ROUNDSCORE_TYPE_GHOST, "Ghost"},
+	{ROUNDSCORE_TYPE_SPIDER, "Spider"},
+	{ROUNDSCORE_TYPE_GHOUL, "Ghoul"},
+	{ROUNDSCORE_TYPE_SLUG, "Slug"},
+	{ROUNDSCORE_TYPE_VOODOO, "Voodoo"},
+	{ROUNDSCORE_TYPE_UNDEAD, "Undead"},
+	{ROUNDSCORE_TYPE_WITCH, "Witch"},
+};
+
+int RoundScoreTypeFromClassName(const char *pClassName)
+{
+	// the round score has no class name
+	for(const auto &Type : s_aRoundScoreTypes)
+	{
+		if(Type.m_ScoreType != ROUNDSCORE_TYPE_ROUND && str_comp_nocase(Type.m_pName, pClassName) == 0)
+			return Type.m_ScoreType;
+	}
+	return -1;
+}
+
+const char *RoundScoreTypeName(int ScoreType)
+{
+	for(const auto &Type : s_aRoundScoreTypes)
+	{
+		if(Type.m_ScoreType == ScoreType)
+			return Type.m_pName;
+	}
+	return "";
+}
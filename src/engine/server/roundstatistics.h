@@ -25,6 +25,39 @@ enum
 	SCOREEVENT_MEDIC_REVIVE,
 };
 
+enum
+{
+	// score types stored in the database, never change these values
+	ROUNDSCORE_TYPE_ROUND = 0,
+
+	ROUNDSCORE_TYPE_ENGINEER = 100,
+	ROUNDSCORE_TYPE_SOLDIER = 101,
+	ROUNDSCORE_TYPE_SCIENTIST = 102,
+	ROUNDSCORE_TYPE_MEDIC = 103,
+	ROUNDSCORE_TYPE_NINJA = 104,
+	ROUNDSCORE_TYPE_MERCENARY = 105,
+	ROUNDSCORE_TYPE_SNIPER = 106,
+	ROUNDSCORE_TYPE_HERO = 107,
+	ROUNDSCORE_TYPE_BIOLOGIST = 108,
+	ROUNDSCORE_TYPE_LOOPER = 109,
+
+	ROUNDSCORE_TYPE_SMOKER = 200,
+	ROUNDSCORE_TYPE_HUNTER = 201,
+	ROUNDSCORE_TYPE_BOOMER = 202,
+	ROUNDSCORE_TYPE_GHOST = 203,
+	ROUNDSCORE_TYPE_SPIDER = 204,
+	ROUNDSCORE_TYPE_UNDEAD = 205,
+	ROUNDSCORE_TYPE_WITCH = 206,
+	ROUNDSCORE_TYPE_GHOUL = 207,
+	ROUNDSCORE_TYPE_SLUG = 208,
+	ROUNDSCORE_TYPE_BAT = 209,
+	ROUNDSCORE_TYPE_VOODOO = 210,
+};
+
+// returns -1 for unknown class names
+int RoundScoreTypeFromClassName(const char *pClassName);
+const char *RoundScoreTypeName(int ScoreType);
+
 class CRoundStatistics
 {
 public:
@@ -0,0 +1,239 @@
+#include "roundstatistics_worker.h"
+
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/server/databases/connection.h>
+
+#include <string>
+
+// keeps the bound parameters of one INSERT below the SQLite default of 999
+static const int s_MaxRowsPerInsert = 150;
+
+void CSqlRoundStatsData::AddPlayer(const char *pName, const CRoundStatistics::CPlayerStats *pStats)
+{
+	const struct
+	{
+		int m_ScoreType;
+		int m_Score;
+	} aScores[] = {
+		{ROUNDSCORE_TYPE_ROUND, pStats->m_Score},
+
+		{ROUNDSCORE_TYPE_ENGINEER, pStats->m_EngineerScore},
+		{ROUNDSCORE_TYPE_SOLDIER, pStats->m_SoldierScore},
+		{ROUNDSCORE_TYPE_SCIENTIST, pStats->m_ScientistScore},
+		{ROUNDSCORE_TYPE_BIOLOGIST, pStats->m_BiologistScore},
+		{ROUNDSCORE_TYPE_LOOPER, pStats->m_LooperScore},
+		{ROUNDSCORE_TYPE_MEDIC, pStats->m_MedicScore},
+		{ROUNDSCORE_TYPE_HERO, pStats->m_HeroScore},
+		{ROUNDSCORE_TYPE_NINJA, pStats->m_NinjaScore},
+		{ROUNDSCORE_TYPE_MERCENARY, pStats->m_MercenaryScore},
+		{ROUNDSCORE_TYPE_SNIPER, pStats->m_SniperScore},
+
+		{ROUNDSCORE_TYPE_SMOKER, pStats->m_SmokerScore},
+		{ROUNDSCORE_TYPE_HUNTER, pStats->m_HunterScore},
+		{ROUNDSCORE_TYPE_BAT, pStats->m_BatScore},
+		{ROUNDSCORE_TYPE_BOOMER, pStats->m_BoomerScore},
+		{ROUNDSCORE_TYPE_GHOST, pStats->m_GhostScore},
+		{ROUNDSCORE_TYPE_SPIDER, pStats->m_SpiderScore},
+		{ROUNDSCORE_TYPE_GHOUL, pStats->m_GhoulScore},
+		{ROUNDSCORE_TYPE_SLUG, pStats->m_SlugScore},
+		{ROUNDSCORE_TYPE_VOODOO, pStats->m_VoodooScore},
+		{ROUNDSCORE_TYPE_UNDEAD, pStats->m_UndeadScore},
+		{ROUNDSCORE_TYPE_WITCH, pStats->m_WitchScore},
+	};
+
+	for(const auto &Score : aScores)
+	{
+		if(Score.m_Score <= 0 || m_NumScores >= (int)std::size(m_aScores))
+			continue;
+
+		CScore *pScore = &m_aScores[m_NumScores++];
+		str_copy(pScore->m_aName, pName);
+		pScore->m_ScoreType = Score.m_ScoreType;
+		pScore->m_Score = Score.m_Score;
+		pScore->m_Won = pStats->m_Won;
+	}
+}
+
+static bool InsertRoundStats(IDbConnection *pSqlServer, const CSqlRoundStatsData *pData, const char *pSuffix, char *pError, int ErrorSize)
+{
+	char aBuf[512];
+	str_format(aBuf, sizeof(aBuf),
+		"INSERT INTO %s_infc_rounds%s("
+		"  RoundId, Map, Timestamp, Duration, NumPlayersMin, NumPlayersMax, NumWinners"
+		") VALUES (?, ?, %s, ?, ?, ?, ?)",
+		pSqlServer->GetPrefix(), pSuffix, pSqlServer->InsertTimestampAsUtc());
+	if(pSqlServer->PrepareStatement(aBuf, pError, ErrorSize))
+	{
+		return true;
+	}
+	pSqlServer->BindString(1, pData->m_aRoundId);
+	pSqlServer->BindString(2, pData->m_aMap);
+	pSqlServer->BindString(3, pData->m_aTimestamp);
+	pSqlServer->BindInt(4, pData->m_Duration);
+	pSqlServer->BindInt(5, pData->m_NumPlayersMin);
+	pSqlServer->BindInt(6, pData->m_NumPlayersMax);
+	pSqlServer->BindInt(7, pData->m_NumWinners);
+	pSqlServer->Print();
+	int NumInserted;
+	if(pSqlServer->ExecuteUpdate(&NumInserted, pError, ErrorSize))
+	{
+		return true;
+	}
+
+	// one multi-row insert for all players instead of a round trip per score
+	for(int First = 0; First < pData->m_NumScores; First += s_MaxRowsPerInsert)
+	{
+		const int NumRows = minimum(pData->m_NumScores - First, s_MaxRowsPerInsert);
+		str_format(aBuf, sizeof(aBuf),
+			"INSERT INTO %s_infc_round_scores%s(RoundId, Name, ScoreType, Score, Won) VALUES ",
+			pSqlServer->GetPrefix(), pSuffix);
+		std::string Query = aBuf;
+		for(int i = 0; i < NumRows; i++)
+		{
+			Query += i == 0 ? "(?, ?, ?, ?, ?)" : ", (?, ?, ?, ?, ?)";
+		}
+		if(pSqlServer->PrepareStatement(Query.c_str(), pError, ErrorSize))
+		{
+			return true;
+		}
+		for(int i = 0; i < NumRows; i++)
+		{
+			const CSqlRoundStatsData::CScore *pScore = &pData->m_aScores[First + i];
+			pSqlServer->BindString(i * 5 + 1, pData->m_aRoundId);
+			pSqlServer->BindString(i * 5 + 2, pScore->m_aName);
+			pSqlServer->BindInt(i * 5 + 3, pScore->m_ScoreType);
+			pSqlServer->BindInt(i * 5 + 4, pScore->m_Score);
+			pSqlServer->BindInt(i * 5 + 5, pScore->m_Won);
+		}
+		if(pSqlServer->ExecuteUpdate(&NumInserted, pError, ErrorSize))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool ExecuteForRound(IDbConnection *pSqlServer, const char *pQuery, const char *pRoundId, char *pError, int ErrorSize)
+{
+	if(pSqlServer->PrepareStatement(pQuery, pError, ErrorSize))
+	{
+		return true;
+	}
+	pSqlServer->BindString(1, pRoundId);
+	pSqlServer->Print();
+	int NumUpdated;
+	return pSqlServer->ExecuteUpdate(&NumUpdated, pError, ErrorSize);
+}
+
+static bool RemoveRoundStatsBackup(IDbConnection *pSqlServer, const CSqlRoundStatsData *pData, bool MoveToNormal, char *pError, int ErrorSize)
+{
+	const char *apTables[] = {"infc_rounds", "infc_round_scores"};
+	char aBuf[512];
+	for(const char *pTable : apTables)
+	{
+		if(MoveToNormal)
+		{
+			str_format(aBuf, sizeof(aBuf),
+				"INSERT INTO %s_%s SELECT * FROM %s_%s_backup WHERE RoundId = ?",
+				pSqlServer->GetPrefix(), pTable, pSqlServer->GetPrefix(), pTable);
+			if(ExecuteForRound(pSqlServer, aBuf, pData->m_aRoundId, pError, ErrorSize))
+			{
+				return true;
+			}
+		}
+		str_format(aBuf, sizeof(aBuf),
+			"DELETE FROM %s_%s_backup WHERE RoundId = ?",
+			pSqlServer->GetPrefix(), pTable);
+		if(ExecuteForRound(pSqlServer, aBuf, pData->m_aRoundId, pError, ErrorSize))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool CRoundStatsWorker::SaveRoundStats(IDbConnection *pSqlServer, const ISqlData *pGameData, Write w, char *pError, int ErrorSize)
+{
+	const auto *pData = dynamic_cast<const CSqlRoundStatsData *>(pGameData);
+
+	if(pSqlServer->BeginTransaction(pError, ErrorSize))
+	{
+		return true;
+	}
+
+	bool Failed;
+	switch(w)
+	{
+	case Write::BACKUP_FIRST:
+		Failed = InsertRoundStats(pSqlServer, pData, "_backup", pError, ErrorSize);
+		break;
+	case Write::NORMAL:
+		Failed = InsertRoundStats(pSqlServer, pData, "", pError, ErrorSize);
+		break;
+	case Write::NORMAL_SUCCEEDED:
+		Failed = RemoveRoundStatsBackup(pSqlServer, pData, false, pError, ErrorSize);
+		break;
+	case Write::NORMAL_FAILED:
+		// the remote database is unavailable, keep the stats in the local one
+		Failed = RemoveRoundStatsBackup(pSqlServer, pData, true, pError, ErrorSize);
+		break;
+	default:
+		dbg_assert(false, "unreachable");
+		return true;
+	}
+
+	if(Failed)
+	{
+		char aRollbackError[256];
+		if(pSqlServer->RollbackTransaction(aRollbackError, sizeof(aRollbackError)))
+		{
+			dbg_msg("sql", "failed to roll back round statistics: %s", aRollbackError);
+		}
+		return true;
+	}
+	return pSqlServer->CommitTransaction(pError, ErrorSize);
+}
+
+bool CRoundStatsWorker::LoadLeaderboard(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+{
+	const auto *pData = dynamic_cast<const CSqlLeaderboardRequest *>(pGameData);
+	auto *pResult = dynamic_cast<CLeaderboardResult *>(pGameData->m_pResult.get());
+	// another read server could have failed in the middle of the query
+	pResult->m_Leaderboard = CLeaderboard();
+	pResult->m_RoundIds.clear();
+
+	char aBuf[512];
+	str_format(aBuf, sizeof(aBuf),
+		"SELECT s.RoundId, s.Name, s.ScoreType, s.Score "
+		"FROM %s_infc_round_scores AS s "
+		"JOIN %s_infc_rounds AS r ON s.RoundId = r.RoundId "
+		"WHERE r.Map = ?",
+		pSqlServer->GetPrefix(), pSqlServer->GetPrefix());
+	if(pSqlServer->PrepareStatement(aBuf, pError, ErrorSize))
+	{
+		return true;
+	}
+	pSqlServer->BindString(1, pData->m_aMap);
+
+	bool End;
+	if(pSqlServer->Step(&End, pError, ErrorSize))
+	{
+		return true;
+	}
+	while(!End)
+	{
+		char aRoundId[UUID_MAXSTRSIZE];
+		char aName[MAX_NAME_LENGTH];
+		pSqlServer->GetString(1, aRoundId, sizeof(aRoundId));
+		pSqlServer->GetString(2, aName, sizeof(aName));
+		pResult->m_RoundIds.insert(aRoundId);
+		pResult->m_Leaderboard.AddRoundUnsorted(pSqlServer->GetInt(3), aName, pSqlServer->GetInt(4));
+		if(pSqlServer->Step(&End, pError, ErrorSize))
+		{
+			return true;
+		}
+	}
+	pResult->m_Leaderboard.Sort();
+	return false;
+}
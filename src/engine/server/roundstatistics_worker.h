@@ -0,0 +1,72 @@
+#ifndef ENGINE_SERVER_ROUNDSTATISTICS_WORKER_H
+#define ENGINE_SERVER_ROUNDSTATISTICS_WORKER_H
+
+#include <engine/server/databases/connection_pool.h>
+#include <engine/server/leaderboard.h>
+#include <engine/server/roundstatistics.h>
+#include <engine/shared/protocol.h>
+#include <engine/shared/uuid_manager.h>
+
+#include <string>
+#include <unordered_set>
+
+class IDbConnection;
+
+// Everything a finished round writes to the database, copied on the game
+// thread so the worker never touches CRoundStatistics.
+struct CSqlRoundStatsData : ISqlData
+{
+	CSqlRoundStatsData(std::shared_ptr<ISqlResult> pResult) :
+		ISqlData(std::move(pResult))
+	{
+	}
+
+	struct CScore
+	{
+		char m_aName[MAX_NAME_LENGTH];
+		int m_ScoreType;
+		int m_Score;
+		bool m_Won;
+	};
+
+	char m_aRoundId[UUID_MAXSTRSIZE];
+	char m_aMap[128];
+	char m_aTimestamp[32];
+	int m_Duration = 0;
+	int m_NumPlayersMin = 0;
+	int m_NumPlayersMax = 0;
+	int m_NumWinners = 0;
+
+	CScore m_aScores[MAX_CLIENTS * 22];
+	int m_NumScores = 0;
+
+	// adds a row for every positive score of the player
+	void AddPlayer(const char *pName, const CRoundStatistics::CPlayerStats *pStats);
+};
+
+struct CSqlLeaderboardRequest : ISqlData
+{
+	CSqlLeaderboardRequest(std::shared_ptr<ISqlResult> pResult) :
+		ISqlData(std::move(pResult))
+	{
+	}
+
+	char m_aMap[128];
+};
+
+struct CLeaderboardResult : ISqlResult
+{
+	CLeaderboard m_Leaderboard;
+	// the rounds already contained in m_Leaderboard
+	std::unordered_set<std::string> m_RoundIds;
+};
+
+struct CRoundStatsWorker
+{
+	// writes the round and the scores of all its players in one transaction
+	static bool SaveRoundStats(IDbConnection *pSqlServer, const ISqlData *pGameData, Write w, char *pError, int ErrorSize);
+	// reads all round scores of a map into a CLeaderboardResult
+	static bool LoadLeaderboard(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
+};
+
+#endif // ENGINE_SERVER_ROUNDSTATISTICS_WORKER_H
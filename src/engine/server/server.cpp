@@ -36,6 +36,7 @@
 #include <game/version.h>
 
 #include <engine/shared/linereader.h>
+#include <engine/shared/map.h>
 
 #include "server.h"
 
@@ -51,6 +52,7 @@
 #include "databases/connection.h"
 #include "databases/connection_pool.h"
 #include "register.h"
+#include "roundstatistics_worker.h"
 
 #include <cinttypes>
 
@@ -381,12 +383,61 @@ void CServer::CClient::Reset(bool ResetScore)
 }
 /* INFECTION MODIFICATION END *****************************************/
 
+class CClientMapJob : public IJob
+{
+	IStorage *m_pStorage;
+	IConsole *m_pConsole;
+	SEMAPHORE m_Done;
+
+	void Run() override
+	{
+		m_Success = m_pPreparedMap->m_Map.Load(m_pStorage, m_pPreparedMap->m_aMapFilePath) && m_pPreparedMap->m_ClientMap.Generate(m_pStorage, m_pConsole, &m_pPreparedMap->m_Map, m_ForceRegeneration);
+		sphore_signal(&m_Done);
+	}
+
+public:
+	char m_aMapName[IO_MAX_PATH_LENGTH];
+	char m_aConverterId[64];
+	std::unique_ptr<CPreparedMap> m_pPreparedMap;
+	bool m_ForceRegeneration;
+	bool m_Success = false;
+
+	CClientMapJob(IStorage *pStorage, IConsole *pConsole, const char *pMapFilePath, time_t Modified, const char *pMapName, const char *pConverterId, bool ForceRegeneration) :
+		m_pStorage(pStorage),
+		m_pConsole(pConsole),
+		m_pPreparedMap(std::make_unique<CPreparedMap>(pMapFilePath, Modified, pMapName, pConverterId)),
+		m_ForceRegeneration(ForceRegeneration)
+	{
+		sphore_init(&m_Done);
+		str_copy(m_aMapName, pMapName);
+		str_copy(m_aConverterId, pConverterId);
+		// converting a map takes long, lookups for connecting players go first
+		SetPriority(PRIORITY_BACKGROUND);
+	}
+
+	~CClientMapJob() override
+	{
+		sphore_destroy(&m_Done);
+	}
+
+	bool Matches(const char *pMapName, const char *pConverterId) const
+	{
+		return str_comp(m_aMapName, pMapName) == 0 && str_comp(m_aConverterId, pConverterId) == 0;
+	}
+
+	// blocks until Run finished, the results can be used right after
+	void Wait()
+	{
+		sphore_wait(&m_Done);
+	}
+};
+
 CServer::CServer()
 {
 	m_pConfig = &g_Config;
 	for(int i = 0; i < MAX_CLIENTS; i++)
-		m_aDemoRecorder[i] = CDemoRecorder(&m_SnapshotDelta, true);
-	m_aDemoRecorder[MAX_CLIENTS] = CDemoRecorder(&m_SnapshotDelta, false);
+		m_aDemoRecorder[i] = CDemoRecorder(&m_SnapshotDelta, true, &m_DemoWriter);
+	m_aDemoRecorder[MAX_CLIENTS] = CDemoRecorder(&m_SnapshotDelta, false, &m_DemoWriter);
 
 	m_TickSpeed = SERVER_TICK_SPEED;
 
@@ -428,6 +479,11 @@ CServer::CServer()
 
 CServer::~CServer()
 {
+	if(m_pClientMapJob)
+		m_pClientMapJob->Wait();
+
+	// owned by m_pCurrentMap
+	m_apCurrentMapData[MAP_TYPE_SIX] = nullptr;
 	for(auto &pCurrentMapData : m_apCurrentMapData)
 	{
 		free(pCurrentMapData);
@@ -475,7 +531,7 @@ bool CServer::SetClientNameImpl(int ClientId, const char *pNameRequest, bool Set
 	if(m_aClients[ClientId].m_State < CClient::STATE_READY)
 		return false;
 
-	CNameBan *pBanned = IsNameBanned(pNameRequest, m_vNameBans);
+	const CNameBan *pBanned = m_NameBans.IsBanned(pNameRequest);
 	if(pBanned)
 	{
 		if(m_aClients[ClientId].m_State == CClient::STATE_READY && Set)
@@ -1093,6 +1149,8 @@ void CServer::DoSnapshot()
 {
 	GameServer()->OnPreSnap();
 
+	m_DemoWriter.SetBackpressure(Config()->m_SvDemoBackpressure);
+
 	// create snapshot for demo recording
 	if(m_aDemoRecorder[MAX_CLIENTS].IsRecording())
 	{
@@ -1600,78 +1658,133 @@ static inline int MsgFromSixup(int Msg, bool System)
 	return Msg;
 }
 
-bool CServer::GenerateClientMap(const char *pMapFilePath, const char *pMapName)
+void CServer::PrepareMap(const char *pMapName)
 {
-	if(!m_pMap->Load(pMapFilePath))
-		return 0;
+	// event maps depend on the global EventsDirector state, those are always generated on load
+	if(!str_startswith(pMapName, "infc_") || Config()->m_InfEvent[0] || str_comp(pMapName, m_aCurrentMap) == 0)
+		return;
+
+	const char *pConverterId = Config()->m_InfConverterId;
+	const bool ForceRegeneration = Config()->m_InfConverterForceRegeneration;
+	if(m_pClientMapJob && m_pClientMapJob->Matches(pMapName, pConverterId))
+		return;
+
+	char aMapFilePath[IO_MAX_PATH_LENGTH];
+	str_format(aMapFilePath, sizeof(aMapFilePath), "maps/%s.map", pMapName);
+	time_t Modified;
+	if(!ForceRegeneration && m_MapCache.Contains(aMapFilePath, pConverterId))
+		return;
+	if(!CMapCache::MapFileModified(Storage(), aMapFilePath, &Modified))
+		return;
+
+	// one job at a time, so two jobs never write the same client map file
+	if(m_pClientMapJob && !m_pClientMapJob->Done())
+		return;
+	CacheClientMapJob();
+
+	m_pClientMapJob = std::make_shared<CClientMapJob>(Storage(), Console(), aMapFilePath, Modified, pMapName, pConverterId, ForceRegeneration);
+	Kernel()->RequestInterface<IEngine>()->AddJob(m_pClientMapJob);
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "preparing client map for %s", pMapName);
+	Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", aBuf);
+}
 
-	//The map format of InfectionClass is different from the vanilla format.
-	//We need to convert the map to something that the client can use
-	//First, try to find if the client map is already generated
+void CServer::CacheClientMapJob()
+{
+	// a mispredicted map is still good for a later switch
+	if(m_pClientMapJob && m_pClientMapJob->Done())
+	{
+		if(m_pClientMapJob->m_Success && !m_pClientMapJob->m_ForceRegeneration)
+			m_MapCache.Add(std::move(m_pClientMapJob->m_pPreparedMap), MapCacheBudget());
+		m_pClientMapJob = nullptr;
+	}
+}
+
+size_t CServer::MapCacheBudget() const
+{
+	return (size_t)Config()->m_SvMapCacheSize * 1024 * 1024;
+}
 
-	CDataFileReader dfServerMap;
-	dfServerMap.Open(Storage(), pMapFilePath, IStorage::TYPE_ALL);
-	unsigned ServerMapCrc = dfServerMap.Crc();
-	dfServerMap.Close();
+bool CServer::GenerateClientMap(const char *pMapFilePath, const char *pMapName)
+{
+	time_t Modified;
+	if(!CMapCache::MapFileModified(Storage(), pMapFilePath, &Modified))
+		return false;
 
 	EventsDirector::SetPreloadedMapName(pMapName);
 
-	char aClientMapDir[256];
-	char aClientMapName[256];
 	const char *pConverterId = Config()->m_InfConverterId;
 	pConverterId = EventsDirector::GetMapConverterId(pConverterId);
-	str_format(aClientMapDir, sizeof(aClientMapDir), "clientmaps/%s", pConverterId);
-	str_format(aClientMapName, sizeof(aClientMapName), "%s/%s_%08x.map", aClientMapDir, pMapName, ServerMapCrc);
+	const bool ForceRegeneration = Config()->m_InfConverterForceRegeneration;
+	// event maps depend on the global EventsDirector state, those are never cached
+	const bool Cacheable = !Config()->m_InfEvent[0] && !ForceRegeneration;
 
-	CMapConverter MapConverter(Storage(), m_pMap, Console());
-	if(!MapConverter.Load())
-		return false;
-
-	m_TimeShiftUnit = MapConverter.GetTimeShiftUnit();
+	std::unique_ptr<CPreparedMap> pPreparedMap;
+	if(Cacheable)
+		pPreparedMap = m_MapCache.Take(pMapFilePath, pConverterId, Modified);
 
-	CDataFileReader dfClientMap;
-	//The map is already converted
-	if(!Config()->m_InfConverterForceRegeneration && dfClientMap.Open(Storage(), aClientMapName, IStorage::TYPE_ALL))
+	if(pPreparedMap)
 	{
-		m_aCurrentMapCrc[MAP_TYPE_SIX] = dfClientMap.Crc();
-		m_aCurrentMapSha256[MAP_TYPE_SIX] = dfClientMap.Sha256();
-		dfClientMap.Close();
+		Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", "using the cached map");
 	}
-	//The map must be converted
-	else
+	else if(m_pClientMapJob && m_pClientMapJob->Matches(pMapName, pConverterId))
 	{
-		char aFullPath[512];
-		Storage()->GetCompletePath(IStorage::TYPE_SAVE, aClientMapDir, aFullPath, sizeof(aFullPath));
-		if(fs_makedir_rec_for(aFullPath) != 0 || fs_makedir(aFullPath) != 0)
+		// the job writes the same client map file, let it finish instead of racing it
+		std::shared_ptr<CClientMapJob> pJob = std::move(m_pClientMapJob);
+		// a background job may still wait behind other jobs, don't wait with it
+		if(!pJob->RunInline())
+			pJob->Wait();
+		if(pJob->m_Success && pJob->m_pPreparedMap->m_Modified == Modified && pJob->m_ForceRegeneration == ForceRegeneration)
 		{
-			dbg_msg("infclass", "Can't create the directory '%s'", aClientMapDir);
+			pPreparedMap = std::move(pJob->m_pPreparedMap);
+			Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", "using the prepared client map");
 		}
+	}
+	else
+	{
+		CacheClientMapJob();
+	}
 
-		if(!MapConverter.CreateMap(aClientMapName))
+	if(!pPreparedMap)
+	{
+		pPreparedMap = std::make_unique<CPreparedMap>(pMapFilePath, Modified, pMapName, pConverterId);
+		if(!pPreparedMap->m_Map.Load(Storage(), pMapFilePath))
+			return false;
+		// the converter reads every layer, decompress them all at once
+		pPreparedMap->m_Map.LoadAllData(Kernel()->RequestInterface<IEngine>());
+		if(!pPreparedMap->m_ClientMap.Generate(Storage(), Console(), &pPreparedMap->m_Map, ForceRegeneration))
 			return false;
+	}
+	pPreparedMap->m_Cacheable = Cacheable;
 
-		CDataFileReader dfGeneratedMap;
-		dfGeneratedMap.Open(Storage(), aClientMapName, IStorage::TYPE_ALL);
-		m_aCurrentMapCrc[MAP_TYPE_SIX] = dfGeneratedMap.Crc();
-		m_aCurrentMapSha256[MAP_TYPE_SIX] = dfGeneratedMap.Sha256();
-		dfGeneratedMap.Close();
+	// The engine map holds the file of the current map, put it back into
+	// the outgoing map and keep that one around for a later switch.
+	if(m_pCurrentMap)
+	{
+		m_pMap->Swap(&m_pCurrentMap->m_Map);
+		if(m_pCurrentMap->m_Cacheable)
+			m_MapCache.Add(std::move(m_pCurrentMap), MapCacheBudget());
 	}
+	m_pMap->Swap(&pPreparedMap->m_Map);
+	m_pCurrentMap = std::move(pPreparedMap);
+	const CClientMap *pClientMap = &m_pCurrentMap->m_ClientMap;
+
+	m_TimeShiftUnit = pClientMap->m_TimeShiftUnit;
+	m_aCurrentMapCrc[MAP_TYPE_SIX] = pClientMap->m_Crc;
+	m_aCurrentMapSha256[MAP_TYPE_SIX] = pClientMap->m_Sha256;
 
 	char aBufMsg[128];
 	char aSha256[SHA256_MAXSTRSIZE];
 	sha256_str(m_aCurrentMapSha256[MAP_TYPE_SIX], aSha256, sizeof(aSha256));
 	str_format(aBufMsg, sizeof(aBufMsg), "%s sha256 is %s", pMapName, aSha256);
 	Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", aBufMsg);
-	str_format(aBufMsg, sizeof(aBufMsg), "map crc is %08x, generated map crc is %08x", ServerMapCrc, m_aCurrentMapCrc[MAP_TYPE_SIX]);
+	str_format(aBufMsg, sizeof(aBufMsg), "map crc is %08x, generated map crc is %08x", pClientMap->m_ServerMapCrc, m_aCurrentMapCrc[MAP_TYPE_SIX]);
 	Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", aBufMsg);
 
-	// load complete map into memory for download
-	{
-		free(m_apCurrentMapData[MAP_TYPE_SIX]);
-		void *pData;
-		Storage()->ReadFile(aClientMapName, IStorage::TYPE_ALL, &pData, &m_aCurrentMapSize[MAP_TYPE_SIX]);
-		m_apCurrentMapData[MAP_TYPE_SIX] = (unsigned char *)pData;
-	}
+	// the download data belongs to m_pCurrentMap
+	m_apCurrentMapData[MAP_TYPE_SIX] = pClientMap->m_pData;
+	m_aCurrentMapSize[MAP_TYPE_SIX] = pClientMap->m_DataSize;
 
 	return true;
 }
@@ -2124,14 +2237,38 @@ CServer::CCache::~CCache()
 	Clear();
 }
 
-CServer::CCache::CCacheChunk::CCacheChunk(const void *pData, int Size)
+CServer::CCache::CCacheChunk::CCacheChunk(const void *pHeader, int HeaderSize, const void *pData, int Size)
 {
-	m_vData.assign((const uint8_t *)pData, (const uint8_t *)pData + Size);
+	m_vData.reserve(HeaderSize + Size);
+	m_vData.assign((const uint8_t *)pHeader, (const uint8_t *)pHeader + HeaderSize);
+	m_vData.insert(m_vData.end(), (const uint8_t *)pData, (const uint8_t *)pData + Size);
+	m_HeaderSize = HeaderSize;
 }
 
 void CServer::CCache::AddChunk(const void *pData, int Size)
 {
-	m_vCache.emplace_back(pData, Size);
+	m_vCache.emplace_back(nullptr, 0, pData, Size);
+}
+
+void CServer::CCache::AddChunk(const void *pHeader, int HeaderSize, const void *pData, int Size)
+{
+	m_vCache.emplace_back(pHeader, HeaderSize, pData, Size);
+}
+
+static const unsigned char *ServerInfoHeader(int Type, bool FirstChunk)
+{
+	switch(Type)
+	{
+	case SERVERINFO_VANILLA:
+	case SERVERINFO_INGAME:
+		return SERVERBROWSE_INFO;
+	case SERVERINFO_64_LEGACY:
+		return SERVERBROWSE_INFO_64_LEGACY;
+	case SERVERINFO_EXTENDED:
+		return FirstChunk ? SERVERBROWSE_INFO_EXTENDED : SERVERBROWSE_INFO_EXTENDED_MORE;
+	}
+	dbg_assert(false, "unknown serverinfo type");
+	return nullptr;
 }
 
 void CServer::CCache::Clear()
@@ -2299,7 +2436,7 @@ void CServer::CacheServerInfo(CCache *pCache, int Type, bool SendClients)
 #define SAVE(size) \
 	do \
 	{ \
-		pCache->AddChunk(q.Data(), size); \
+		pCache->AddChunk(ServerInfoHeader(Type, ChunksStored == 0), SERVERBROWSE_SIZE, q.Data(), size); \
 		ChunksStored++; \
 	} while(0)
 
@@ -2469,54 +2606,29 @@ void CServer::CacheServerInfoSixup(CCache *pCache, bool SendClients)
 
 void CServer::SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool SendClients)
 {
-	CPacker p;
-	char aBuf[128];
-	p.Reset();
-
 	CCache *pCache = &m_aServerInfoCache[GetCacheIndex(Type, SendClients)];
 
-#define ADD_RAW(p, x) (p).AddRaw(x, sizeof(x))
-#define ADD_INT(p, x) \
-	do \
-	{ \
-		str_from_int(x, aBuf); \
-		(p).AddString(aBuf, 0); \
-	} while(0)
+	// the chunks are finished packets, only the token has to be inserted
+	char aToken[16];
+	str_from_int(Token, aToken);
+	const int TokenSize = str_length(aToken) + 1;
 
 	CNetChunk Packet;
 	Packet.m_ClientId = -1;
 	Packet.m_Address = *pAddr;
 	Packet.m_Flags = NETSENDFLAG_CONNLESS;
 
+	unsigned char aPacket[NET_MAX_PAYLOAD];
 	for(const auto &Chunk : pCache->m_vCache)
 	{
-		p.Reset();
-		if(Type == SERVERINFO_EXTENDED)
-		{
-			if(&Chunk == &pCache->m_vCache.front())
-				p.AddRaw(SERVERBROWSE_INFO_EXTENDED, sizeof(SERVERBROWSE_INFO_EXTENDED));
-			else
-				p.AddRaw(SERVERBROWSE_INFO_EXTENDED_MORE, sizeof(SERVERBROWSE_INFO_EXTENDED_MORE));
-			ADD_INT(p, Token);
-		}
-		else if(Type == SERVERINFO_64_LEGACY)
-		{
-			ADD_RAW(p, SERVERBROWSE_INFO_64_LEGACY);
-			ADD_INT(p, Token);
-		}
-		else if(Type == SERVERINFO_VANILLA || Type == SERVERINFO_INGAME)
-		{
-			ADD_RAW(p, SERVERBROWSE_INFO);
-			ADD_INT(p, Token);
-		}
-		else
-		{
-			dbg_assert(false, "unknown serverinfo type");
-		}
-
-		p.AddRaw(Chunk.m_vData.data(), Chunk.m_vData.size());
-		Packet.m_pData = p.Data();
-		Packet.m_DataSize = p.Size();
+		const int BodySize = Chunk.m_vData.size() - Chunk.m_HeaderSize;
+		if(Chunk.m_HeaderSize + TokenSize + BodySize > (int)sizeof(aPacket))
+			continue;
+		mem_copy(aPacket, Chunk.m_vData.data(), Chunk.m_HeaderSize);
+		mem_copy(aPacket + Chunk.m_HeaderSize, aToken, TokenSize);
+		mem_copy(aPacket + Chunk.m_HeaderSize + TokenSize, Chunk.m_vData.data() + Chunk.m_HeaderSize, BodySize);
+		Packet.m_pData = aPacket;
+		Packet.m_DataSize = Chunk.m_HeaderSize + TokenSize + BodySize;
 		m_NetServer.Send(&Packet);
 	}
 }
@@ -2590,7 +2702,7 @@ void CServer::UpdateRegisterServerInfo()
 	else
 		aMapSha256[0] = '\0';
 
-	char aInfo[16384];
+	char aInfo[1024];
 	str_format(aInfo, sizeof(aInfo),
 		"{"
 		"\"max_clients\":%d,"
@@ -2615,8 +2727,8 @@ void CServer::UpdateRegisterServerInfo()
 		aMapSha256,
 		m_aCurrentMapSize[MAP_TYPE_SIX],
 		EscapeJson(aVersion, sizeof(aVersion), GameServer()->Version()));
+	m_RegisterServerInfo.Start(aInfo);
 
-	bool FirstPlayer = true;
 	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
 		if(m_aClients[i].m_State != CClient::STATE_EMPTY)
@@ -2629,37 +2741,21 @@ void CServer::UpdateRegisterServerInfo()
 
 			--ClientCount;
 
-			char aCName[32];
-			char aCClan[32];
-
 			char aExtraPlayerInfo[512];
 			GameServer()->OnUpdatePlayerServerInfo(aExtraPlayerInfo, sizeof(aExtraPlayerInfo), i);
 
-			char aClientInfo[1024];
-			str_format(aClientInfo, sizeof(aClientInfo),
-				"%s{"
-				"\"name\":\"%s\","
-				"\"clan\":\"%s\","
-				"\"country\":%d,"
-				"\"score\":%d,"
-				"\"is_player\":%s"
-				"%s"
-				"}",
-				!FirstPlayer ? "," : "",
-				EscapeJson(aCName, sizeof(aCName), ClientName(i)),
-				EscapeJson(aCClan, sizeof(aCClan), ClientClan(i)),
-				m_aClients[i].m_Country,
-				RoundStatistics()->PlayerScore(i),
-				JsonBool(GameServer()->IsClientPlayer(i)),
-				aExtraPlayerInfo);
-			str_append(aInfo, aClientInfo);
-			FirstPlayer = false;
+			CRegisterServerInfo::CClientInfo Info;
+			Info.m_pName = ClientName(i);
+			Info.m_pClan = ClientClan(i);
+			Info.m_Country = m_aClients[i].m_Country;
+			Info.m_Score = RoundStatistics()->PlayerScore(i);
+			Info.m_IsPlayer = GameServer()->IsClientPlayer(i);
+			Info.m_pExtra = aExtraPlayerInfo;
+			m_RegisterServerInfo.AddClient(i, Info);
 		}
 	}
 
-	str_append(aInfo, "]}");
-
-	m_pRegister->OnNewInfo(aInfo);
+	m_pRegister->OnNewInfo(m_RegisterServerInfo.Finish());
 }
 
 void CServer::UpdateServerInfo(bool Resend)
@@ -2861,6 +2957,13 @@ int CServer::LoadMap(const char *pMapName)
 	str_copy(m_aCurrentMap, pMapName);
 	ResetMapVotes();
 
+	m_pLeaderboard = nullptr;
+	m_pLeaderboardResult = nullptr;
+	m_LeaderboardRequested = false;
+	m_LeaderboardRetryTick = 0;
+	m_LeaderboardRetryDelay = 0;
+	m_vPendingLeaderboardRounds.clear();
+
 /* INFECTION MODIFICATION END *****************************************/
 
 	for(int i = 0; i < MAX_CLIENTS; i++)
@@ -2956,6 +3059,7 @@ int CServer::Run()
 		return -1;
 	}
 
+	DbPool()->SetNumReadWorkers(Config()->m_SvSqlReadWorkers);
 	if(Config()->m_SvSqliteFile[0] != '\0')
 	{
 		char aFullPath[IO_MAX_PATH_LENGTH];
@@ -3195,17 +3299,12 @@ int CServer::Run()
 				GameServer()->OnTick();
 				
 #ifdef CONF_SQL
-				if(m_lGameServerCmds.size())
+				CGameServerCmd *pGameServerCmd;
+				while(m_GameServerCmds.TryPop(&pGameServerCmd))
 				{
-					lock_wait(m_GameServerCmdLock);
-					for(int i=0; i<m_lGameServerCmds.size(); i++)
-					{
-						m_lGameServerCmds[i]->Execute(GameServer());
-						delete m_lGameServerCmds[i];
-					}
-					m_lGameServerCmds.clear();
-					lock_release(m_GameServerCmdLock);
-				} 
+					pGameServerCmd->Execute(GameServer());
+					delete pGameServerCmd;
+				}
 #endif
 				if(ErrorShutdown())
 				{
@@ -3228,6 +3327,9 @@ int CServer::Run()
 			if(m_ServerInfoNeedsUpdate)
 				UpdateServerInfo();
 
+			UpdateLeaderboard();
+			DbPool()->Update();
+
 			if(!NonActive)
 				PumpNetwork(PacketWaiting);
 
@@ -3314,6 +3416,7 @@ int CServer::Run()
 
 	GameServer()->OnShutdown();
 	m_pMap->Unload();
+	DbPool()->OnShutdown();
 
 /* DDNET MODIFICATION START *******************************************/
 #ifdef CONF_SQL
@@ -3478,20 +3581,16 @@ void CServer::ConNameBan(IConsole::IResult *pResult, void *pUser)
 	int Distance = pResult->NumArguments() > 1 ? pResult->GetInteger(1) : str_length(pName) / 3;
 	int IsSubstring = pResult->NumArguments() > 2 ? pResult->GetInteger(2) : 0;
 
-	for(auto &Ban : pThis->m_vNameBans)
+	const CNameBan *pBan = pThis->m_NameBans.Find(pName);
+	if(pBan)
 	{
-		if(str_comp(Ban.m_aName, pName) == 0)
-		{
-			str_format(aBuf, sizeof(aBuf), "changed name='%s' distance=%d old_distance=%d is_substring=%d old_is_substring=%d reason='%s' old_reason='%s'", pName, Distance, Ban.m_Distance, IsSubstring, Ban.m_IsSubstring, pReason, Ban.m_aReason);
-			pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "name_ban", aBuf);
-			Ban.m_Distance = Distance;
-			Ban.m_IsSubstring = IsSubstring;
-			str_copy(Ban.m_aReason, pReason);
-			return;
-		}
+		str_format(aBuf, sizeof(aBuf), "changed name='%s' distance=%d old_distance=%d is_substring=%d old_is_substring=%d reason='%s' old_reason='%s'", pName, Distance, pBan->m_Distance, IsSubstring, pBan->m_IsSubstring, pReason, pBan->m_aReason);
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "name_ban", aBuf);
+		pThis->m_NameBans.Set(pName, Distance, IsSubstring, pReason);
+		return;
 	}
 
-	pThis->m_vNameBans.emplace_back(pName, Distance, IsSubstring, pReason);
+	pThis->m_NameBans.Set(pName, Distance, IsSubstring, pReason);
 	str_format(aBuf, sizeof(aBuf), "added name='%s' distance=%d is_substring=%d reason='%s'", pName, Distance, IsSubstring, pReason);
 	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "name_ban", aBuf);
 }
@@ -3501,16 +3600,13 @@ void CServer::ConNameUnban(IConsole::IResult *pResult, void *pUser)
 	CServer *pThis = (CServer *)pUser;
 	const char *pName = pResult->GetString(0);
 
-	for(size_t i = 0; i < pThis->m_vNameBans.size(); i++)
+	const CNameBan *pBan = pThis->m_NameBans.Find(pName);
+	if(pBan)
 	{
-		CNameBan *pBan = &pThis->m_vNameBans[i];
-		if(str_comp(pBan->m_aName, pName) == 0)
-		{
-			char aBuf[128];
-			str_format(aBuf, sizeof(aBuf), "removed name='%s' distance=%d is_substring=%d reason='%s'", pBan->m_aName, pBan->m_Distance, pBan->m_IsSubstring, pBan->m_aReason);
-			pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "name_ban", aBuf);
-			pThis->m_vNameBans.erase(pThis->m_vNameBans.begin() + i);
-		}
+		char aBuf[128];
+		str_format(aBuf, sizeof(aBuf), "removed name='%s' distance=%d is_substring=%d reason='%s'", pBan->m_aName, pBan->m_Distance, pBan->m_IsSubstring, pBan->m_aReason);
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "name_ban", aBuf);
+		pThis->m_NameBans.Remove(pName);
 	}
 }
 
@@ -3518,7 +3614,7 @@ void CServer::ConNameBans(IConsole::IResult *pResult, void *pUser)
 {
 	CServer *pThis = (CServer *)pUser;
 
-	for(auto &Ban : pThis->m_vNameBans)
+	for(const auto &Ban : pThis->m_NameBans.Bans())
 	{
 		char aBuf[128];
 		str_format(aBuf, sizeof(aBuf), "name='%s' distance=%d is_substring=%d reason='%s'", Ban.m_aName, Ban.m_Distance, Ban.m_IsSubstring, Ban.m_aReason);
@@ -3526,6 +3622,33 @@ void CServer::ConNameBans(IConsole::IResult *pResult, void *pUser)
 	}
 }
 
+void CServer::ConMapCache(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = (CServer *)pUser;
+	const CMapCache &MapCache = pThis->m_MapCache;
+
+	char aBuf[256];
+	for(const auto &pMap : MapCache.Maps())
+	{
+		str_format(aBuf, sizeof(aBuf), "map='%s' converter='%s' memory=%d KiB", pMap->m_ClientMap.m_aName, pMap->m_ClientMap.m_aConverterId, (int)(pMap->m_MemoryUsage / 1024));
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "map_cache", aBuf);
+	}
+	str_format(aBuf, sizeof(aBuf), "maps=%d hits=%d misses=%d memory=%d/%d KiB", (int)MapCache.Maps().size(), MapCache.Hits(), MapCache.Misses(),
+		(int)(MapCache.MemoryUsage() / 1024), (int)(pThis->MapCacheBudget() / 1024));
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "map_cache", aBuf);
+}
+
+void CServer::ConDemoStats(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = (CServer *)pUser;
+	const CDemoWriter::CStats Stats = pThis->m_DemoWriter.Stats();
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "chunks=%" PRId64 " dropped=%" PRId64 " waits=%" PRId64 " raw=%" PRId64 " KiB max_queued=%d KiB",
+		Stats.m_Chunks, Stats.m_DroppedChunks, Stats.m_Waits, Stats.m_Bytes / 1024, Stats.m_MaxQueuedBytes / 1024);
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "demo_recorder", aBuf);
+}
+
 void CServer::ConShutdown(IConsole::IResult *pResult, void *pUser)
 {
 	CServer* pThis = static_cast<CServer *>(pUser);
@@ -3762,6 +3885,12 @@ void CServer::ConAddSqlServer(IConsole::IResult *pResult, void *pUserData)
 	pSelf->DbPool()->RegisterMysqlDatabase(Write ? CDbConnectionPool::WRITE : CDbConnectionPool::READ, &Config);
 }
 
+void CServer::ConSqlStats(IConsole::IResult *pResult, void *pUserData)
+{
+	CServer *pSelf = (CServer *)pUserData;
+	pSelf->DbPool()->PrintStats(pSelf->Console());
+}
+
 void CServer::ConDumpSqlServers(IConsole::IResult *pResult, void *pUserData)
 {
 	CServer *pSelf = (CServer *)pUserData;
@@ -3989,10 +4118,13 @@ void CServer::RegisterCommands()
 
 	Console()->Register("add_sqlserver", "s['r'|'w'] s[Database] s[Prefix] s[User] s[Password] s[IP] i[Port] ?i[SetUpDatabase ?]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAddSqlServer, this, "add a sqlserver");
 	Console()->Register("dump_sqlservers", "s['r'|'w']", CFGFLAG_SERVER, ConDumpSqlServers, this, "dumps all sqlservers readservers = r, writeservers = w");
+	Console()->Register("sql_stats", "", CFGFLAG_SERVER, ConSqlStats, this, "Show the depth and latency of the database queues");
 
 	Console()->Register("name_ban", "s[name] ?i[distance] ?i[is_substring] ?r[reason]", CFGFLAG_SERVER, ConNameBan, this, "Ban a certain nickname");
 	Console()->Register("name_unban", "s[name]", CFGFLAG_SERVER, ConNameUnban, this, "Unban a certain nickname");
 	Console()->Register("name_bans", "", CFGFLAG_SERVER, ConNameBans, this, "List all name bans");
+	Console()->Register("demo_stats", "", CFGFLAG_SERVER, ConDemoStats, this, "Show the demo writer queue statistics");
+	Console()->Register("map_cache", "", CFGFLAG_SERVER, ConMapCache, this, "List the maps kept ready for a quick switch and the cache statistics");
 
 	Console()->Chain("sv_name", ConchainSpecialInfoupdate, this);
 	Console()->Chain("sv_hide_info", ConchainSpecialInfoupdate, this);
@@ -4074,7 +4206,7 @@ CServer *CreateServer() { return new CServer(); }
 
 void CServer::GetClientAddr(int ClientId, NETADDR *pAddr) const
 {
-	if(ClientId >= 0 && ClientId < MAX_CLIENTS && m_aClients[ClientId].m_State == CClient::STATE_INGAME)
+	if(ClientId >= 0 && ClientId < MAX_CLIENTS && m_aClients[ClientId].m_State != CClient::STATE_EMPTY)
 	{
 		*pAddr = *m_NetServer.ClientAddr(ClientId);
 	}
@@ -4186,9 +4318,7 @@ bool CServer::IsClientLogged(int ClientId)
 #ifdef CONF_SQL
 void CServer::AddGameServerCmd(CGameServerCmd* pCmd)
 {
-	lock_wait(m_GameServerCmdLock);
-	m_lGameServerCmds.add(pCmd);
-	lock_release(m_GameServerCmdLock);
+	m_GameServerCmds.Push(pCmd);
 }
 
 class CGameServerCmd_SendChatMOTD : public CServer::CGameServerCmd
@@ -4250,38 +4380,76 @@ public:
 	}
 };
 
+// reports the outcome of a login to the throttle, executed on the game thread
+class CGameServerCmd_LoginAttempt : public CServer::CGameServerCmd
+{
+private:
+	CServer *m_pServer;
+	NETADDR m_Addr;
+	bool m_Success;
+
+public:
+	CGameServerCmd_LoginAttempt(CServer *pServer, const NETADDR *pAddr, bool Success)
+	{
+		m_pServer = pServer;
+		m_Addr = *pAddr;
+		m_Success = Success;
+	}
+
+	virtual void Execute(IGameServer *pGameServer)
+	{
+		if(!m_Success)
+			m_pServer->m_LoginThrottle.OnFailure(&m_Addr, time_get());
+	}
+};
+
+static void HashPassword(const char *pPassword, char *pHash)
+{
+	mem_zero(pHash, 64);
+	Crypt(pPassword, (const unsigned char*) "d9", 1, 16, pHash);
+}
+
 class CSqlJob_Server_Login : public CSqlJob
 {
 private:
 	CServer* m_pServer;
 	int m_ClientId;
+	NETADDR m_Addr;
 	CSqlString<64> m_sName;
-	CSqlString<64> m_sPasswordHash;
+	char m_aPassword[128];
 	
 public:
-	CSqlJob_Server_Login(CServer* pServer, int ClientId, const char* pName, const char* pPasswordHash)
+	CSqlJob_Server_Login(CServer* pServer, int ClientId, const NETADDR *pAddr, const char* pName, const char* pPassword)
 	{
 		m_pServer = pServer;
 		m_ClientId = ClientId;
+		m_Addr = *pAddr;
 		m_sName = CSqlString<64>(pName);
-		m_sPasswordHash = CSqlString<64>(pPasswordHash);
+		str_copy(m_aPassword, pPassword, sizeof(m_aPassword));
 	}
 
 	virtual bool Job(CSqlServer* pSqlServer)
 	{
 		char aBuf[512];
 		
+		// hashed on the job thread, it is too slow for the game thread
+		char aHash[64];
+		HashPassword(m_aPassword, aHash);
+		CSqlString<64> sPasswordHash = CSqlString<64>(aHash);
+		
 		try
 		{	
 			//Check for username/password
 			str_format(aBuf, sizeof(aBuf), 
 				"SELECT UserId, Level FROM %s_Users "
 				"WHERE Username = '%s' AND PasswordHash = '%s';"
-				, pSqlServer->GetPrefix(), m_sName.ClrStr(), m_sPasswordHash.ClrStr());
+				, pSqlServer->GetPrefix(), m_sName.ClrStr(), sPasswordHash.ClrStr());
 			pSqlServer->executeSqlQuery(aBuf);
 
 			if(pSqlServer->GetResults()->next())
 			{
+				m_pServer->AddGameServerCmd(new CGameServerCmd_LoginAttempt(m_pServer, &m_Addr, true));
+				
 				//The client is still the same
 				if(m_pServer->m_aClients[m_ClientId].m_LogInstance == GetInstance() && m_pServer->m_aClients[m_ClientId].m_UserId == -1)
 				{
@@ -4320,6 +4488,7 @@ public:
 			}
 			else
 			{
+				m_pServer->AddGameServerCmd(new CGameServerCmd_LoginAttempt(m_pServer, &m_Addr, false));
 				CServer::CGameServerCmd* pCmd = new CGameServerCmd_SendChatTarget_Language(m_ClientId, CHATCATEGORY_DEFAULT, _("Wrong username/password."));
 				m_pServer->AddGameServerCmd(pCmd);
 			}
@@ -4346,12 +4515,10 @@ void CServer::Login(int ClientId, const char* pUsername, const char* pPassword)
 {
 	if(m_aClients[ClientId].m_LogInstance >= 0)
 		return;
+	if(LoginThrottled(ClientId))
+		return;
 	
-	char aHash[64]; //Result
-	mem_zero(aHash, sizeof(aHash));
-	Crypt(pPassword, (const unsigned char*) "d9", 1, 16, aHash);
-	
-	CSqlJob* pJob = new CSqlJob_Server_Login(this, ClientId, pUsername, aHash);
+	CSqlJob* pJob = new CSqlJob_Server_Login(this, ClientId, m_NetServer.ClientAddr(ClientId), pUsername, pPassword);
 	m_aClients[ClientId].m_LogInstance = pJob->GetInstance();
 	pJob->Start();
 }
@@ -4428,16 +4595,16 @@ private:
 	CServer* m_pServer;
 	int m_ClientId;
 	CSqlString<64> m_sName;
-	CSqlString<64> m_sPasswordHash;
+	char m_aPassword[128];
 	CSqlString<64> m_sEmail;
 	
 public:
-	CSqlJob_Server_Register(CServer* pServer, int ClientId, const char* pName, const char* pPasswordHash, const char* pEmail)
+	CSqlJob_Server_Register(CServer* pServer, int ClientId, const char* pName, const char* pPassword, const char* pEmail)
 	{
 		m_pServer = pServer;
 		m_ClientId = ClientId;
 		m_sName = CSqlString<64>(pName);
-		m_sPasswordHash = CSqlString<64>(pPasswordHash);
+		str_copy(m_aPassword, pPassword, sizeof(m_aPassword));
 		if(pEmail)
 			m_sEmail = CSqlString<64>(pEmail);
 		else
@@ -4455,6 +4622,10 @@ public:
 		
 		net_addr_str(m_pServer->m_NetServer.ClientAddr(m_ClientId), aAddrStr, sizeof(aAddrStr), false);
 		
+		char aHash[64];
+		HashPassword(m_aPassword, aHash);
+		CSqlString<64> sPasswordHash = CSqlString<64>(aHash);
+		
 		try
 		{
 			//Check for registration flooding
@@ -4516,7 +4687,7 @@ public:
 				"INSERT INTO %s_Users "
 				"(Username, PasswordHash, Email, RegisterDate, RegisterIp) "
 				"VALUES ('%s', '%s', '%s', UTC_TIMESTAMP(), '%s');"
-				, pSqlServer->GetPrefix(), m_sName.ClrStr(), m_sPasswordHash.ClrStr(), m_sEmail.ClrStr(), aAddrStr);
+				, pSqlServer->GetPrefix(), m_sName.ClrStr(), sPasswordHash.ClrStr(), m_sEmail.ClrStr(), aAddrStr);
 			pSqlServer->executeSql(aBuf);
 		}
 		catch (sql::SQLException &e)
@@ -4534,7 +4705,7 @@ public:
 			str_format(aBuf, sizeof(aBuf), 
 				"SELECT UserId FROM %s_Users "
 				"WHERE Username = '%s' AND PasswordHash = '%s';"
-				, pSqlServer->GetPrefix(), m_sName.ClrStr(), m_sPasswordHash.ClrStr());
+				, pSqlServer->GetPrefix(), m_sName.ClrStr(), sPasswordHash.ClrStr());
 			pSqlServer->executeSqlQuery(aBuf);
 
 			if(pSqlServer->GetResults()->next())
@@ -4588,12 +4759,10 @@ void CServer::Register(int ClientId, const char* pUsername, const char* pPasswor
 {
 	if(m_aClients[ClientId].m_LogInstance >= 0)
 		return;
+	if(LoginThrottled(ClientId))
+		return;
 	
-	char aHash[64]; //Result
-	mem_zero(aHash, sizeof(aHash));
-	Crypt(pPassword, (const unsigned char*) "d9", 1, 16, aHash);
-	
-	CSqlJob* pJob = new CSqlJob_Server_Register(this, ClientId, pUsername, aHash, pEmail);
+	CSqlJob* pJob = new CSqlJob_Server_Register(this, ClientId, pUsername, pPassword, pEmail);
 	m_aClients[ClientId].m_LogInstance = pJob->GetInstance();
 	pJob->Start();
 }
@@ -5306,8 +5475,11 @@ void CServer::ShowStats(int ClientId, int UserId)
 
 void CServer::Register(int ClientId, const char* pUsername, const char* pPassword, const char* pEmail)
 {
+	if(LoginThrottled(ClientId))
+		return;
+
 	char aBuf[512];
-	str_format(aBuf, sizeof(aBuf), "register request=%d login='%s' password='%s'", m_LastRegistrationRequestId, pUsername, pPassword);
+	str_format(aBuf, sizeof(aBuf), "register request=%d login='%s'", m_LastRegistrationRequestId, pUsername);
 	++m_LastRegistrationRequestId;
 
 	Console()->Print(IConsole::OUTPUT_LEVEL_DEBUG, "registration", aBuf);
@@ -5315,11 +5487,17 @@ void CServer::Register(int ClientId, const char* pUsername, const char* pPasswor
 
 void CServer::Login(int ClientId, const char *pUsername, const char *pPassword)
 {
+	if(LoginThrottled(ClientId))
+		return;
+
 	char aBuf[512];
-	str_format(aBuf, sizeof(aBuf), "login request=%d login='%s' password='%s'", m_LastRegistrationRequestId, pUsername, pPassword);
+	str_format(aBuf, sizeof(aBuf), "login request=%d login='%s'", m_LastRegistrationRequestId, pUsername);
 	++m_LastRegistrationRequestId;
 
 	Console()->Print(IConsole::OUTPUT_LEVEL_DEBUG, "registration", aBuf);
+
+	// there are no accounts without CONF_SQL, so no login succeeds
+	m_LoginThrottle.OnFailure(m_NetServer.ClientAddr(ClientId), time_get());
 }
 
 void CServer::Logout(int ClientId)
@@ -5332,233 +5510,150 @@ void CServer::Ban(int ClientId, int Seconds, const char* pReason)
 	m_ServerBan.BanAddr(m_NetServer.ClientAddr(ClientId), Seconds, pReason);
 }
 
-#ifdef CONF_SQL
+bool CServer::LoginThrottled(int ClientId)
+{
+	const int64_t Now = time_get();
+	m_LoginThrottle.Prune(Now);
+	int BlockedFor = m_LoginThrottle.BlockedFor(m_NetServer.ClientAddr(ClientId), Now);
+	if(BlockedFor > 0)
+	{
+		m_pGameServer->SendChatTarget_Localization(ClientId, CHATCATEGORY_DEFAULT, _("Too many failed logins, please wait {sec:Duration}"), "Duration", &BlockedFor, NULL);
+		return true;
+	}
+	return false;
+}
 
-class CSqlJob_Server_SendRoundStatistics : public CSqlJob
+bool CServer::DatabaseEnabled() const
 {
-private:
-	CSqlString<64> m_sMapName;
-	int m_NumPlayersMin;
-	int m_NumPlayersMax;
-	int m_RoundDuration;
-	int m_NumWinners;
-	
-	int m_RoundId;
-	
-public:
-	CSqlJob_Server_SendRoundStatistics(CServer* pServer, const CRoundStatistics* pRoundStatistics, const char* pMapName)
+	return Config()->m_SvUseSql || Config()->m_SvSqliteFile[0] != '\0';
+}
+
+void CServer::UpdateLeaderboard()
+{
+	if(!m_LeaderboardRequested)
 	{
-		m_sMapName = CSqlString<64>(pMapName);
-		m_NumPlayersMin = pRoundStatistics->m_NumPlayersMin;
-		m_NumPlayersMax = pRoundStatistics->m_NumPlayersMax;
-		m_NumWinners = pRoundStatistics->NumWinners();
-		m_RoundDuration = pRoundStatistics->m_PlayedTicks/pServer->TickSpeed();
-		m_RoundId = -1;
+		if(!DatabaseEnabled() || m_aCurrentMap[0] == '\0' || Tick() < m_LeaderboardRetryTick)
+			return;
+		m_LeaderboardRequested = true;
+		m_pLeaderboardResult = std::make_shared<CLeaderboardResult>();
+		auto pRequest = std::make_unique<CSqlLeaderboardRequest>(m_pLeaderboardResult);
+		str_copy(pRequest->m_aMap, m_aCurrentMap);
+		DbPool()->Execute(CRoundStatsWorker::LoadLeaderboard, std::move(pRequest), "load leaderboard");
+		return;
 	}
 
-	virtual bool Job(CSqlServer* pSqlServer)
+	if(!m_pLeaderboardResult || !m_pLeaderboardResult->m_Completed.load())
+		return;
+
+	std::shared_ptr<CLeaderboardResult> pResult = std::move(m_pLeaderboardResult);
+	if(!pResult->m_Success)
 	{
-		char aBuf[512];
-		
-		try
-		{
-			str_format(aBuf, sizeof(aBuf), 
-				"INSERT INTO %s_infc_Rounds "
-				"(MapName, NumPlayersMin, NumPlayersMax, NumWinners, RoundDate, RoundDuration) "
-				"VALUES "
-				"('%s', '%d', '%d', '%d', UTC_TIMESTAMP(), '%d')"
-				, pSqlServer->GetPrefix(), m_sMapName.ClrStr(), m_NumPlayersMin, m_NumPlayersMax, m_NumWinners, m_RoundDuration);
-			pSqlServer->executeSql(aBuf);
-			
-			//Get old score
-			str_format(aBuf, sizeof(aBuf), 
-				"SELECT RoundId FROM %s_infc_Rounds "
-				"WHERE RoundDuration = '%d' AND NumPlayersMin = '%d' AND NumPlayersMax = '%d'"
-				"ORDER BY RoundId DESC LIMIT 1"
-				, pSqlServer->GetPrefix(), m_RoundDuration, m_NumPlayersMin, m_NumPlayersMax);
-			pSqlServer->executeSqlQuery(aBuf);
-			
-			if(pSqlServer->GetResults()->next())
-			{
-				m_RoundId = (int)pSqlServer->GetResults()->getInt("RoundId");
-			}
-		}
-		catch (sql::SQLException &e)
-		{
-			dbg_msg("sql", "Can't send round statistics (MySQL Error: %s)", e.what());
-			
-			return false;
-		}
-		
-		return true;
+		// ask again later, waiting twice as long after every failure
+		m_LeaderboardRetryDelay = clamp(m_LeaderboardRetryDelay * 2, 5 * TickSpeed(), 300 * TickSpeed());
+		m_LeaderboardRetryTick = Tick() + m_LeaderboardRetryDelay;
+		m_LeaderboardRequested = false;
+		dbg_msg("server", "failed to load the leaderboard of %s, retrying in %d seconds", m_aCurrentMap, m_LeaderboardRetryDelay / TickSpeed());
+		return;
 	}
-	
-	virtual void* GenerateChildData()
+
+	m_pLeaderboard = std::make_unique<CLeaderboard>(std::move(pResult->m_Leaderboard));
+	// the rounds written before the query ran are already in it
+	for(const CPendingRound &Round : m_vPendingLeaderboardRounds)
 	{
-		return &m_RoundId;
+		if(pResult->m_RoundIds.count(Round.m_RoundId))
+			continue;
+		for(const CSqlRoundStatsData::CScore &Score : Round.m_vScores)
+			m_pLeaderboard->AddRound(Score.m_ScoreType, Score.m_aName, Score.m_Score);
 	}
-};
+	m_vPendingLeaderboardRounds.clear();
+}
 
-class CSqlJob_Server_SendPlayerStatistics : public CSqlJob
+void CServer::SendStatistics()
 {
-private:
-	CServer* m_pServer;
-	int m_ClientId;
-	int m_UserId;
-	int m_RoundId;
-	CSqlString<64> m_sMapName;
-	CRoundStatistics::CPlayer m_PlayerStatistics;
-	
-public:
-	CSqlJob_Server_SendPlayerStatistics(CServer* pServer, const CRoundStatistics::CPlayer* pPlayerStatistics, const char* pMapName, int UserId, int ClientId)
+	if(!DatabaseEnabled())
+		return;
+
+	auto pData = std::make_unique<CSqlRoundStatsData>(nullptr);
+	FormatUuid(RandomUuid(), pData->m_aRoundId, sizeof(pData->m_aRoundId));
+	str_copy(pData->m_aMap, m_aCurrentMap);
+	str_timestamp_format(pData->m_aTimestamp, sizeof(pData->m_aTimestamp), FORMAT_SPACE);
+	pData->m_Duration = RoundStatistics()->m_PlayedTicks / TickSpeed();
+	pData->m_NumPlayersMin = RoundStatistics()->m_NumPlayersMin;
+	pData->m_NumPlayersMax = RoundStatistics()->m_NumPlayersMax;
+	pData->m_NumWinners = RoundStatistics()->NumWinners();
+
+	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
-		m_RoundId = -1;
-		m_pServer = pServer;
-		m_ClientId = ClientId;
-		m_UserId = UserId;
-		m_sMapName = CSqlString<64>(pMapName);
-		m_PlayerStatistics = *pPlayerStatistics;
+		if(m_aClients[i].m_State == CClient::STATE_INGAME && RoundStatistics()->IsValidePlayer(i))
+		{
+			pData->AddPlayer(ClientName(i), RoundStatistics()->PlayerStatistics(i));
+		}
 	}
-	
-	virtual void ProcessParentData(void* pData)
+
+	if(m_pLeaderboard)
 	{
-		int* pRoundId = (int*) pData;
-		m_RoundId = *pRoundId;
+		for(int i = 0; i < pData->m_NumScores; i++)
+			m_pLeaderboard->AddRound(pData->m_aScores[i].m_ScoreType, pData->m_aScores[i].m_aName, pData->m_aScores[i].m_Score);
 	}
-	
-	void UpdateScore(CSqlServer* pSqlServer, int ScoreType, int Score, const char* pScoreName)
+	else
 	{
-		char aBuf[512];
-		str_format(aBuf, sizeof(aBuf), 
-			"INSERT INTO %s_infc_RoundScore "
-			"(UserId, RoundId, MapName, ScoreType, ScoreDate, Score) "
-			"VALUES ('%d', '%d', '%s', '%d', UTC_TIMESTAMP(), '%d');"
-			, pSqlServer->GetPrefix(), m_UserId, m_RoundId, m_sMapName.ClrStr(), ScoreType, Score);
-		pSqlServer->executeSql(aBuf);
+		// the leaderboard is loading or waiting to be loaded again
+		CPendingRound Round;
+		Round.m_RoundId = pData->m_aRoundId;
+		Round.m_vScores.assign(pData->m_aScores, pData->m_aScores + pData->m_NumScores);
+		m_vPendingLeaderboardRounds.push_back(std::move(Round));
 	}
 
-	virtual bool Job(CSqlServer* pSqlServer)
-	{
-		char aBuf[512];
-		
-		if(m_RoundId < 0)
-			return false;
-		
-		try
-		{
-			//Get old score
-			str_format(aBuf, sizeof(aBuf), 
-				"SELECT Score FROM %s_infc_RoundScore "
-				"WHERE UserId = '%d' AND MapName = '%s' AND ScoreType = '%d'"
-				"ORDER BY Score DESC "
-				"LIMIT %d "
-				, pSqlServer->GetPrefix(), m_UserId, m_sMapName.ClrStr(), 0, SQL_SCORE_NUMROUND);
-			pSqlServer->executeSqlQuery(aBuf);
+	DbPool()->ExecuteWrite(CRoundStatsWorker::SaveRoundStats, std::move(pData), "save round statistics");
+}
 
-			int OldScore = 0;
-			while(pSqlServer->GetResults()->next())
-			{
-				OldScore += (int)pSqlServer->GetResults()->getInt("Score");
-			}
-			
-			if(m_PlayerStatistics.m_Score > 0)
-				UpdateScore(pSqlServer, SQL_SCORETYPE_ROUND_SCORE, m_PlayerStatistics.m_Score, "");
-				
-			if(m_PlayerStatistics.m_EngineerScore > 0)
-				UpdateScore(pSqlServer, SQL_SCORETYPE_ENGINEER_SCORE, m_PlayerStatistics.m_EngineerScore, "Engineer");
-			if(m_PlayerStatistics.m_SoldierScore > 0)
-				UpdateScore(pSqlServer, SQL_SCORETYPE_SOLDIER_SCORE, m_PlayerStatistics.m_SoldierScore, "Soldier");
-			if(m_PlayerStatistics.m_ScientistScore > 0)
-				UpdateScore(pSqlServer, SQL_SCORETYPE_SCIENTIST_SCORE, m_PlayerStatistics.m_ScientistScore, "Scientist");
-			if(m_PlayerStatistics.m_BiologistScore > 0)
-				UpdateScore(pSqlServer, SQL_SCORETYPE_BIOLOGIST_SCORE, m_PlayerStatistics.m_BiologistScore, "Biologist");
-			if(m_PlayerStatistics.m_LooperScore > 0)
-				UpdateScore(pSqlServer, SQL_SCORETYPE_LOOPER_SCORE, m_PlayerStatistics.m_LooperScore, "Looper");
-			if(m_PlayerStatistics.m_MedicScore > 0)
-				UpdateScore(pSqlServer, SQL_SCORETYPE_MEDIC_SCORE, m_PlayerStatistics.m_MedicScore, "Medic");
-			if(m_PlayerStatistics.m_HeroScore > 0)
-				UpdateScore(pSqlServer, SQL_SCORETYPE_HERO_SCORE, m_PlayerStatistics.m_HeroScore, "Hero");
-			if(m_PlayerStatistics.m_NinjaScore > 0)
-				UpdateScore(pSqlServer, SQL_SCORETYPE_NINJA_SCORE, m_PlayerStatistics.m_NinjaScore, "Ninja");
-			if(m_PlayerStatistics.m_MercenaryScore > 0)
-				UpdateScore(pSqlServer, SQL_SCORETYPE_MERCENARY_SCORE, m_PlayerStatistics.m_MercenaryScore, "Mercenary");
-			if(m_PlayerStatistics.m_SniperScore > 0)
-				UpdateScore(pSqlServer, SQL_SCORETYPE_SNIPER_SCORE, m_PlayerStatistics.m_SniperScore, "Sniper");
-				
-			if(m_PlayerStatistics.m_SmokerScore > 0)
-				UpdateScore(pSqlServer, SQL_SCORETYPE_SMOKER_SCORE, m_PlayerStatistics.m_SmokerScore, "Smoker");
-			if(m_PlayerStatistics.m_HunterScore > 0)
-				UpdateScore(pSqlServer, SQL_SCORETYPE_HUNTER_SCORE, m_PlayerStatistics.m_HunterScore, "Hunter");
-			if(m_PlayerStatistics.m_BoomerScore > 0)
-				UpdateScore(pSqlServer, SQL_SCORETYPE_BOOMER_SCORE, m_PlayerStatistics.m_BoomerScore, "Boomer");
-			if(m_PlayerStatistics.m_GhostScore > 0)
-				UpdateScore(pSqlServer, SQL_SCORETYPE_GHOST_SCORE, m_PlayerStatistics.m_GhostScore, "Ghost");
-			if(m_PlayerStatistics.m_SpiderScore > 0)
-				UpdateScore(pSqlServer, SQL_SCORETYPE_SPIDER_SCORE, m_PlayerStatistics.m_SpiderScore, "Spider");
-			if(m_PlayerStatistics.m_GhoulScore > 0)
-				UpdateScore(pSqlServer, SQL_SCORETYPE_GHOUL_SCORE, m_PlayerStatistics.m_GhoulScore, "Ghoul");
-			if(m_PlayerStatistics.m_SlugScore > 0)
-				UpdateScore(pSqlServer, SQL_SCORETYPE_SLUG_SCORE, m_PlayerStatistics.m_SlugScore, "Slug");
-			if(m_PlayerStatistics.m_UndeadScore > 0)
-				UpdateScore(pSqlServer, SQL_SCORETYPE_UNDEAD_SCORE, m_PlayerStatistics.m_UndeadScore, "Undead");
-			if(m_PlayerStatistics.m_WitchScore > 0)
-				UpdateScore(pSqlServer, SQL_SCORETYPE_WITCH_SCORE, m_PlayerStatistics.m_WitchScore, "Witch");
-		
-			//Get new score
-			str_format(aBuf, sizeof(aBuf), 
-				"SELECT Score FROM %s_infc_RoundScore "
-				"WHERE UserId = '%d' AND MapName = '%s' AND ScoreType = '%d'"
-				"ORDER BY Score DESC "
-				"LIMIT %d "
-				, pSqlServer->GetPrefix(), m_UserId, m_sMapName.ClrStr(), 0, SQL_SCORE_NUMROUND);
-			pSqlServer->executeSqlQuery(aBuf);
+#ifndef CONF_SQL
+void CServer::ShowTop10(int ClientId, int ScoreType)
+{
+	if(!m_pLeaderboard)
+	{
+		GameServer()->SendChatTarget_Localization(ClientId, CHATCATEGORY_DEFAULT, _("The leaderboard is not available yet"), nullptr);
+		return;
+	}
 
-			int NewScore = 0;
-			if(pSqlServer->GetResults()->next())
-			{
-				NewScore += (int)pSqlServer->GetResults()->getInt("Score");
-			}
-			
-			if(OldScore < NewScore)
-			{
-				str_format(aBuf, sizeof(aBuf), "You increased your score: +%d", (NewScore-OldScore)/10);
-				CServer::CGameServerCmd* pCmd = new CGameServerCmd_SendChatTarget(m_ClientId, aBuf);
-				m_pServer->AddGameServerCmd(pCmd);
-			}
-		}
-		catch (sql::SQLException &e)
-		{
-			dbg_msg("sql", "Can't send player statistics (MySQL Error: %s)", e.what());
-			
-			return false;
-		}
-		
-		return true;
+	char aBuf[1024];
+	str_format(aBuf, sizeof(aBuf), "== Best %s ==\n%d best scores on this map\n\n", RoundScoreTypeName(ScoreType), (int)CLeaderboard::NUM_BEST_ROUNDS);
+	const CLeaderboard::CEntry *apEntries[10];
+	int NumEntries = m_pLeaderboard->Top(ScoreType, apEntries, std::size(apEntries));
+	for(int i = 0; i < NumEntries; i++)
+	{
+		char aLine[64];
+		str_format(aLine, sizeof(aLine), "%d. %s: %d pts\n", i + 1, apEntries[i]->m_aName, apEntries[i]->m_Score / 10);
+		str_append(aBuf, aLine, sizeof(aBuf));
 	}
-};
-#endif
+	GameServer()->SendMOTD(ClientId, aBuf);
+}
 
-void CServer::SendStatistics()
+void CServer::ShowRank(int ClientId, int ScoreType)
 {
-#ifdef CONF_SQL
-	//Send round statistics
-	CSqlJob* pRoundJob = new CSqlJob_Server_SendRoundStatistics(this, RoundStatistics(), m_aCurrentMap);
-	pRoundJob->Start();
-	
-	//Send player statistics
-	for(int i=0; i<MAX_CLIENTS; i++)
+	if(!m_pLeaderboard)
 	{
-		if(m_aClients[i].m_State == CClient::STATE_INGAME)
-		{
-			if(m_aClients[i].m_UserId >= 0 && RoundStatistics()->IsValidePlayer(i))
-			{
-				CSqlJob* pJob = new CSqlJob_Server_SendPlayerStatistics(this, RoundStatistics()->PlayerStatistics(i), m_aCurrentMap, m_aClients[i].m_UserId, i);
-				pRoundJob->AddQueuedJob(pJob);
-			}
-		}
+		GameServer()->SendChatTarget_Localization(ClientId, CHATCATEGORY_DEFAULT, _("The leaderboard is not available yet"), nullptr);
+		return;
 	}
-#endif
+
+	const CLeaderboard::CEntry *pEntry;
+	int Rank = m_pLeaderboard->Rank(ScoreType, ClientName(ClientId), &pEntry);
+	if(Rank == 0)
+	{
+		GameServer()->SendChatTarget_Localization(ClientId, CHATCATEGORY_DEFAULT, _("You must gain at least one point to see your rank"), nullptr);
+		return;
+	}
+
+	int Score = pEntry->m_Score / 10;
+	GameServer()->SendChatTarget_Localization(ClientId, CHATCATEGORY_DEFAULT, _("You are rank {int:Rank} in {str:Map} ({int:Score} pts in {int:Rounds} rounds)"),
+		"Rank", &Rank,
+		"Map", m_aCurrentMap,
+		"Score", &Score,
+		"Rounds", &pEntry->m_NumRounds,
+		nullptr);
 }
+#endif
 
 void CServer::OnRoundIsOver()
 {
@@ -5,6 +5,7 @@
 
 #include <base/hash.h>
 #include <base/math.h>
+#include <base/tl/mpsc_queue.h>
 
 #include <engine/engine.h>
 #include <engine/server.h>
@@ -12,6 +13,7 @@
 #include <engine/map.h>
 #include <engine/server/netsession.h>
 #include <engine/server/register.h>
+#include <engine/server/register_info.h>
 #include <engine/server/roundstatistics.h>
 #include <engine/shared/demo.h>
 #include <engine/shared/econ.h>
@@ -27,9 +29,13 @@
 #include "base/logger.h"
 /* DDNET MODIFICATION END *********************************************/
 
+#include "login_throttle.h"
+#include "map_cache.h"
 #include "name_ban.h"
+#include "roundstatistics_worker.h"
 
 class CLogMessage;
+class CClientMapJob;
 
 class CSnapIdPool
 {
@@ -101,6 +107,7 @@ class CServer : public IServer
 	class IConsole *m_pConsole;
 	class IStorage *m_pStorage;
 	class IRegister *m_pRegister;
+	CRegisterServerInfo m_RegisterServerInfo;
 
 #if defined(CONF_UPNP)
 	CUPnP m_UPnP;
@@ -280,6 +287,8 @@ public:
 	unsigned char *m_apCurrentMapData[NUM_MAP_TYPES];
 	unsigned int m_aCurrentMapSize[NUM_MAP_TYPES];
 
+	// declared before the recorders, it outlives them
+	CDemoWriter m_DemoWriter;
 	CDemoRecorder m_aDemoRecorder[NUM_RECORDERS];
 
 	int64_t m_ServerInfoFirstRequest;
@@ -287,7 +296,7 @@ public:
 
 	char m_aErrorShutdownReason[128];
 
-	std::vector<CNameBan> m_vNameBans;
+	CNameBans m_NameBans;
 
 	size_t m_AnnouncementLastLine;
 	std::vector<std::string> m_vAnnouncements;
@@ -373,11 +382,13 @@ public:
 		class CCacheChunk
 		{
 		public:
-			CCacheChunk(const void *pData, int Size);
+			CCacheChunk(const void *pHeader, int HeaderSize, const void *pData, int Size);
 			CCacheChunk(const CCacheChunk &) = delete;
 			CCacheChunk(CCacheChunk &&) = default;
 
+			// the finished packet, the token of the request goes in at m_HeaderSize
 			std::vector<uint8_t> m_vData;
+			int m_HeaderSize;
 		};
 
 		std::vector<CCacheChunk> m_vCache;
@@ -386,6 +397,8 @@ public:
 		~CCache();
 
 		void AddChunk(const void *pData, int Size);
+		// the header is sent in front of the token
+		void AddChunk(const void *pHeader, int HeaderSize, const void *pData, int Size);
 		void Clear();
 	};
 	CCache m_aServerInfoCache[3 * 2];
@@ -408,6 +421,7 @@ public:
 
 	bool GetMapReload() const override { return m_MapReload; }
 	void ChangeMap(const char *pMap) override;
+	void PrepareMap(const char *pMapName) override;
 	const char *GetMapName() const override;
 	int LoadMap(const char *pMapName);
 
@@ -440,10 +454,13 @@ public:
 	static void ConNameBan(IConsole::IResult *pResult, void *pUser);
 	static void ConNameUnban(IConsole::IResult *pResult, void *pUser);
 	static void ConNameBans(IConsole::IResult *pResult, void *pUser);
+	static void ConMapCache(IConsole::IResult *pResult, void *pUser);
+	static void ConDemoStats(IConsole::IResult *pResult, void *pUser);
 
 	// console commands for sqlmasters
 	static void ConAddSqlServer(IConsole::IResult *pResult, void *pUserData);
 	static void ConDumpSqlServers(IConsole::IResult *pResult, void *pUserData);
+	static void ConSqlStats(IConsole::IResult *pResult, void *pUserData);
 
 	static void ConSetWeaponFireDelay(class IConsole::IResult *pResult, void *pUserData);
 	static void ConSetWeaponAmmoRegen(class IConsole::IResult *pResult, void *pUserData);
@@ -538,9 +555,38 @@ public:
 	void Register(int ClientId, const char* pUsername, const char* pPassword, const char* pEmail) override;
 	void Login(int ClientId, const char* pUsername, const char* pPassword) override;
 	void Logout(int ClientId) override;
+	void ShowTop10(int ClientId, int ScoreType) override;
+	void ShowRank(int ClientId, int ScoreType) override;
 #endif
 private:
+	bool DatabaseEnabled() const;
+	void UpdateLeaderboard();
+
+	// leaderboard of the current map, null until it is loaded
+	std::unique_ptr<CLeaderboard> m_pLeaderboard;
+	std::shared_ptr<CLeaderboardResult> m_pLeaderboardResult;
+	bool m_LeaderboardRequested = false;
+	// a failed load is requested again at this tick
+	int m_LeaderboardRetryTick = 0;
+	int m_LeaderboardRetryDelay = 0;
+	// scores of the rounds finished before the leaderboard was loaded
+	struct CPendingRound
+	{
+		std::string m_RoundId;
+		std::vector<CSqlRoundStatsData::CScore> m_vScores;
+	};
+	std::vector<CPendingRound> m_vPendingLeaderboardRounds;
+
+
 	bool GenerateClientMap(const char *pMapFilePath, const char *pMapName);
+	void CacheClientMapJob();
+	size_t MapCacheBudget() const;
+
+	// client map converted ahead of time by PrepareMap()
+	std::shared_ptr<CClientMapJob> m_pClientMapJob;
+	// the loaded map, its file is swapped into m_pMap while it is current
+	std::unique_ptr<CPreparedMap> m_pCurrentMap;
+	CMapCache m_MapCache;
 	
 public:
 	class CGameServerCmd
@@ -560,13 +606,18 @@ private:
 	
 #ifdef CONF_SQL
 public:
-	array<CGameServerCmd*> m_lGameServerCmds;
-	LOCK m_GameServerCmdLock;
+	// filled by the sql jobs, drained by the game thread every tick
+	CMpscQueue<CGameServerCmd *, 1024> m_GameServerCmds;
 	LOCK m_ChallengeLock;
 	char m_aChallengeWinner[16];
 	int64_t m_ChallengeRefreshTick;
 	int m_ChallengeType;
 #endif
+	// failed logins per address, only accessed on the game thread
+	CLoginThrottle m_LoginThrottle;
+
+	// tells the client when it has to wait, returns true if it has
+	bool LoginThrottled(int ClientId);
 	int m_LastRegistrationRequestId = 0;
 
 	int m_TimeShiftUnit;
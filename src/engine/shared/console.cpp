@@ -583,7 +583,7 @@ int CConsole::PossibleCommands(const char *pStr, int FlagMask, bool Temp, FPossi
 
 CConsole::CCommand *CConsole::FindCommand(const char *pName, int FlagMask)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->m_pNext)
+	for(CCommand *pCommand = m_apCommandHash[CommandHash(pName)]; pCommand; pCommand = pCommand->m_pNextHash)
 	{
 		if(pCommand->m_Flags & FlagMask)
 		{
@@ -595,6 +595,43 @@ CConsole::CCommand *CConsole::FindCommand(const char *pName, int FlagMask)
 	return 0x0;
 }
 
+unsigned CConsole::CommandHash(const char *pName)
+{
+	// djb2 over the lowercased name, matching str_comp_nocase
+	unsigned Hash = 5381;
+	for(; *pName; pName++)
+	{
+		unsigned char c = *pName;
+		if(c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		Hash = ((Hash << 5) + Hash) + c;
+	}
+	return Hash % COMMAND_HASH_SIZE;
+}
+
+void CConsole::AddCommandHash(CCommand *pCommand)
+{
+	// same ordering as AddCommandSorted so lookups pick the same command as a list walk would
+	CCommand **ppSlot = &m_apCommandHash[CommandHash(pCommand->m_pName)];
+	while(*ppSlot && str_comp(pCommand->m_pName, (*ppSlot)->m_pName) > 0)
+		ppSlot = &(*ppSlot)->m_pNextHash;
+	pCommand->m_pNextHash = *ppSlot;
+	*ppSlot = pCommand;
+}
+
+void CConsole::RemoveCommandHash(CCommand *pCommand)
+{
+	for(CCommand **ppSlot = &m_apCommandHash[CommandHash(pCommand->m_pName)]; *ppSlot; ppSlot = &(*ppSlot)->m_pNextHash)
+	{
+		if(*ppSlot == pCommand)
+		{
+			*ppSlot = pCommand->m_pNextHash;
+			pCommand->m_pNextHash = 0;
+			return;
+		}
+	}
+}
+
 void CConsole::ExecuteLine(const char *pStr, int ClientId, bool InterpretSemicolons)
 {
 	CConsole::ExecuteLineStroked(1, pStr, ClientId, InterpretSemicolons); // press it
@@ -1053,6 +1090,7 @@ CConsole::CConsole(int FlagMask)
 	m_apStrokeStr[1] = "1";
 	m_ExecutionQueue.Reset();
 	m_pFirstCommand = 0;
+	mem_zero(m_apCommandHash, sizeof(m_apCommandHash));
 	m_pFirstExec = 0;
 	mem_zero(m_aPrintCB, sizeof(m_aPrintCB));
 	m_NumPrintCB = 0;
@@ -1173,10 +1211,7 @@ void CConsole::AddCommandSorted(CCommand *pCommand)
 {
 	if(!m_pFirstCommand || str_comp(pCommand->m_pName, m_pFirstCommand->m_pName) <= 0)
 	{
-		if(m_pFirstCommand && m_pFirstCommand->m_pNext)
-			pCommand->m_pNext = m_pFirstCommand;
-		else
-			pCommand->m_pNext = 0;
+		pCommand->m_pNext = m_pFirstCommand;
 		m_pFirstCommand = pCommand;
 	}
 	else
@@ -1191,6 +1226,8 @@ void CConsole::AddCommandSorted(CCommand *pCommand)
 			}
 		}
 	}
+
+	AddCommandHash(pCommand);
 }
 
 void CConsole::Register(const char *pName, const char *pParams,
@@ -1281,6 +1318,7 @@ void CConsole::DeregisterTemp(const char *pName)
 	// add to recycle list
 	if(pRemoved)
 	{
+		RemoveCommandHash(pRemoved);
 		pRemoved->m_pNext = m_pRecycleList;
 		m_pRecycleList = pRemoved;
 	}
@@ -1288,6 +1326,11 @@ void CConsole::DeregisterTemp(const char *pName)
 
 void CConsole::DeregisterTempAll()
 {
+	// drop temp entries from the name index before unlinking them
+	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->m_pNext)
+		if(pCommand->m_Temp)
+			RemoveCommandHash(pCommand);
+
 	// set non temp as first one
 	for(; m_pFirstCommand && m_pFirstCommand->m_Temp; m_pFirstCommand = m_pFirstCommand->m_pNext)
 		;
@@ -14,6 +14,7 @@ class CConsole : public IConsole
 	{
 	public:
 		CCommand *m_pNext;
+		CCommand *m_pNextHash;
 		int m_Flags;
 		bool m_Temp;
 		FCommandCallback m_pfnCallback;
@@ -38,6 +39,17 @@ class CConsole : public IConsole
 	const char *m_apStrokeStr[2];
 	CCommand *m_pFirstCommand;
 
+	// case-insensitive name index over m_pFirstCommand, each bucket chain kept in list order
+	enum
+	{
+		COMMAND_HASH_SIZE = 1024,
+	};
+	CCommand *m_apCommandHash[COMMAND_HASH_SIZE];
+
+	static unsigned CommandHash(const char *pName);
+	void AddCommandHash(CCommand *pCommand);
+	void RemoveCommandHash(CCommand *pCommand);
+
 	class CExecFile
 	{
 	public:
@@ -7,11 +7,18 @@
 #include <base/log.h>
 #include <base/math.h>
 #include <base/system.h>
+#include <engine/engine.h>
 #include <engine/storage.h>
 
+#include "jobs.h"
 #include "uuid_manager.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
 
 static const int DEBUG = 0;
 
@@ -101,44 +108,71 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		return false;
 	}
 
-	// take the CRC of the file and store it
+	// map the whole file for hashing and reading the index, only while opening:
+	// the file may be replaced or truncated while the reader stays around
+	unsigned FileSize = 0;
+	bool FileMapped = true;
+	const unsigned char *pFileData = (const unsigned char *)io_map(File, &FileSize);
+	if(!pFileData)
+	{
+		FileMapped = false;
+		void *pBuffer;
+		io_read_all(File, &pBuffer, &FileSize);
+		pFileData = (const unsigned char *)pBuffer;
+		if(io_error(File))
+		{
+			dbg_msg("datafile", "could not read '%s'", pFilename);
+			free(pBuffer);
+			io_close(File);
+			return false;
+		}
+	}
+	auto &&UnmapFileData = [&]() {
+		if(FileMapped)
+			io_unmap(pFileData, FileSize);
+		else
+			free(const_cast<unsigned char *>(pFileData));
+	};
+	auto &&FreeFileData = [&]() {
+		UnmapFileData();
+		io_close(File);
+	};
+
+	// take the CRC of the file and store it, both hashes share one pass over the file
 	unsigned Crc = 0;
 	SHA256_DIGEST Sha256;
 	{
 		enum
 		{
-			BUFFER_SIZE = 64 * 1024
+			CHUNK_SIZE = 64 * 1024
 		};
 
 		SHA256_CTX Sha256Ctxt;
 		sha256_init(&Sha256Ctxt);
-		unsigned char aBuffer[BUFFER_SIZE];
-
-		while(true)
+		for(unsigned Offset = 0; Offset < FileSize; Offset += CHUNK_SIZE)
 		{
-			unsigned Bytes = io_read(File, aBuffer, BUFFER_SIZE);
-			if(Bytes == 0)
-				break;
-			Crc = crc32(Crc, aBuffer, Bytes);
-			sha256_update(&Sha256Ctxt, aBuffer, Bytes);
+			unsigned Bytes = minimum<unsigned>(CHUNK_SIZE, FileSize - Offset);
+			Crc = crc32(Crc, pFileData + Offset, Bytes);
+			sha256_update(&Sha256Ctxt, pFileData + Offset, Bytes);
 		}
 		Sha256 = sha256_finish(&Sha256Ctxt);
-
-		io_seek(File, 0, IOSEEK_START);
 	}
 
 	// TODO: change this header
 	CDatafileHeader Header;
-	if(sizeof(Header) != io_read(File, &Header, sizeof(Header)))
+	if(FileSize < sizeof(Header))
 	{
 		dbg_msg("datafile", "couldn't load header");
+		FreeFileData();
 		return false;
 	}
+	mem_copy(&Header, pFileData, sizeof(Header));
 	if(Header.m_aId[0] != 'A' || Header.m_aId[1] != 'T' || Header.m_aId[2] != 'A' || Header.m_aId[3] != 'D')
 	{
 		if(Header.m_aId[0] != 'D' || Header.m_aId[1] != 'A' || Header.m_aId[2] != 'T' || Header.m_aId[3] != 'A')
 		{
 			dbg_msg("datafile", "wrong signature. %x %x %x %x", Header.m_aId[0], Header.m_aId[1], Header.m_aId[2], Header.m_aId[3]);
+			FreeFileData();
 			return false;
 		}
 	}
@@ -149,6 +183,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	if(Header.m_Version != 3 && Header.m_Version != 4)
 	{
 		dbg_msg("datafile", "wrong version. version=%x", Header.m_Version);
+		FreeFileData();
 		return false;
 	}
 
@@ -177,18 +212,23 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	mem_zero(pTmpDataFile->m_ppDataPtrs, Header.m_NumRawData * sizeof(void *));
 
 	// read types, offsets, sizes and item data
-	unsigned ReadSize = io_read(File, pTmpDataFile->m_pData, Size);
+	unsigned ReadSize = minimum<unsigned>(Size, FileSize - sizeof(CDatafileHeader));
+	mem_copy(pTmpDataFile->m_pData, pFileData + sizeof(CDatafileHeader), ReadSize);
 	if(ReadSize != Size)
 	{
-		io_close(pTmpDataFile->m_File);
+		FreeFileData();
 		free(pTmpDataFile);
 		dbg_msg("datafile", "couldn't load the whole thing, wanted=%d got=%d", Size, ReadSize);
 		return false;
 	}
+	UnmapFileData();
 
 	Close();
 	m_pDataFile = pTmpDataFile;
 
+	// leave the handle where reading the index would have, for users of File()
+	io_seek(File, m_pDataFile->m_DataStartOffset, IOSEEK_START);
+
 #if defined(CONF_ARCH_ENDIAN_BIG)
 	swap_endian(m_pDataFile->m_pData, sizeof(int), minimum(static_cast<unsigned>(Header.m_Swaplen), Size) / sizeof(int));
 #endif
@@ -239,6 +279,21 @@ IOHANDLE CDataFileReader::File() const
 	return m_pDataFile->m_File;
 }
 
+// the index plus the data items that are currently loaded
+size_t CDataFileReader::MemoryUsage() const
+{
+	if(!m_pDataFile)
+		return 0;
+
+	size_t Usage = m_pDataFile->m_DataStartOffset;
+	for(int i = 0; i < m_pDataFile->m_Header.m_NumRawData; i++)
+	{
+		if(m_pDataFile->m_ppDataPtrs[i])
+			Usage += GetDataSize(i);
+	}
+	return Usage;
+}
+
 int CDataFileReader::NumData() const
 {
 	if(!m_pDataFile)
@@ -336,6 +391,116 @@ void *CDataFileReader::GetDataImpl(int Index, int Swap)
 	return m_pDataFile->m_ppDataPtrs[Index];
 }
 
+class CDataDecompressBatch
+{
+public:
+	struct CTask
+	{
+		const unsigned char *m_pSrc;
+		int m_SrcSize;
+		char *m_pDest;
+		unsigned long m_DestSize;
+	};
+
+	std::vector<CTask> m_vTasks;
+	std::atomic<int> m_NextTask{0};
+	std::atomic<int> m_NumDone{0};
+	// signaled once, by whoever finishes the last task
+	SEMAPHORE m_AllDone;
+
+	CDataDecompressBatch() { sphore_init(&m_AllDone); }
+	~CDataDecompressBatch() { sphore_destroy(&m_AllDone); }
+
+	// returns false once every task has been taken
+	bool RunOne()
+	{
+		int Task = m_NextTask.fetch_add(1);
+		if(Task >= (int)m_vTasks.size())
+			return false;
+		CTask &Current = m_vTasks[Task];
+		uncompress((Bytef *)Current.m_pDest, &Current.m_DestSize, Current.m_pSrc, Current.m_SrcSize);
+		if(m_NumDone.fetch_add(1) + 1 == (int)m_vTasks.size())
+			sphore_signal(&m_AllDone);
+		return true;
+	}
+};
+
+class CDataDecompressJob : public IJob
+{
+	std::shared_ptr<CDataDecompressBatch> m_pBatch;
+
+	void Run() override
+	{
+		while(m_pBatch->RunOne())
+		{
+		}
+	}
+
+public:
+	CDataDecompressJob(std::shared_ptr<CDataDecompressBatch> pBatch) :
+		m_pBatch(std::move(pBatch)) {}
+};
+
+void CDataFileReader::LoadAllData(IEngine *pEngine)
+{
+	if(!m_pDataFile || m_pDataFile->m_Header.m_Version != 4)
+		return;
+
+#if defined(CONF_ARCH_ENDIAN_BIG)
+	// items are swapped depending on how they are requested, keep loading them lazily
+	return;
+#endif
+
+	// read all compressed data with one read, the items are decompressed from it
+	const int DataSize = m_pDataFile->m_Header.m_DataSize;
+	if(DataSize <= 0)
+		return;
+	unsigned char *pFileData = (unsigned char *)malloc(DataSize);
+	if(!pFileData)
+		return;
+	io_seek(m_pDataFile->m_File, m_pDataFile->m_DataStartOffset, IOSEEK_START);
+	const int ReadSize = io_read(m_pDataFile->m_File, pFileData, DataSize);
+
+	std::shared_ptr<CDataDecompressBatch> pBatch = std::make_shared<CDataDecompressBatch>();
+	for(int i = 0; i < m_pDataFile->m_Header.m_NumRawData; i++)
+	{
+		if(m_pDataFile->m_ppDataPtrs[i])
+			continue;
+		// items reaching past the end of a truncated file are cut off
+		const int Offset = clamp(m_pDataFile->m_Info.m_pDataOffsets[i], 0, ReadSize);
+		const int Size = clamp(GetFileDataSize(i), 0, ReadSize - Offset);
+		unsigned long UncompressedSize = m_pDataFile->m_Info.m_pDataSizes[i];
+		m_pDataFile->m_ppDataPtrs[i] = (char *)malloc(UncompressedSize);
+		pBatch->m_vTasks.push_back({pFileData + Offset, Size, m_pDataFile->m_ppDataPtrs[i], UncompressedSize});
+	}
+	if(pBatch->m_vTasks.empty())
+	{
+		free(pFileData);
+		return;
+	}
+
+	// start with the big items so the workers finish at about the same time
+	std::sort(pBatch->m_vTasks.begin(), pBatch->m_vTasks.end(), [](const CDataDecompressBatch::CTask &A, const CDataDecompressBatch::CTask &B) {
+		return A.m_SrcSize > B.m_SrcSize;
+	});
+
+	if(pEngine)
+	{
+		int NumHelpers = minimum<int>(std::thread::hardware_concurrency(), pBatch->m_vTasks.size()) - 1;
+		for(int i = 0; i < NumHelpers; i++)
+			pEngine->AddJob(std::make_shared<CDataDecompressJob>(pBatch));
+	}
+
+	// help out instead of blocking, helpers that start late find nothing left to do
+	while(pBatch->RunOne())
+	{
+	}
+	sphore_wait(&pBatch->m_AllDone);
+	free(pFileData);
+
+	log_trace("datafile", "loaded %d data items", (int)pBatch->m_vTasks.size());
+}
+
 void *CDataFileReader::GetData(int Index)
 {
 	return GetDataImpl(Index, 0);
@@ -10,6 +10,8 @@
 
 #include <zlib.h>
 
+#include <utility>
+
 enum
 {
 	ITEMTYPE_EX = 0xffff,
@@ -34,12 +36,15 @@ public:
 	bool Close();
 	bool IsOpen() const { return m_pDataFile != nullptr; }
 	IOHANDLE File() const;
+	void Swap(CDataFileReader &Other) { std::swap(m_pDataFile, Other.m_pDataFile); }
 
 	void *GetData(int Index);
 	void *GetDataSwapped(int Index); // makes sure that the data is 32bit LE ints when saved
 	int GetDataSize(int Index) const;
 	void UnloadData(int Index);
 	int NumData() const;
+	// decompresses every data item up front, in parallel on the engine's job pool if given
+	void LoadAllData(class IEngine *pEngine);
 
 	void *GetItem(int Index, int *pType = nullptr, int *pId = nullptr);
 	int GetItemSize(int Index) const;
@@ -51,6 +56,7 @@ public:
 	SHA256_DIGEST Sha256() const;
 	unsigned Crc() const;
 	int MapSize() const;
+	size_t MemoryUsage() const;
 };
 
 // write access
@@ -33,9 +33,10 @@ static const int gs_NumMarkersOffset = 176;
 
 static const ColorRGBA gs_DemoPrintColor{0.75f, 0.7f, 0.7f, 1.0f};
 
-CDemoRecorder::CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapData)
+CDemoRecorder::CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapData, CDemoWriter *pWriter)
 {
-	m_File = 0;
+	m_pStream = nullptr;
+	m_pWriter = pWriter;
 	m_aCurrentFilename[0] = '\0';
 	m_pfnFilter = 0;
 	m_pUser = 0;
@@ -65,7 +66,7 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 		return -1;
 	}
 
-	if(m_File)
+	if(m_pStream)
 	{
 		io_close(DemoFile);
 		return -1;
@@ -174,7 +175,6 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 			io_seek(MapFile, 0, IOSEEK_START);
 	}
 
-	m_LastKeyFrame = -1;
 	m_LastTickMarker = -1;
 	m_FirstTick = -1;
 	m_NumTimelineMarkers = 0;
@@ -185,7 +185,7 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 		str_format(aBuf, sizeof(aBuf), "Recording to '%s'", pFilename);
 		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "demo_recorder", aBuf, gs_DemoPrintColor);
 	}
-	m_File = DemoFile;
+	m_pStream = new CDemoStream(DemoFile, m_pSnapshotDelta);
 	str_copy(m_aCurrentFilename, pFilename);
 
 	return 0;
@@ -221,7 +221,7 @@ enum
 	CHUNKFLAG_BIGSIZE = 0x10
 };
 
-void CDemoRecorder::WriteTickMarker(int Tick, int Keyframe)
+void CDemoStream::WriteTickMarker(int Tick, int Keyframe)
 {
 	if(m_LastTickMarker == -1 || Tick - m_LastTickMarker > CHUNKMASK_TICK || Keyframe)
 	{
@@ -242,15 +242,10 @@ void CDemoRecorder::WriteTickMarker(int Tick, int Keyframe)
 	}
 
 	m_LastTickMarker = Tick;
-	if(m_FirstTick < 0)
-		m_FirstTick = Tick;
 }
 
-void CDemoRecorder::Write(int Type, const void *pData, int Size)
+void CDemoStream::Write(int Type, const void *pData, int Size)
 {
-	if(!m_File)
-		return;
-
 	if(Size > 64 * 1024)
 		return;
 
@@ -296,7 +291,7 @@ void CDemoRecorder::Write(int Type, const void *pData, int Size)
 	io_write(m_File, aBuffer2, Size);
 }
 
-void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
+void CDemoStream::RecordSnapshot(int Tick, const void *pData, int Size)
 {
 	if(m_LastKeyFrame == -1 || (Tick - m_LastKeyFrame) > SERVER_TICK_SPEED * 5)
 	{
@@ -328,43 +323,80 @@ void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
 	}
 }
 
-void CDemoRecorder::RecordMessage(const void *pData, int Size)
+void CDemoStream::RecordMessage(const void *pData, int Size)
 {
-	if(m_pfnFilter)
-	{
-		if(m_pfnFilter(pData, Size, m_pUser))
-		{
-			return;
-		}
-	}
 	Write(CHUNKTYPE_MESSAGE, pData, Size);
 }
 
-int CDemoRecorder::Stop()
+void CDemoStream::Finish(int Length, int NumTimelineMarkers, const int *pTimelineMarkers)
 {
-	if(!m_File)
-		return -1;
-
 	// add the demo length to the header
 	io_seek(m_File, gs_LengthOffset, IOSEEK_START);
 	unsigned char aLength[sizeof(int32_t)];
-	uint_to_bytes_be(aLength, Length());
+	uint_to_bytes_be(aLength, Length);
 	io_write(m_File, aLength, sizeof(aLength));
 
 	// add the timeline markers to the header
 	io_seek(m_File, gs_NumMarkersOffset, IOSEEK_START);
 	unsigned char aNumMarkers[sizeof(int32_t)];
-	uint_to_bytes_be(aNumMarkers, m_NumTimelineMarkers);
+	uint_to_bytes_be(aNumMarkers, NumTimelineMarkers);
 	io_write(m_File, aNumMarkers, sizeof(aNumMarkers));
-	for(int i = 0; i < m_NumTimelineMarkers; i++)
+	for(int i = 0; i < NumTimelineMarkers; i++)
 	{
 		unsigned char aMarker[sizeof(int32_t)];
-		uint_to_bytes_be(aMarker, m_aTimelineMarkers[i]);
+		uint_to_bytes_be(aMarker, pTimelineMarkers[i]);
 		io_write(m_File, aMarker, sizeof(aMarker));
 	}
 
 	io_close(m_File);
 	m_File = 0;
+}
+
+void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
+{
+	if(!m_pStream)
+		return;
+
+	m_LastTickMarker = Tick;
+	if(m_FirstTick < 0)
+		m_FirstTick = Tick;
+
+	if(m_pWriter)
+		m_pWriter->Push(m_pStream, CDemoWriter::CHUNK_SNAPSHOT, Tick, pData, Size);
+	else
+		m_pStream->RecordSnapshot(Tick, pData, Size);
+}
+
+void CDemoRecorder::RecordMessage(const void *pData, int Size)
+{
+	if(!m_pStream)
+		return;
+
+	if(m_pfnFilter)
+	{
+		if(m_pfnFilter(pData, Size, m_pUser))
+		{
+			return;
+		}
+	}
+
+	if(m_pWriter)
+		m_pWriter->Push(m_pStream, CDemoWriter::CHUNK_MESSAGE, 0, pData, Size);
+	else
+		m_pStream->RecordMessage(pData, Size);
+}
+
+int CDemoRecorder::Stop()
+{
+	if(!m_pStream)
+		return -1;
+
+	if(m_pWriter)
+		m_pWriter->Finish(m_pStream, Length(), m_NumTimelineMarkers, m_aTimelineMarkers);
+	else
+		m_pStream->Finish(Length(), m_NumTimelineMarkers, m_aTimelineMarkers);
+	delete m_pStream;
+	m_pStream = nullptr;
 	if(m_pConsole)
 		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "demo_recorder", "Stopped recording", gs_DemoPrintColor);
 
@@ -398,6 +430,176 @@ void CDemoRecorder::AddDemoMarker(int Tick)
 		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "demo_recorder", "Added timeline marker", gs_DemoPrintColor);
 }
 
+CDemoWriter::CDemoWriter()
+{
+	m_pQueue = std::make_unique<unsigned char[]>(QUEUE_SIZE);
+	m_pThread = thread_init(ThreadMain, this, "demo writer");
+}
+
+CDemoWriter::~CDemoWriter()
+{
+	{
+		std::unique_lock Lock(m_Mutex);
+		m_Shutdown = true;
+	}
+	m_ChunkCv.notify_all();
+	thread_wait(m_pThread);
+}
+
+void CDemoWriter::SetBackpressure(bool Backpressure)
+{
+	std::unique_lock Lock(m_Mutex);
+	m_Backpressure = Backpressure;
+}
+
+// returns nullptr if the queue is too full, called with the lock held
+unsigned char *CDemoWriter::AllocateChunk(int Size)
+{
+	if(m_QueuedBytes == 0)
+	{
+		m_QueueHead = 0;
+		m_QueueTail = 0;
+	}
+
+	const bool Wrapped = m_QueueTail < m_QueueHead || (m_QueueTail == m_QueueHead && m_QueuedBytes > 0);
+	if(Wrapped)
+	{
+		if(m_QueueHead - m_QueueTail < Size)
+			return nullptr;
+	}
+	else if(QUEUE_SIZE - m_QueueTail < Size)
+	{
+		if(m_QueueHead < Size)
+			return nullptr;
+
+		// skip the rest of the queue, the reader wraps on the marker or when no header fits
+		if(QUEUE_SIZE - m_QueueTail >= (int)sizeof(CChunk))
+		{
+			CChunk Wrap = {nullptr, CHUNK_WRAP, 0, 0};
+			mem_copy(&m_pQueue[m_QueueTail], &Wrap, sizeof(Wrap));
+		}
+		m_QueuedBytes += QUEUE_SIZE - m_QueueTail;
+		m_QueueTail = 0;
+	}
+
+	unsigned char *pChunk = &m_pQueue[m_QueueTail];
+	m_QueueTail += Size;
+	m_QueuedBytes += Size;
+	return pChunk;
+}
+
+bool CDemoWriter::Push(CDemoStream *pStream, int Type, int Tick, const void *pData, int Size, const void *pExtraData, int ExtraSize, bool Wait)
+{
+	// keep the chunks 8 byte aligned
+	const int ChunkSize = (sizeof(CChunk) + Size + ExtraSize + 7) & ~7;
+
+	std::unique_lock Lock(m_Mutex);
+	unsigned char *pChunk = AllocateChunk(ChunkSize);
+	if(!pChunk && (Wait || m_Backpressure))
+	{
+		m_Stats.m_Waits++;
+		m_SpaceCv.wait(Lock, [&]() { return (pChunk = AllocateChunk(ChunkSize)) != nullptr; });
+	}
+	if(!pChunk)
+	{
+		// the writer thread can't keep up, deltas are always made against the
+		// last written snapshot so dropping one doesn't corrupt the demo
+		m_Stats.m_DroppedChunks++;
+		return false;
+	}
+
+	CChunk Chunk = {pStream, Type, Tick, Size + ExtraSize};
+	mem_copy(pChunk, &Chunk, sizeof(Chunk));
+	mem_copy(pChunk + sizeof(Chunk), pData, Size);
+	if(ExtraSize)
+		mem_copy(pChunk + sizeof(Chunk) + Size, pExtraData, ExtraSize);
+	m_Stats.m_Chunks++;
+	m_Stats.m_MaxQueuedBytes = maximum(m_Stats.m_MaxQueuedBytes, m_QueuedBytes);
+	Lock.unlock();
+
+	m_ChunkCv.notify_one();
+	return true;
+}
+
+bool CDemoWriter::Push(CDemoStream *pStream, int Type, int Tick, const void *pData, int Size)
+{
+	if(Size > 64 * 1024)
+		return false;
+	return Push(pStream, Type, Tick, pData, Size, nullptr, 0, false);
+}
+
+void CDemoWriter::Finish(CDemoStream *pStream, int Length, int NumTimelineMarkers, const int *pTimelineMarkers)
+{
+	const int aHeader[2] = {Length, NumTimelineMarkers};
+	Push(pStream, CHUNK_FINISH, 0, aHeader, sizeof(aHeader), pTimelineMarkers, NumTimelineMarkers * sizeof(int), true);
+
+	std::unique_lock Lock(m_Mutex);
+	m_SpaceCv.wait(Lock, [pStream]() { return pStream->m_Finished; });
+}
+
+CDemoWriter::CStats CDemoWriter::Stats()
+{
+	std::unique_lock Lock(m_Mutex);
+	return m_Stats;
+}
+
+void CDemoWriter::ThreadMain(void *pUser)
+{
+	static_cast<CDemoWriter *>(pUser)->Run();
+}
+
+void CDemoWriter::Run()
+{
+	std::unique_lock Lock(m_Mutex);
+	while(true)
+	{
+		m_ChunkCv.wait(Lock, [this]() { return m_QueuedBytes > 0 || m_Shutdown; });
+		if(m_QueuedBytes == 0)
+			break;
+
+		CChunk Chunk;
+		bool Wrap = QUEUE_SIZE - m_QueueHead < (int)sizeof(CChunk);
+		if(!Wrap)
+		{
+			mem_copy(&Chunk, &m_pQueue[m_QueueHead], sizeof(Chunk));
+			Wrap = Chunk.m_Type == CHUNK_WRAP;
+		}
+		if(Wrap)
+		{
+			m_QueuedBytes -= QUEUE_SIZE - m_QueueHead;
+			m_QueueHead = 0;
+			continue;
+		}
+
+		// the chunk stays reserved until it is popped, no need to hold the lock
+		const unsigned char *pData = &m_pQueue[m_QueueHead] + sizeof(CChunk);
+		Lock.unlock();
+
+		if(Chunk.m_Type == CHUNK_SNAPSHOT)
+		{
+			Chunk.m_pStream->RecordSnapshot(Chunk.m_Tick, pData, Chunk.m_Size);
+		}
+		else if(Chunk.m_Type == CHUNK_MESSAGE)
+		{
+			Chunk.m_pStream->RecordMessage(pData, Chunk.m_Size);
+		}
+		else if(Chunk.m_Type == CHUNK_FINISH)
+		{
+			const int *pHeader = (const int *)pData;
+			Chunk.m_pStream->Finish(pHeader[0], pHeader[1], pHeader + 2);
+		}
+
+		Lock.lock();
+		if(Chunk.m_Type == CHUNK_FINISH)
+			Chunk.m_pStream->m_Finished = true;
+		const int ChunkSize = (sizeof(CChunk) + Chunk.m_Size + 7) & ~7;
+		m_QueueHead += ChunkSize;
+		m_QueuedBytes -= ChunkSize;
+		m_Stats.m_Bytes += Chunk.m_Size;
+		m_SpaceCv.notify_all();
+	}
+}
+
 CDemoPlayer::CDemoPlayer(class CSnapshotDelta *pSnapshotDelta, TUpdateIntraTimesFunc &&UpdateIntraTimesFunc)
 {
 	Construct(pSnapshotDelta);
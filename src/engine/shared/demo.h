@@ -7,21 +7,114 @@
 
 #include <engine/demo.h>
 #include <engine/shared/protocol.h>
+#include <condition_variable>
 #include <functional>
+#include <memory>
+#include <mutex>
 
 #include "snapshot.h"
 
 typedef std::function<void()> TUpdateIntraTimesFunc;
 
+// Compresses and writes the chunks of one demo file.
+class CDemoStream
+{
+	IOHANDLE m_File;
+	class CSnapshotDelta *m_pSnapshotDelta;
+	int m_LastTickMarker = -1;
+	int m_LastKeyFrame = -1;
+	unsigned char m_aLastSnapshotData[CSnapshot::MAX_SIZE];
+
+	void WriteTickMarker(int Tick, int Keyframe);
+	void Write(int Type, const void *pData, int Size);
+
+public:
+	bool m_Finished = false; // set by the demo writer
+
+	CDemoStream(IOHANDLE File, class CSnapshotDelta *pSnapshotDelta) :
+		m_File(File), m_pSnapshotDelta(pSnapshotDelta) {}
+
+	void RecordSnapshot(int Tick, const void *pData, int Size);
+	void RecordMessage(const void *pData, int Size);
+	void Finish(int Length, int NumTimelineMarkers, const int *pTimelineMarkers);
+};
+
+// Writer thread shared by demo recorders. The recording thread copies the
+// raw chunks into a bounded queue, compression and file writes happen on
+// the writer thread.
+class CDemoWriter
+{
+public:
+	class CStats
+	{
+	public:
+		int64_t m_Chunks = 0;
+		int64_t m_DroppedChunks = 0;
+		int64_t m_Bytes = 0;
+		int64_t m_Waits = 0;
+		int m_MaxQueuedBytes = 0;
+	};
+
+	enum
+	{
+		CHUNK_SNAPSHOT,
+		CHUNK_MESSAGE,
+		CHUNK_FINISH,
+		CHUNK_WRAP,
+	};
+
+private:
+	enum
+	{
+		QUEUE_SIZE = 8 * 1024 * 1024,
+	};
+
+	struct CChunk
+	{
+		CDemoStream *m_pStream;
+		int m_Type;
+		int m_Tick;
+		int m_Size;
+	};
+
+	std::unique_ptr<unsigned char[]> m_pQueue;
+	int m_QueueHead = 0;
+	int m_QueueTail = 0;
+	int m_QueuedBytes = 0;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_ChunkCv;
+	std::condition_variable m_SpaceCv;
+	bool m_Shutdown = false;
+	bool m_Backpressure = false;
+	CStats m_Stats;
+	void *m_pThread;
+
+	unsigned char *AllocateChunk(int Size);
+	bool Push(CDemoStream *pStream, int Type, int Tick, const void *pData, int Size, const void *pExtraData, int ExtraSize, bool Wait);
+	static void ThreadMain(void *pUser);
+	void Run();
+
+public:
+	CDemoWriter();
+	~CDemoWriter();
+
+	// when the queue is full, wait for the writer instead of dropping chunks
+	void SetBackpressure(bool Backpressure);
+	bool Push(CDemoStream *pStream, int Type, int Tick, const void *pData, int Size);
+	// blocks until the file is complete and closed
+	void Finish(CDemoStream *pStream, int Length, int NumTimelineMarkers, const int *pTimelineMarkers);
+	CStats Stats();
+};
+
 class CDemoRecorder : public IDemoRecorder
 {
 	class IConsole *m_pConsole;
-	IOHANDLE m_File;
+	CDemoStream *m_pStream = nullptr;
+	CDemoWriter *m_pWriter = nullptr;
 	char m_aCurrentFilename[256];
 	int m_LastTickMarker;
-	int m_LastKeyFrame;
 	int m_FirstTick;
-	unsigned char m_aLastSnapshotData[CSnapshot::MAX_SIZE];
 	class CSnapshotDelta *m_pSnapshotDelta;
 	int m_NumTimelineMarkers;
 	int m_aTimelineMarkers[MAX_TIMELINE_MARKERS];
@@ -31,11 +124,8 @@ class CDemoRecorder : public IDemoRecorder
 	DEMOFUNC_FILTER m_pfnFilter;
 	void *m_pUser;
 
-	void WriteTickMarker(int Tick, int Keyframe);
-	void Write(int Type, const void *pData, int Size);
-
 public:
-	CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapData = false);
+	CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapData = false, CDemoWriter *pWriter = nullptr);
 	CDemoRecorder() {}
 
 	int Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetversion, const char *pMap, SHA256_DIGEST *pSha256, unsigned MapCrc, const char *pType, unsigned MapSize, unsigned char *pMapData, IOHANDLE MapFile = nullptr, DEMOFUNC_FILTER pfnFilter = nullptr, void *pUser = nullptr);
@@ -47,7 +137,7 @@ public:
 	void RecordSnapshot(int Tick, const void *pData, int Size);
 	void RecordMessage(const void *pData, int Size);
 
-	bool IsRecording() const override { return m_File != nullptr; }
+	bool IsRecording() const override { return m_pStream != nullptr; }
 	char *GetCurrentFilename() override { return m_aCurrentFilename; }
 	void ClearCurrentFilename() { m_aCurrentFilename[0] = '\0'; }
 
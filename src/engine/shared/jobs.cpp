@@ -1,12 +1,16 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include "jobs.h"
+
+#include <base/math.h>
+
 #include <algorithm>
 
 IJob::IJob() :
-	m_pNext(nullptr),
 	m_State(STATE_QUEUED),
-	m_Abortable(false)
+	m_Abortable(false),
+	m_RunInline(false),
+	m_Priority(PRIORITY_NORMAL)
 {
 }
 
@@ -32,6 +36,21 @@ bool IJob::Abort()
 	return true;
 }
 
+bool IJob::RunInline()
+{
+	// set first, a worker taking the job later must not mistake it as reused
+	m_RunInline = true;
+	EJobState OldStateQueued = STATE_QUEUED;
+	if(!m_State.compare_exchange_strong(OldStateQueued, STATE_RUNNING))
+		return false;
+
+	Run();
+
+	EJobState OldStateRunning = STATE_RUNNING;
+	m_State.compare_exchange_strong(OldStateRunning, STATE_DONE);
+	return true;
+}
+
 void IJob::Abortable(bool Abortable)
 {
 	m_Abortable = Abortable;
@@ -42,9 +61,24 @@ bool IJob::IsAbortable() const
 	return m_Abortable;
 }
 
+void IJob::SetPriority(EJobPriority Priority)
+{
+	m_Priority = Priority;
+}
+
+IJob::EJobPriority IJob::Priority() const
+{
+	return m_Priority;
+}
+
+// the worker of the current thread, jobs it adds go to its own queues
+static thread_local const CJobPool *s_pCurrentPool = nullptr;
+static thread_local int s_CurrentWorker = -1;
+
 CJobPool::CJobPool()
 {
 	m_Shutdown = true;
+	m_NextWorker = 0;
 }
 
 CJobPool::~CJobPool()
@@ -57,30 +91,71 @@ CJobPool::~CJobPool()
 
 void CJobPool::WorkerThread(void *pUser)
 {
-	static_cast<CJobPool *>(pUser)->RunLoop();
+	CWorker *pWorker = static_cast<CWorker *>(pUser);
+	s_pCurrentPool = pWorker->m_pPool;
+	s_CurrentWorker = pWorker->m_Index;
+	pWorker->m_pPool->RunLoop(pWorker->m_Index);
 }
 
-void CJobPool::RunLoop()
+std::shared_ptr<IJob> CJobPool::TakeJobLocked(int WorkerIndex)
 {
-	while(true)
+	const int NumWorkers = m_vpWorkers.size();
+	for(int Priority = 0; Priority < IJob::NUM_PRIORITIES; Priority++)
 	{
-		// wait for job to become available
-		sphore_wait(&m_Semaphore);
+		for(int i = 0; i < NumWorkers; i++)
+		{
+			std::deque<std::shared_ptr<IJob>> &vJobs = m_vpWorkers[(WorkerIndex + i) % NumWorkers]->m_avJobs[Priority];
+			if(!vJobs.empty())
+			{
+				std::shared_ptr<IJob> pJob = std::move(vJobs.front());
+				vJobs.pop_front();
+				return pJob;
+			}
+		}
+	}
+	return nullptr;
+}
 
-		// fetch job from queue
-		std::shared_ptr<IJob> pJob = nullptr;
+std::shared_ptr<IJob> CJobPool::TakeJob(int WorkerIndex)
+{
+	const int NumWorkers = m_vpWorkers.size();
+	for(int Priority = 0; Priority < IJob::NUM_PRIORITIES; Priority++)
+	{
+		// own jobs first, then steal from the others
+		for(int i = 0; i < NumWorkers; i++)
 		{
-			const CLockScope LockScope(m_Lock);
-			if(m_pFirstJob)
+			CWorker *pWorker = m_vpWorkers[(WorkerIndex + i) % NumWorkers].get();
+			const CLockScope LockScope(pWorker->m_Lock);
+			std::deque<std::shared_ptr<IJob>> &vJobs = pWorker->m_avJobs[Priority];
+			if(!vJobs.empty())
 			{
-				pJob = m_pFirstJob;
-				m_pFirstJob = m_pFirstJob->m_pNext;
-				// allow remaining objects in list to destruct, even when current object stays alive
-				pJob->m_pNext = nullptr;
-				if(!m_pFirstJob)
-					m_pLastJob = nullptr;
+				std::shared_ptr<IJob> pJob = std::move(vJobs.front());
+				vJobs.pop_front();
+				return pJob;
 			}
 		}
+	}
+
+	// the scan above can miss the job of our signal, when a worker woken by
+	// a later signal took ours and left its own in a queue we had already
+	// checked. With all queues locked at once, every consumed signal has a
+	// job left, so this only comes up empty when shutting down.
+	for(const std::unique_ptr<CWorker> &pWorker : m_vpWorkers)
+		pWorker->m_Lock.lock();
+	std::shared_ptr<IJob> pJob = TakeJobLocked(WorkerIndex);
+	for(const std::unique_ptr<CWorker> &pWorker : m_vpWorkers)
+		pWorker->m_Lock.unlock();
+	return pJob;
+}
+
+void CJobPool::RunLoop(int WorkerIndex)
+{
+	while(true)
+	{
+		// wait for job to become available
+		sphore_wait(&m_Semaphore);
+		std::shared_ptr<IJob> pJob = TakeJob(WorkerIndex);
+		dbg_assert(pJob || m_Shutdown, "Job pool was signaled without a queued job");
 
 		if(pJob)
 		{
@@ -93,6 +168,11 @@ void CJobPool::RunLoop()
 					pJob->m_State = IJob::STATE_ABORTED;
 					continue;
 				}
+				if(pJob->m_RunInline)
+				{
+					// job was taken back and run by whoever waits for it
+					continue;
+				}
 				dbg_assert(false, "Job state invalid. Job was reused or uninitialized.");
 				dbg_break();
 			}
@@ -118,7 +198,7 @@ void CJobPool::RunLoop()
 				}
 			}
 		}
-		else if(m_Shutdown)
+		else
 		{
 			// shut down worker thread when pool is shutting down and no more jobs are left
 			break;
@@ -131,10 +211,16 @@ void CJobPool::Init(int NumThreads)
 	dbg_assert(m_Shutdown, "Job pool already running");
 	m_Shutdown = false;
 
-	const CLockScope LockScope(m_Lock);
 	sphore_init(&m_Semaphore);
-	m_pFirstJob = nullptr;
-	m_pLastJob = nullptr;
+
+	// without threads the jobs stay queued
+	m_vpWorkers.clear();
+	for(int i = 0; i < maximum(NumThreads, 1); i++)
+	{
+		m_vpWorkers.push_back(std::make_unique<CWorker>());
+		m_vpWorkers.back()->m_pPool = this;
+		m_vpWorkers.back()->m_Index = i;
+	}
 
 	// start worker threads
 	char aName[16]; // unix kernel length limit
@@ -142,7 +228,7 @@ void CJobPool::Init(int NumThreads)
 	for(int i = 0; i < NumThreads; i++)
 	{
 		str_format(aName, sizeof(aName), "CJobPool W%d", i);
-		m_vpThreads.push_back(thread_init(WorkerThread, this, aName));
+		m_vpThreads.push_back(thread_init(WorkerThread, m_vpWorkers[i].get(), aName));
 	}
 }
 
@@ -151,34 +237,14 @@ void CJobPool::Shutdown()
 	dbg_assert(!m_Shutdown, "Job pool already shut down");
 	m_Shutdown = true;
 
-	// abort queued jobs
+	// abort queued jobs, only abortable jobs are removed from the queues
+	for(const std::unique_ptr<CWorker> &pWorker : m_vpWorkers)
 	{
-		const CLockScope LockScope(m_Lock);
-		std::shared_ptr<IJob> pJob = m_pFirstJob;
-		std::shared_ptr<IJob> pPrev = nullptr;
-		while(pJob != nullptr)
+		const CLockScope LockScope(pWorker->m_Lock);
+		for(std::deque<std::shared_ptr<IJob>> &vJobs : pWorker->m_avJobs)
 		{
-			std::shared_ptr<IJob> pNext = pJob->m_pNext;
-			if(pJob->Abort())
-			{
-				// only remove abortable jobs from queue
-				pJob->m_pNext = nullptr;
-				if(pPrev)
-				{
-					pPrev->m_pNext = pNext;
-				}
-				else
-				{
-					m_pFirstJob = pNext;
-				}
-			}
-			else
-			{
-				pPrev = pJob;
-			}
-			pJob = pNext;
+			vJobs.erase(std::remove_if(vJobs.begin(), vJobs.end(), [](const std::shared_ptr<IJob> &pJob) { return pJob->Abort(); }), vJobs.end());
 		}
-		m_pLastJob = pPrev;
 	}
 
 	// abort running jobs
@@ -215,14 +281,13 @@ void CJobPool::Add(std::shared_ptr<IJob> pJob)
 		return;
 	}
 
-	// add job to queue
+	// add job to the queue of the current worker or the next one
+	const int NumWorkers = m_vpWorkers.size();
+	const int WorkerIndex = s_pCurrentPool == this ? s_CurrentWorker : m_NextWorker++ % NumWorkers;
 	{
-		const CLockScope LockScope(m_Lock);
-		if(m_pLastJob)
-			m_pLastJob->m_pNext = pJob;
-		m_pLastJob = std::move(pJob);
-		if(!m_pFirstJob)
-			m_pFirstJob = m_pLastJob;
+		CWorker *pWorker = m_vpWorkers[WorkerIndex].get();
+		const CLockScope LockScope(pWorker->m_Lock);
+		pWorker->m_avJobs[pJob->Priority()].push_back(std::move(pJob));
 	}
 
 	// signal a worker thread that a job is available
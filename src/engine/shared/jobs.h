@@ -50,10 +50,30 @@ public:
 		STATE_ABORTED,
 	};
 
+	/**
+	 * The priority of a job in the job pool. Queued jobs of a higher priority
+	 * are always started first.
+	 */
+	enum EJobPriority
+	{
+		/**
+		 * Short jobs somebody is waiting for, e.g. lookups for connecting players.
+		 */
+		PRIORITY_NORMAL = 0,
+
+		/**
+		 * Large jobs nobody is waiting for, e.g. map conversion or compression.
+		 */
+		PRIORITY_BACKGROUND,
+
+		NUM_PRIORITIES,
+	};
+
 private:
-	std::shared_ptr<IJob> m_pNext;
 	std::atomic<EJobState> m_State;
 	std::atomic<bool> m_Abortable;
+	std::atomic<bool> m_RunInline;
+	EJobPriority m_Priority;
 
 protected:
 	/**
@@ -70,6 +90,15 @@ protected:
 	 */
 	void Abortable(bool Abortable);
 
+	/**
+	 * Sets the priority of this job, @link PRIORITY_NORMAL @endlink by default.
+	 *
+	 * @remark Has no effect once the job has been added to a job pool.
+	 *
+	 * @see Priority
+	 */
+	void SetPriority(EJobPriority Priority);
+
 public:
 	IJob();
 	virtual ~IJob();
@@ -106,6 +135,18 @@ public:
 	 */
 	virtual bool Abort();
 
+	/**
+	 * Runs the job on the calling thread if no worker has started it yet. The
+	 * worker that takes it from the queue later skips it.
+	 *
+	 * @return `true` if the job was run, `false` if it was already started,
+	 * done or aborted.
+	 *
+	 * @remark For callers about to wait for a job, so they don't also wait for
+	 * the jobs queued before it.
+	 */
+	bool RunInline();
+
 	/**
 	 * Returns whether the job can be aborted. Jobs that are abortable may have
 	 * their state set to `STATE_ABORTED` at any point if the job was aborted.
@@ -117,28 +158,51 @@ public:
 	 * @return `true` if the job can be aborted, `false` otherwise.
 	 */
 	bool IsAbortable() const;
+
+	/**
+	 * Returns the priority of the job.
+	 *
+	 * @return Priority of the job.
+	 */
+	EJobPriority Priority() const;
 };
 
 /**
  * A job pool which runs jobs in one or more worker threads.
  *
+ * Every worker has its own queues, one per priority. Jobs added by a worker
+ * go to its own queues, other jobs are spread over the workers. An idle
+ * worker takes the oldest job of the highest priority, first from its own
+ * queues, then from the ones of the other workers.
+ *
  * @see IJob
  */
 class CJobPool
 {
+	class CWorker
+	{
+	public:
+		CJobPool *m_pPool;
+		int m_Index;
+		CLock m_Lock;
+		std::deque<std::shared_ptr<IJob>> m_avJobs[IJob::NUM_PRIORITIES] GUARDED_BY(m_Lock);
+	};
+
+	std::vector<std::unique_ptr<CWorker>> m_vpWorkers;
 	std::vector<void *> m_vpThreads;
 	std::atomic<bool> m_Shutdown;
 
-	CLock m_Lock;
+	// signaled once per added job and once per worker on shutdown
 	SEMAPHORE m_Semaphore;
-	std::shared_ptr<IJob> m_pFirstJob GUARDED_BY(m_Lock);
-	std::shared_ptr<IJob> m_pLastJob GUARDED_BY(m_Lock);
+	std::atomic<unsigned> m_NextWorker;
 
 	CLock m_LockRunning;
 	std::deque<std::shared_ptr<IJob>> m_RunningJobs GUARDED_BY(m_LockRunning);
 
 	static void WorkerThread(void *pUser) NO_THREAD_SAFETY_ANALYSIS;
-	void RunLoop() NO_THREAD_SAFETY_ANALYSIS;
+	void RunLoop(int WorkerIndex) NO_THREAD_SAFETY_ANALYSIS;
+	std::shared_ptr<IJob> TakeJob(int WorkerIndex) NO_THREAD_SAFETY_ANALYSIS;
+	std::shared_ptr<IJob> TakeJobLocked(int WorkerIndex) NO_THREAD_SAFETY_ANALYSIS;
 
 public:
 	CJobPool();
@@ -151,7 +215,7 @@ public:
 	 *
 	 * @remark Must be called on the main thread.
 	 */
-	void Init(int NumThreads) REQUIRES(!m_Lock);
+	void Init(int NumThreads);
 
 	/**
 	 * Shuts down the job pool. Aborts all abortable jobs. Then waits for all
@@ -159,7 +223,7 @@ public:
 	 *
 	 * @remark Must be called on the main thread.
 	 */
-	void Shutdown() REQUIRES(!m_Lock) REQUIRES(!m_LockRunning);
+	void Shutdown() REQUIRES(!m_LockRunning);
 
 	/**
 	 * Adds a job to the queue of the job pool.
@@ -169,6 +233,6 @@ public:
 	 * @remark If the job pool is already shutting down, no additional jobs
 	 * will be enqueue anymore. Abortable jobs will immediately be aborted.
 	 */
-	void Add(std::shared_ptr<IJob> pJob) REQUIRES(!m_Lock);
+	void Add(std::shared_ptr<IJob> pJob);
 };
 #endif
@@ -60,9 +60,25 @@ bool CMap::Load(const char *pMapName)
 	IStorage *pStorage = Kernel()->RequestInterface<IStorage>();
 	if(!pStorage)
 		return false;
+	return Load(pStorage, pMapName);
+}
+
+bool CMap::Load(IStorage *pStorage, const char *pMapName)
+{
 	return m_DataFile.Open(pStorage, pMapName, IStorage::TYPE_ALL);
 }
 
+void CMap::LoadAllData(IEngine *pEngine)
+{
+	m_DataFile.LoadAllData(pEngine);
+}
+
+void CMap::Swap(IEngineMap *pOther)
+{
+	// CMap is the only engine map
+	m_DataFile.Swap(static_cast<CMap *>(pOther)->m_DataFile);
+}
+
 void CMap::Unload()
 {
 	m_DataFile.Close();
@@ -28,9 +28,13 @@ public:
 	int NumItems() const override;
 
 	bool Load(const char *pMapName) override;
+	bool Load(IStorage *pStorage, const char *pMapName);
 	void Unload() override;
 	bool IsLoaded() const override;
 	IOHANDLE File() const override;
+	void LoadAllData(class IEngine *pEngine) override;
+	void Swap(IEngineMap *pOther) override;
+	size_t MemoryUsage() const { return m_DataFile.MemoryUsage(); }
 
 	SHA256_DIGEST Sha256() const override;
 	unsigned Crc() const override;
@@ -7,6 +7,8 @@
 
 #include <engine/shared/config.h>
 
+#include <cmath>
+
 const char *CTuningParams::ms_apNames[] =
 {
 	#define MACRO_TUNING_PARAM(Name, ScriptName, Value, Description) #ScriptName,
@@ -54,6 +56,70 @@ float VelocityRamp(float Value, float Start, float Range, float Curvature)
 	return 1.0f / powf(Curvature, (Value - Start) / Range);
 }
 
+static int GridCell(float Pos)
+{
+	// positions far outside of the map share the outermost cells
+	if(Pos != Pos)
+		return 0;
+	const float CellSize = CWorldCore::GRID_CELL_SIZE;
+	return (int)std::floor(clamp(Pos, -1000000.0f, 1000000.0f) / CellSize);
+}
+
+CWorldCore::CWorldCore()
+{
+	mem_zero(m_apCharacters, sizeof(m_apCharacters));
+	mem_zero(m_aGrid, sizeof(m_aGrid));
+	for(int &Bucket : m_aGridBucket)
+		Bucket = -1;
+	m_UseGrid = true;
+}
+
+int CWorldCore::GridBucket(int CellX, int CellY) const
+{
+	return ((unsigned)CellX * 73856093u ^ (unsigned)CellY * 19349663u) % NUM_GRID_BUCKETS;
+}
+
+uint64_t CWorldCore::FindCharacters(vec2 Min, vec2 Max) const
+{
+	if(!m_UseGrid)
+		return ~(uint64_t)0;
+
+	const int MinX = GridCell(Min.x);
+	const int MaxX = GridCell(Max.x);
+	const int MinY = GridCell(Min.y);
+	const int MaxY = GridCell(Max.y);
+	// a box as large as the grid can contain anyone
+	if(!(Min.x <= Max.x && Min.y <= Max.y) || (MaxX - MinX + 1) * (MaxY - MinY + 1) > NUM_GRID_BUCKETS)
+		return ~(uint64_t)0;
+
+	uint64_t Characters = 0;
+	for(int y = MinY; y <= MaxY; y++)
+		for(int x = MinX; x <= MaxX; x++)
+			Characters |= m_aGrid[GridBucket(x, y)];
+	return Characters;
+}
+
+void CWorldCore::UpdateGrid(int ClientId)
+{
+	const CCharacterCore *pCharCore = m_apCharacters[ClientId];
+	const int Bucket = pCharCore ? GridBucket(GridCell(pCharCore->m_Pos.x), GridCell(pCharCore->m_Pos.y)) : -1;
+	if(Bucket == m_aGridBucket[ClientId])
+		return;
+
+	const uint64_t Bit = (uint64_t)1 << ClientId;
+	if(m_aGridBucket[ClientId] != -1)
+		m_aGrid[m_aGridBucket[ClientId]] &= ~Bit;
+	if(Bucket != -1)
+		m_aGrid[Bucket] |= Bit;
+	m_aGridBucket[ClientId] = Bucket;
+}
+
+void CWorldCore::UpdateGrid()
+{
+	for(int i = 0; i < MAX_CLIENTS; i++)
+		UpdateGrid(i);
+}
+
 const float CCharacterCore::PassengerYOffset = 50;
 
 void CCharacterCore::Init(CWorldCore *pWorld, CCollision *pCollision, CTeamsCore *pTeams)
@@ -120,6 +186,7 @@ void CCharacterCore::Tick(bool UseInput, CParams* pParams)
 		if(m_pCollision->TestBox(m_Pos, PhysicalSizeVec2()))
 		{
 			m_Pos.y += 1;
+			UpdateWorldGrid();
 		}
 		else
 		{
@@ -267,9 +334,16 @@ void CCharacterCore::Tick(bool UseInput, CParams* pParams)
 		// Check against other players first
 		if(m_pWorld)
 		{
+			// a bit more than the hook radius against rounding
+			const vec2 Range = vec2(PhysicalSize() + 3.0f, PhysicalSize() + 3.0f);
+			const uint64_t Candidates = m_pWorld->FindCharacters(
+				vec2(minimum(m_HookPos.x, NewPos.x), minimum(m_HookPos.y, NewPos.y)) - Range,
+				vec2(maximum(m_HookPos.x, NewPos.x), maximum(m_HookPos.y, NewPos.y)) + Range);
 			float Distance = 0.0f;
 			for(int i = 0; i < MAX_CLIENTS; i++)
 			{
+				if(!(Candidates & ((uint64_t)1 << i)))
+					continue;
 				CCharacterCore *pCharCore = m_pWorld->m_apCharacters[i];
 				if (IsRecursePassenger(pCharCore))
 					continue;
@@ -383,8 +457,15 @@ void CCharacterCore::TickDeferred(CParams *pParams)
 
 	if(m_pWorld)
 	{
+		// only close players collide, the hooked one is dragged from anywhere
+		const vec2 Range = vec2(PhysicalSize() * 1.25f + 1.0f, PhysicalSize() * 1.25f + 1.0f);
+		uint64_t Candidates = m_pWorld->FindCharacters(m_Pos - Range, m_Pos + Range);
+		if(m_HookedPlayer >= 0 && m_HookedPlayer < MAX_CLIENTS)
+			Candidates |= (uint64_t)1 << m_HookedPlayer;
 		for(int i = 0; i < MAX_CLIENTS; i++)
 		{
+			if(!(Candidates & ((uint64_t)1 << i)))
+				continue;
 			CCharacterCore *pCharCore = m_pWorld->m_apCharacters[i];
 			if(!pCharCore)
 				continue;
@@ -491,6 +572,10 @@ void CCharacterCore::Move(CParams* pParams)
 		float Distance = distance(m_Pos, NewPos);
 		if(Distance > 0)
 		{
+			const vec2 Range = vec2(PhysicalSize() + 1.0f, PhysicalSize() + 1.0f);
+			const uint64_t Candidates = m_pWorld->FindCharacters(
+				vec2(minimum(m_Pos.x, NewPos.x), minimum(m_Pos.y, NewPos.y)) - Range,
+				vec2(maximum(m_Pos.x, NewPos.x), maximum(m_Pos.y, NewPos.y)) + Range);
 			int End = Distance + 1;
 			vec2 LastPos = m_Pos;
 			for(int i = 0; i < End; i++)
@@ -499,6 +584,8 @@ void CCharacterCore::Move(CParams* pParams)
 				vec2 Pos = mix(m_Pos, NewPos, a);
 				for(int p = 0; p < MAX_CLIENTS; p++)
 				{
+					if(!(Candidates & ((uint64_t)1 << p)))
+						continue;
 					CCharacterCore *pCharCore = m_pWorld->m_apCharacters[p];
 					if(!pCharCore || pCharCore == this)
 						continue;
@@ -511,6 +598,7 @@ void CCharacterCore::Move(CParams* pParams)
 							m_Pos = LastPos;
 						else if(distance(NewPos, pCharCore->m_Pos) > D)
 							m_Pos = NewPos;
+						UpdateWorldGrid();
 						return;
 					}
 				}
@@ -520,6 +608,7 @@ void CCharacterCore::Move(CParams* pParams)
 	}
 
 	m_Pos = NewPos;
+	UpdateWorldGrid();
 }
 
 void CCharacterCore::Write(CNetObj_CharacterCore *pObjCore)
@@ -564,6 +653,13 @@ void CCharacterCore::Quantize()
 	CNetObj_CharacterCore Core;
 	Write(&Core);
 	Read(&Core);
+	UpdateWorldGrid();
+}
+
+void CCharacterCore::UpdateWorldGrid()
+{
+	if(m_pWorld && m_Id >= 0 && m_Id < MAX_CLIENTS && m_pWorld->m_apCharacters[m_Id] == this)
+		m_pWorld->UpdateGrid(m_Id);
 }
 
 void CCharacterCore::SetHookedPlayer(int HookedPlayer)
@@ -685,6 +781,7 @@ void CCharacterCore::UpdateTaxiPassengers()
 
 			pPassenger->m_Pos.x = m_Pos.x;
 			pPassenger->m_Pos.y = m_Pos.y - PassengerYOffset * PassengerNumber;
+			pPassenger->UpdateWorldGrid();
 
 			pPassenger = pPassenger->m_Passenger;
 		}
@@ -197,13 +197,31 @@ struct SSwitchers
 class CWorldCore
 {
 public:
-	CWorldCore()
+	enum
 	{
-		mem_zero(m_apCharacters, sizeof(m_apCharacters));
-	}
+		GRID_CELL_SIZE = 128,
+		NUM_GRID_BUCKETS = 256,
+	};
+
+	CWorldCore();
 
 	CTuningParams m_Tuning;
 	class CCharacterCore *m_apCharacters[MAX_CLIENTS];
+
+	// the ids of the characters that may be inside the box as a bit mask, a
+	// superset of the ones that are. It uses the positions of the last
+	// UpdateGrid of each character.
+	uint64_t FindCharacters(vec2 Min, vec2 Max) const;
+	void UpdateGrid(int ClientId);
+	void UpdateGrid();
+	// without the grid every character is a candidate, like the full scans
+	bool m_UseGrid;
+
+private:
+	static_assert(MAX_CLIENTS <= 64, "the grid keeps the characters of a bucket in a 64 bit mask");
+	int GridBucket(int CellX, int CellY) const;
+	uint64_t m_aGrid[NUM_GRID_BUCKETS];
+	int m_aGridBucket[MAX_CLIENTS];
 };
 
 class CCharacterCore
@@ -274,6 +292,9 @@ public:
 	void Write(CNetObj_CharacterCore *pObjCore);
 	void Quantize();
 
+	// tells the world about a new position, whoever changes m_Pos has to call it
+	void UpdateWorldGrid();
+
 	// DDRace
 
 	int m_Id;
@@ -61,6 +61,7 @@ bool CCharacter::Spawn(CPlayer *pPlayer, vec2 Pos)
 	m_Core.m_Pos = GetPos();
 	m_Core.m_Id = m_pPlayer->GetCid();
 	GameServer()->m_World.m_Core.m_apCharacters[m_pPlayer->GetCid()] = &m_Core;
+	m_Core.UpdateWorldGrid();
 
 	m_ReckoningTick = 0;
 	m_SendCore = CCharacterCore();
@@ -743,11 +744,13 @@ void CCharacter::DDRaceInit()
 void CCharacter::SetPosition(const vec2 &Position)
 {
 	m_Core.m_Pos = Position;
+	m_Core.UpdateWorldGrid();
 }
 
 void CCharacter::Move(vec2 RelPos)
 {
 	m_Core.m_Pos += RelPos;
+	m_Core.UpdateWorldGrid();
 }
 
 void CCharacter::ResetVelocity()
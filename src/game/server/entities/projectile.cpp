@@ -140,6 +140,14 @@ void CProjectile::Snap(int SnappingClient)
 		FillInfo(pProj);
 }
 
+bool CProjectile::SnapBounds(vec2 *pMin, vec2 *pMax)
+{
+	float Ct = (Server()->Tick()-m_StartTick)/(float)Server()->TickSpeed();
+	*pMin = GetPos(Ct);
+	*pMax = *pMin;
+	return true;
+}
+
 /* INFECTION MODIFICATION START ***************************************/
 void CProjectile::FlashGrenade()
 {
@@ -20,6 +20,7 @@ public:
 	void Tick() override;
 	void TickPaused() override;
 	void Snap(int SnappingClient) override;
+	bool SnapBounds(vec2 *pMin, vec2 *pMax) override;
 
 private:
 	vec2 m_Direction;
@@ -105,6 +105,21 @@ public:
 	*/
 	virtual void Snap(int SnappingClient) {}
 
+	/*
+		Function: SnapBounds
+			Gives the box that has to be in the view of a client for
+			Snap to add anything for it. Snap is not called for the
+			clients that can't see the box.
+
+		Arguments:
+			pMin - Top left corner of the box.
+			pMax - Bottom right corner of the box.
+
+		Returns:
+			False if the entity has to be snapped for every client.
+	*/
+	virtual bool SnapBounds(vec2 *pMin, vec2 *pMax) { return false; }
+
 	/*
 		Function: NetworkClipped
 			Performs a series of test to see if a client can see the
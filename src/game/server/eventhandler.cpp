@@ -5,12 +5,36 @@
 
 #include <game/server/player.h>
 
+#include <algorithm>
+#include <cmath>
+
+static int EventPriority(int Type)
+{
+	switch(Type)
+	{
+	case NETEVENTTYPE_SOUNDWORLD:
+	case NETEVENTTYPE_DAMAGEIND:
+		return CEventHandler::PRIORITY_LOW;
+	case NETEVENTTYPE_EXPLOSION:
+	case NETEVENTTYPE_SPAWN:
+	case NETEVENTTYPE_DEATH:
+		return CEventHandler::PRIORITY_HIGH;
+	default:
+		return CEventHandler::PRIORITY_NORMAL;
+	}
+}
+
 //////////////////////////////////////////////////
 // Event handler
 //////////////////////////////////////////////////
 CEventHandler::CEventHandler()
 {
 	m_pGameServer = 0;
+	for(int64_t &NumDropped : m_aNumDropped)
+		NumDropped = 0;
+	m_MaxNumEvents = 0;
+	m_GridWidth = 0;
+	m_GridHeight = 0;
 	Clear();
 }
 
@@ -21,39 +45,119 @@ void CEventHandler::SetGameServer(CGameContext *pGameServer)
 
 void *CEventHandler::Create(int Type, int Size, int64_t Mask)
 {
-	if(m_NumEvents == MAX_EVENTS)
-		return 0;
-	if(m_CurrentOffset+Size >= MAX_DATASIZE)
-		return 0;
+	dbg_assert(Size <= MAX_EVENT_SIZE, "event too large");
+
+	const int Priority = EventPriority(Type);
+	int Index = m_vEvents.size();
+	if(Index == MAX_EVENTS)
+	{
+		// replace the latest of the least important events
+		int Replaced = 0;
+		while(Replaced < Priority && m_avPriorityEvents[Replaced].empty())
+			Replaced++;
+		m_aNumDropped[Replaced]++;
+		if(Replaced == Priority)
+			return 0;
+		Index = m_avPriorityEvents[Replaced].back();
+		m_avPriorityEvents[Replaced].pop_back();
+	}
+	else
+	{
+		m_vEvents.emplace_back();
+		m_MaxNumEvents = maximum(m_MaxNumEvents, (int)m_vEvents.size());
+	}
 
-	void *p = &m_aData[m_CurrentOffset];
-	m_aOffsets[m_NumEvents] = m_CurrentOffset;
-	m_aTypes[m_NumEvents] = Type;
-	m_aSizes[m_NumEvents] = Size;
-	m_aClientMasks[m_NumEvents] = Mask;
-	m_CurrentOffset += Size;
-	m_NumEvents++;
-	return p;
+	CEvent *pEvent = &m_vEvents[Index];
+	pEvent->m_Type = Type;
+	pEvent->m_Size = Size;
+	pEvent->m_ClientMask = Mask;
+	mem_zero(pEvent->m_aData, sizeof(pEvent->m_aData));
+	m_avPriorityEvents[Priority].push_back(Index);
+	m_GridDirty = true;
+	return pEvent->m_aData;
 }
 
 void CEventHandler::Clear()
 {
-	m_NumEvents = 0;
-	m_CurrentOffset = 0;
+	m_vEvents.clear();
+	for(std::vector<int> &vEvents : m_avPriorityEvents)
+		vEvents.clear();
+	m_GridDirty = true;
+}
+
+int CEventHandler::Cell(float Pos, int NumCells) const
+{
+	return clamp((int)std::floor(Pos / CELL_SIZE), 0, NumCells - 1);
+}
+
+void CEventHandler::UpdateGrid()
+{
+	if(!m_GridDirty)
+		return;
+	m_GridDirty = false;
+
+	// events outside of the map are put into the border cells
+	m_GridWidth = maximum(1, (int)std::ceil(GameServer()->Collision()->GetWidth() * 32 / CELL_SIZE));
+	m_GridHeight = maximum(1, (int)std::ceil(GameServer()->Collision()->GetHeight() * 32 / CELL_SIZE));
+	m_vCellStart.assign(m_GridWidth * m_GridHeight + 1, 0);
+	m_vCellEvents.resize(m_vEvents.size());
+
+	m_vEventCells.resize(m_vEvents.size());
+	for(int i = 0; i < (int)m_vEvents.size(); i++)
+	{
+		const CNetEvent_Common *pCommon = (const CNetEvent_Common *)m_vEvents[i].m_aData;
+		m_vEventCells[i] = Cell(pCommon->m_Y, m_GridHeight) * m_GridWidth + Cell(pCommon->m_X, m_GridWidth);
+		m_vCellStart[m_vEventCells[i] + 1]++;
+	}
+	for(int c = 1; c < (int)m_vCellStart.size(); c++)
+		m_vCellStart[c] += m_vCellStart[c - 1];
+	// m_vCellStart[c] is the start of cell c now, fill the cells in the order of the events
+	for(int i = 0; i < (int)m_vEvents.size(); i++)
+		m_vCellEvents[m_vCellStart[m_vEventCells[i]]++] = i;
+	// filling moved every start to the start of the next cell
+	for(int c = m_vCellStart.size() - 1; c > 0; c--)
+		m_vCellStart[c] = m_vCellStart[c - 1];
+	m_vCellStart[0] = 0;
 }
 
 void CEventHandler::Snap(int SnappingClient)
 {
-	for(int i = 0; i < m_NumEvents; i++)
+	m_vVisible.clear();
+	if(SnappingClient == -1)
+	{
+		for(int i = 0; i < (int)m_vEvents.size(); i++)
+			m_vVisible.push_back(i);
+	}
+	else
+	{
+		// only the cells in range of the client
+		UpdateGrid();
+		const vec2 ViewPos = GameServer()->m_apPlayers[SnappingClient]->m_ViewPos;
+		const int MinX = Cell(ViewPos.x - SNAP_RANGE, m_GridWidth);
+		const int MaxX = Cell(ViewPos.x + SNAP_RANGE, m_GridWidth);
+		const int MinY = Cell(ViewPos.y - SNAP_RANGE, m_GridHeight);
+		const int MaxY = Cell(ViewPos.y + SNAP_RANGE, m_GridHeight);
+		for(int y = MinY; y <= MaxY; y++)
+		{
+			// the cells of a row are next to each other
+			const int First = y * m_GridWidth + MinX;
+			const int Last = y * m_GridWidth + MaxX;
+			m_vVisible.insert(m_vVisible.end(), m_vCellEvents.begin() + m_vCellStart[First], m_vCellEvents.begin() + m_vCellStart[Last + 1]);
+		}
+		std::sort(m_vVisible.begin(), m_vVisible.end());
+	}
+
+	for(int i : m_vVisible)
 	{
-		if(SnappingClient == -1 || CmaskIsSet(m_aClientMasks[i], SnappingClient))
+		const CEvent &Event = m_vEvents[i];
+		if(SnappingClient == -1 || CmaskIsSet(Event.m_ClientMask, SnappingClient))
 		{
-			CNetEvent_Common *ev = (CNetEvent_Common *)&m_aData[m_aOffsets[i]];
-			if(SnappingClient == -1 || distance(GameServer()->m_apPlayers[SnappingClient]->m_ViewPos, vec2(ev->m_X, ev->m_Y)) < 1500.0f)
+			const CNetEvent_Common *ev = (const CNetEvent_Common *)Event.m_aData;
+			if(SnappingClient == -1 || distance(GameServer()->m_apPlayers[SnappingClient]->m_ViewPos, vec2(ev->m_X, ev->m_Y)) < SNAP_RANGE)
 			{
-				void *d = GameServer()->Server()->SnapNewItem(m_aTypes[i], i, m_aSizes[i]);
+				void *d = GameServer()->Server()->SnapNewItem(Event.m_Type, i, Event.m_Size);
 				if(d)
-					mem_copy(d, &m_aData[m_aOffsets[i]], m_aSizes[i]);
+					mem_copy(d, Event.m_aData, Event.m_Size);
 			}
 		}
 	}
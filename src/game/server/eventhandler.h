@@ -5,21 +5,55 @@
 
 #include <base/system.h>
 
+#include <vector>
+
 class CEventHandler
 {
-	static const int MAX_EVENTS = 128;
-	static const int MAX_DATASIZE = 128*64;
+public:
+	enum
+	{
+		// the ids of the snapshot items
+		MAX_EVENTS = 1024,
+		MAX_EVENT_SIZE = 32,
+
+		// a full handler drops the least important events first
+		PRIORITY_LOW = 0, // sounds and damage indicators
+		PRIORITY_NORMAL,
+		PRIORITY_HIGH, // explosions, spawns and deaths
+		NUM_PRIORITIES,
+	};
+
+private:
+	// events are only sent to clients closer than this
+	static constexpr float SNAP_RANGE = 1500.0f;
+	static constexpr float CELL_SIZE = 1024.0f;
 
-	int m_aTypes[MAX_EVENTS]; // TODO: remove some of these arrays
-	int m_aOffsets[MAX_EVENTS];
-	int m_aSizes[MAX_EVENTS];
-	int64_t m_aClientMasks[MAX_EVENTS];
-	char m_aData[MAX_DATASIZE];
+	struct CEvent
+	{
+		int m_Type;
+		int m_Size;
+		int64_t m_ClientMask;
+		alignas(int64_t) char m_aData[MAX_EVENT_SIZE];
+	};
+	std::vector<CEvent> m_vEvents;
+	std::vector<int> m_avPriorityEvents[NUM_PRIORITIES];
+
+	int64_t m_aNumDropped[NUM_PRIORITIES];
+	int m_MaxNumEvents;
+
+	// events by cell of their position, built on the first snap after a change
+	bool m_GridDirty;
+	int m_GridWidth;
+	int m_GridHeight;
+	std::vector<int> m_vCellStart;
+	std::vector<int> m_vCellEvents;
+	std::vector<int> m_vEventCells;
+	std::vector<int> m_vVisible;
+	int Cell(float Pos, int NumCells) const;
+	void UpdateGrid();
 
 	class CGameContext *m_pGameServer;
 
-	int m_CurrentOffset;
-	int m_NumEvents;
 public:
 	CGameContext *GameServer() const { return m_pGameServer; }
 	void SetGameServer(CGameContext *pGameServer);
@@ -28,6 +62,10 @@ public:
 	void *Create(int Type, int Size, int64_t Mask = -1LL);
 	void Clear();
 	void Snap(int SnappingClient);
+
+	int64_t NumDropped(int Priority) const { return m_aNumDropped[Priority]; }
+	// most events between two snapshots so far
+	int MaxNumEvents() const { return m_MaxNumEvents; }
 };
 
 #endif
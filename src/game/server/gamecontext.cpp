@@ -7,6 +7,7 @@
 #include <engine/shared/config.h>
 #include <engine/map.h>
 #include <engine/console.h>
+#include <engine/engine.h>
 #include <engine/storage.h>
 #include <engine/server/roundstatistics.h>
 #include <engine/server/sql_server.h>
@@ -67,7 +68,6 @@ enum
 };
 
 /* INFECTION MODIFICATION START ***************************************/
-bool CGameContext::m_ClientMuted[MAX_CLIENTS][MAX_CLIENTS];
 icArray<std::string, 256> CGameContext::m_aChangeLogEntries;
 icArray<uint32_t, 16> CGameContext::m_aChangeLogPageIndices;
 
@@ -88,16 +88,26 @@ void CGameContext::Construct(int Resetting)
 	{
 		m_apPlayers[i] = 0;
 		m_aHitSoundState[i] = 0;
+		m_aGeolocationFlagCountry[i] = -1;
 	}
 
 	mem_zero(&m_aLastPlayerInput, sizeof(m_aLastPlayerInput));
 	mem_zero(&m_aPlayerHasInput, sizeof(m_aPlayerHasInput));
 
+	for(auto &Entry : m_aLocalizedTextCache)
+	{
+		Entry.m_Key = 0;
+		Entry.m_pText = nullptr;
+		Entry.m_LanguageHandle = LOCALIZED_TEXT_NO_LANGUAGE;
+		Entry.m_Plural = false;
+		Entry.m_Number = 0;
+	}
+
 	if(Resetting==NO_RESET) // first init
 	{
 		for(int i = 0; i < MAX_CLIENTS; i++)
 			for(int j = 0; j < MAX_CLIENTS; j++)
-				CGameContext::m_ClientMuted[i][j] = false;
+				m_ClientMuted[i][j] = false;
 	}
 
 	m_pController = 0;
@@ -159,6 +169,17 @@ void CGameContext::Clear()
 	CVoteOptionServer *pVoteOptionLast = m_pVoteOptionLast;
 	int NumVoteOptions = m_NumVoteOptions;
 	CTuningParams Tuning = m_Tuning;
+	// mutes outlive the map like the clients
+	bool aaClientMuted[MAX_CLIENTS][MAX_CLIENTS];
+	mem_copy(aaClientMuted, m_ClientMuted, sizeof(aaClientMuted));
+	// country lookups still running are applied once the player is back in game
+	std::shared_ptr<CGeolocationJob> apGeolocationJobs[MAX_CLIENTS];
+	int aGeolocationFlagCountry[MAX_CLIENTS];
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		apGeolocationJobs[i] = std::move(m_apGeolocationJobs[i]);
+		aGeolocationFlagCountry[i] = m_aGeolocationFlagCountry[i];
+	}
 
 	m_Resetting = true;
 	this->~CGameContext();
@@ -169,6 +190,12 @@ void CGameContext::Clear()
 	m_pVoteOptionLast = pVoteOptionLast;
 	m_NumVoteOptions = NumVoteOptions;
 	m_Tuning = Tuning;
+	mem_copy(m_ClientMuted, aaClientMuted, sizeof(m_ClientMuted));
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		m_apGeolocationJobs[i] = std::move(apGeolocationJobs[i]);
+		m_aGeolocationFlagCountry[i] = aGeolocationFlagCountry[i];
+	}
 	
 	for(int i=0; i<MAX_CLIENTS; i++)
 	{
@@ -488,6 +515,8 @@ void CGameContext::SendChatTarget_Localization(int To, int Category, const char*
 	va_list VarArgs;
 	va_start(VarArgs, pText);
 
+	const uint64_t FormatKey = CLocalization::FormatKey_V(pText, VarArgs);
+
 	bool Sent = false;
 	for(int i = Start; i < End; i++)
 	{
@@ -495,7 +524,7 @@ void CGameContext::SendChatTarget_Localization(int To, int Category, const char*
 		{
 			Buffer.clear();
 			Buffer.append(GetChatCategoryPrefix(Category));
-			Server()->Localization()->Format_VL(Buffer, m_apPlayers[i]->GetLanguage(), pText, VarArgs);
+			Buffer.append(FormatLocalized(m_apPlayers[i]->GetLanguageHandle(), FormatKey, pText, VarArgs));
 			
 			Msg.m_pMessage = Buffer.buffer();
 			Server()->SendPackMsg(&Msg, MSGFLAG_VITAL|MSGFLAG_NORECORD, i);
@@ -505,13 +534,11 @@ void CGameContext::SendChatTarget_Localization(int To, int Category, const char*
 
 	if(To < 0 && Sent)
 	{
+		// one message for record
 		Buffer.clear();
 		Buffer.append(GetChatCategoryPrefix(Category));
-		// one message for record
-		dynamic_string tmpBuf;
-		tmpBuf.copy(Buffer);
-		Server()->Localization()->Format_VL(tmpBuf, "en", pText, VarArgs);
-		Msg.m_pMessage = tmpBuf.buffer();
+		Buffer.append(FormatLocalized(Server()->Localization()->GetLanguageHandle("en"), FormatKey, pText, VarArgs));
+		Msg.m_pMessage = Buffer.buffer();
 		Server()->SendPackMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_NOSEND, -1);
 
 		char aBuf[256];
@@ -536,6 +563,8 @@ void CGameContext::SendChatTarget_Localization_P(int To, int Category, int Numbe
 	va_list VarArgs;
 	va_start(VarArgs, pText);
 
+	const uint64_t FormatKey = CLocalization::FormatKey_V(pText, VarArgs);
+
 	bool Sent = false;
 	for(int i = Start; i < End; i++)
 	{
@@ -543,7 +572,7 @@ void CGameContext::SendChatTarget_Localization_P(int To, int Category, int Numbe
 		{
 			Buffer.clear();
 			Buffer.append(GetChatCategoryPrefix(Category));
-			Server()->Localization()->Format_VLP(Buffer, m_apPlayers[i]->GetLanguage(), Number, pText, VarArgs);
+			Buffer.append(FormatLocalized_P(m_apPlayers[i]->GetLanguageHandle(), FormatKey, Number, pText, VarArgs));
 			
 			Msg.m_pMessage = Buffer.buffer();
 			Server()->SendPackMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_NORECORD, i);
@@ -553,13 +582,11 @@ void CGameContext::SendChatTarget_Localization_P(int To, int Category, int Numbe
 
 	if(To < 0 && Sent)
 	{
+		// one message for record
 		Buffer.clear();
 		Buffer.append(GetChatCategoryPrefix(Category));
-		// one message for record
-		dynamic_string tmpBuf;
-		tmpBuf.copy(Buffer);
-		Server()->Localization()->Format_VLP(tmpBuf, "en", Number, pText, VarArgs);
-		Msg.m_pMessage = tmpBuf.buffer();
+		Buffer.append(FormatLocalized_P(Server()->Localization()->GetLanguageHandle("en"), FormatKey, Number, pText, VarArgs));
+		Msg.m_pMessage = Buffer.buffer();
 		Server()->SendPackMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_NOSEND, -1);
 	}
 
@@ -588,7 +615,7 @@ void CGameContext::SendMOTD_Localization(int To, const char* pText, ...)
 		va_list VarArgs;
 		va_start(VarArgs, pText);
 		
-		Server()->Localization()->Format_VL(Buffer, m_apPlayers[To]->GetLanguage(), pText, VarArgs);
+		Server()->Localization()->Format_VL(Buffer, m_apPlayers[To]->GetLanguageHandle(), pText, VarArgs);
 	
 		va_end(VarArgs);
 		
@@ -768,17 +795,16 @@ void CGameContext::SendBroadcast_Localization(int To, int Priority, int LifeSpan
 	int Start = (To < 0 ? 0 : To);
 	int End = (To < 0 ? MAX_CLIENTS : To+1);
 	
-	dynamic_string Buffer;
-	
 	va_list VarArgs;
 	va_start(VarArgs, pText);
+
+	const uint64_t FormatKey = CLocalization::FormatKey_V(pText, VarArgs);
 	
 	// only for server demo record
 	if(To < 0)
 	{
 		CNetMsg_Sv_Broadcast Msg;
-		Server()->Localization()->Format_VL(Buffer, "en", pText, VarArgs);
-		Msg.m_pMessage = Buffer.buffer();
+		Msg.m_pMessage = FormatLocalized(Server()->Localization()->GetLanguageHandle("en"), FormatKey, pText, VarArgs);
 		Server()->SendPackMsg(&Msg, MSGFLAG_VITAL|MSGFLAG_NOSEND, -1);
 	}
 
@@ -786,9 +812,7 @@ void CGameContext::SendBroadcast_Localization(int To, int Priority, int LifeSpan
 	{
 		if(m_apPlayers[i] && !m_apPlayers[i]->IsBot())
 		{
-			Buffer.clear();
-			Server()->Localization()->Format_VL(Buffer, m_apPlayers[i]->GetLanguage(), pText, VarArgs);
-			AddBroadcast(i, Buffer.buffer(), Priority, LifeSpan);
+			AddBroadcast(i, FormatLocalized(m_apPlayers[i]->GetLanguageHandle(), FormatKey, pText, VarArgs), Priority, LifeSpan);
 		}
 	}
 	
@@ -800,23 +824,68 @@ void CGameContext::SendBroadcast_Localization_P(int To, int Priority, int LifeSp
 	int Start = (To < 0 ? 0 : To);
 	int End = (To < 0 ? MAX_CLIENTS : To+1);
 	
-	dynamic_string Buffer;
-	
 	va_list VarArgs;
 	va_start(VarArgs, pText);
+
+	const uint64_t FormatKey = CLocalization::FormatKey_V(pText, VarArgs);
 	
 	for(int i = Start; i < End; i++)
 	{
 		if(m_apPlayers[i] && !m_apPlayers[i]->IsBot())
 		{
-			Server()->Localization()->Format_VLP(Buffer, m_apPlayers[i]->GetLanguage(), Number, pText, VarArgs);
-			AddBroadcast(i, Buffer.buffer(), Priority, LifeSpan);
+			AddBroadcast(i, FormatLocalized_P(m_apPlayers[i]->GetLanguageHandle(), FormatKey, Number, pText, VarArgs), Priority, LifeSpan);
 		}
 	}
 
 	va_end(VarArgs);
 }
 
+CGameContext::CLocalizedTextCacheEntry *CGameContext::FindLocalizedText(int LanguageHandle, uint64_t Key, const char *pText, bool Plural, int Number, bool *pFound)
+{
+	CLocalizedTextCacheEntry *pEntry = &m_aLocalizedTextCache[(Key ^ (LanguageHandle * 0x9E3779B97F4A7C15ULL)) % LOCALIZED_TEXT_CACHE_SIZE];
+	*pFound = pEntry->m_Key == Key && pEntry->m_pText == pText && pEntry->m_LanguageHandle == LanguageHandle &&
+		  pEntry->m_Plural == Plural && (!Plural || pEntry->m_Number == Number);
+	if(!*pFound)
+	{
+		pEntry->m_Key = Key;
+		pEntry->m_pText = pText;
+		pEntry->m_LanguageHandle = LanguageHandle;
+		pEntry->m_Plural = Plural;
+		pEntry->m_Number = Number;
+	}
+	return pEntry;
+}
+
+const char *CGameContext::FormatLocalized(int LanguageHandle, uint64_t FormatKey, const char *pText, va_list VarArgs)
+{
+	bool Found;
+	CLocalizedTextCacheEntry *pEntry = FindLocalizedText(LanguageHandle, FormatKey, pText, false, 0, &Found);
+	if(!Found)
+	{
+		dynamic_string Buffer;
+		Server()->Localization()->Format_VL(Buffer, LanguageHandle, pText, VarArgs);
+		pEntry->m_Text = Buffer.buffer();
+	}
+	return pEntry->m_Text.c_str();
+}
+
+const char *CGameContext::FormatLocalized_P(int LanguageHandle, uint64_t FormatKey, int Number, const char *pText, va_list VarArgs)
+{
+	// Mix the plural number in so that it selects a different slot than the
+	// same template formatted without a plural form
+	FormatKey = (FormatKey ^ (static_cast<uint64_t>(static_cast<uint32_t>(Number)) | (1ULL << 32))) * 1099511628211ULL;
+
+	bool Found;
+	CLocalizedTextCacheEntry *pEntry = FindLocalizedText(LanguageHandle, FormatKey, pText, true, Number, &Found);
+	if(!Found)
+	{
+		dynamic_string Buffer;
+		Server()->Localization()->Format_VLP(Buffer, LanguageHandle, Number, pText, VarArgs);
+		pEntry->m_Text = Buffer.buffer();
+	}
+	return pEntry->m_Text.c_str();
+}
+
 /* INFECTION MODIFICATION END *****************************************/
 
 void CGameContext::SendChat(int ChatterClientId, int Team, const char *pText, int SpamProtectionClientId)
@@ -861,7 +930,7 @@ void CGameContext::SendChat(int ChatterClientId, int Team, const char *pText, in
 		// send to the clients that did not mute chatter
 		for(int i = 0; i < MAX_CLIENTS; i++)
 		{
-			if(m_apPlayers[i] && !CGameContext::m_ClientMuted[i][SpamProtectionClientId])
+			if(m_apPlayers[i] && !m_ClientMuted[i][SpamProtectionClientId])
 			{
 				Server()->SendPackMsg(&Msg, MSGFLAG_VITAL|MSGFLAG_NORECORD, i);
 			}
@@ -1283,6 +1352,17 @@ void CGameContext::OnTick()
 			
 			m_apPlayers[i]->Tick();
 			m_apPlayers[i]->PostTick();
+
+#ifdef CONF_GEOLOCATION
+			if(m_apGeolocationJobs[i] && m_apGeolocationJobs[i]->Done())
+			{
+				const int LocatedCountry = m_apGeolocationJobs[i]->Country();
+				if(m_apGeolocationJobs[i]->State() == IJob::STATE_DONE)
+					Geolocation::CacheCountry(m_apGeolocationJobs[i]->Addr(), LocatedCountry);
+				m_apGeolocationJobs[i] = nullptr;
+				InitClientLanguage(i, m_aGeolocationFlagCountry[i], LocatedCountry);
+			}
+#endif // CONF_GEOLOCATION
 			
 			if(m_VoteLanguageTick[i] > 0)
 			{
@@ -1856,6 +1936,7 @@ void CGameContext::OnClientConnected(int ClientId, void *pData)
 void CGameContext::OnClientDrop(int ClientId, EClientDropType Type, const char *pReason)
 {
 	AbortVoteKickOnDisconnect(ClientId);
+	m_apGeolocationJobs[ClientId] = nullptr;
 	if(!m_apPlayers[ClientId])
 		return;
 
@@ -1882,10 +1963,10 @@ void CGameContext::OnClientDrop(int ClientId, EClientDropType Type, const char *
 	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
 		// remove everyone this player had muted
-		CGameContext::m_ClientMuted[ClientId][i] = false;
+		m_ClientMuted[ClientId][i] = false;
 		
 		// reset mutes for everyone that muted this player
-		CGameContext::m_ClientMuted[i][ClientId] = false;
+		m_ClientMuted[i][ClientId] = false;
 	}
 
 	Server()->ExpireServerInfo();
@@ -2570,49 +2651,27 @@ void CGameContext::OnStartInfoNetMessage(const CNetMsg_Cl_StartInfo *pMsg, int C
 	/* INFECTION MODIFICATION START ***************************************/
 	if(!Server()->GetClientMemory(ClientId, CLIENTMEMORY_LANGUAGESELECTION))
 	{
-#ifdef CONF_GEOLOCATION
-		char aAddrStr[NETADDR_MAXSTRSIZE]{};
-		Server()->GetClientAddr(ClientId, aAddrStr, sizeof(aAddrStr));
-		std::string ip(aAddrStr);
-
-		int LocatedCountry = Geolocation::get_country_iso_numeric_code(ip);
-#ifdef CONF_FORCE_COUNTRY_BY_IP
-		Server()->SetClientCountry(ClientId, LocatedCountry);
-#endif // CONF_FORCE_COUNTRY_BY_IP
-#else
-		int LocatedCountry = -1;
-#endif // CONF_GEOLOCATION
-
-		const char *const pLangFromClient = CLocalization::LanguageCodeByCountryCode(pMsg->m_Country);
-		const char *const pLangForIp = CLocalization::LanguageCodeByCountryCode(LocatedCountry);
-
-		const char *const pDefaultLang = "en";
-		const char *pLangForVote = "";
+		SetClientLanguage(ClientId, "en");
 
-		if(pLangFromClient[0] && (str_comp(pLangFromClient, pDefaultLang) != 0))
-			pLangForVote = pLangFromClient;
-		else if(pLangForIp[0] && (str_comp(pLangForIp, pDefaultLang) != 0))
-			pLangForVote = pLangForIp;
-
-		dbg_msg("lang", "init_language ClientId=%d, lang from flag: \"%s\", lang for IP: \"%s\"", ClientId, pLangFromClient, pLangForIp);
-
-		SetClientLanguage(ClientId, pDefaultLang);
+#ifdef CONF_GEOLOCATION
+		NETADDR Addr;
+		Server()->GetClientAddr(ClientId, &Addr);
 
-		if(pLangForVote[0])
+		int LocatedCountry;
+		if(Geolocation::FindCachedCountry(Addr, &LocatedCountry))
 		{
-			CNetMsg_Sv_VoteSet Msg;
-			Msg.m_Timeout = 10;
-			Msg.m_pReason = "";
-			str_copy(m_VoteLanguage[ClientId], pLangForVote, sizeof(m_VoteLanguage[ClientId]));
-			Msg.m_pDescription = Server()->Localization()->Localize(m_VoteLanguage[ClientId], _("Switch language to english?"));
-			Server()->SendPackMsg(&Msg, MSGFLAG_VITAL, ClientId);
-			m_VoteLanguageTick[ClientId] = 10 * Server()->TickSpeed();
+			InitClientLanguage(ClientId, pMsg->m_Country, LocatedCountry);
 		}
 		else
 		{
-			SendChatTarget_Localization(ClientId, CHATCATEGORY_DEFAULT, _("You can change the language of this mod using the command /language."), NULL);
-			SendChatTarget_Localization(ClientId, CHATCATEGORY_DEFAULT, _("If your language is not available, you can help with translation (/help translate)."), NULL);
+			// the language vote is offered from OnTick once the lookup is done
+			m_aGeolocationFlagCountry[ClientId] = pMsg->m_Country;
+			m_apGeolocationJobs[ClientId] = std::make_shared<CGeolocationJob>(Addr);
+			m_pEngine->AddJob(m_apGeolocationJobs[ClientId]);
 		}
+#else
+		InitClientLanguage(ClientId, pMsg->m_Country, -1);
+#endif // CONF_GEOLOCATION
 
 		Server()->SetClientMemory(ClientId, CLIENTMEMORY_LANGUAGESELECTION, true);
 	}
@@ -2858,6 +2917,18 @@ void CGameContext::ConTuneDump(IConsole::IResult *pResult, void *pUserData)
 	}
 }
 
+void CGameContext::ConEventStats(IConsole::IResult *pResult, void *pUserData)
+{
+	CGameContext *pSelf = (CGameContext *)pUserData;
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "events: max=%d/%d dropped: low=%" PRId64 " normal=%" PRId64 " high=%" PRId64,
+		pSelf->m_Events.MaxNumEvents(), (int)CEventHandler::MAX_EVENTS,
+		pSelf->m_Events.NumDropped(CEventHandler::PRIORITY_LOW),
+		pSelf->m_Events.NumDropped(CEventHandler::PRIORITY_NORMAL),
+		pSelf->m_Events.NumDropped(CEventHandler::PRIORITY_HIGH));
+	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+}
+
 void CGameContext::ConPause(IConsole::IResult *pResult, void *pUserData)
 {
 	CGameContext *pSelf = (CGameContext *)pUserData;
@@ -3711,7 +3782,7 @@ void CGameContext::PrivateMessage(const char* pStr, int ClientId, bool TeamChat)
 	int NumPlayerFound = 0;
 	for(int i=0; i<MAX_CLIENTS; i++)
 	{
-		if(m_apPlayers[i] && !CGameContext::m_ClientMuted[i][ClientId])
+		if(m_apPlayers[i] && !m_ClientMuted[i][ClientId])
 		{
 			if(i != ClientId)
 			{
@@ -3779,9 +3850,9 @@ void CGameContext::MutePlayer(const char* pStr, int ClientId)
 	{
 		if(m_apPlayers[i] && str_comp(Server()->ClientName(i), pStr) == 0)
 		{
-			CGameContext::m_ClientMuted[ClientId][i] = !CGameContext::m_ClientMuted[ClientId][i];
+			m_ClientMuted[ClientId][i] = !m_ClientMuted[ClientId][i];
 			
-			if(CGameContext::m_ClientMuted[ClientId][i])
+			if(m_ClientMuted[ClientId][i])
 				SendChatTarget(ClientId, "Player muted. Mute will persist until you or the muted player disconnects.");
 			else
 				SendChatTarget(ClientId, "Player unmuted. You can see their messages again.");
@@ -3790,6 +3861,46 @@ void CGameContext::MutePlayer(const char* pStr, int ClientId)
 	}
 }
 
+void CGameContext::InitClientLanguage(int ClientId, int FlagCountry, int LocatedCountry)
+{
+#ifdef CONF_FORCE_COUNTRY_BY_IP
+	Server()->SetClientCountry(ClientId, LocatedCountry);
+#endif // CONF_FORCE_COUNTRY_BY_IP
+
+	const char *const pLangFromClient = CLocalization::LanguageCodeByCountryCode(FlagCountry);
+	const char *const pLangForIp = CLocalization::LanguageCodeByCountryCode(LocatedCountry);
+
+	const char *const pDefaultLang = "en";
+	const char *pLangForVote = "";
+
+	if(pLangFromClient[0] && (str_comp(pLangFromClient, pDefaultLang) != 0))
+		pLangForVote = pLangFromClient;
+	else if(pLangForIp[0] && (str_comp(pLangForIp, pDefaultLang) != 0))
+		pLangForVote = pLangForIp;
+
+	dbg_msg("lang", "init_language ClientId=%d, lang from flag: \"%s\", lang for IP: \"%s\"", ClientId, pLangFromClient, pLangForIp);
+
+	// the player may have picked a language already while the lookup was running
+	if(m_apPlayers[ClientId] && str_comp(m_apPlayers[ClientId]->GetLanguage(), pDefaultLang) != 0)
+		return;
+
+	if(pLangForVote[0])
+	{
+		CNetMsg_Sv_VoteSet Msg;
+		Msg.m_Timeout = 10;
+		Msg.m_pReason = "";
+		str_copy(m_VoteLanguage[ClientId], pLangForVote, sizeof(m_VoteLanguage[ClientId]));
+		Msg.m_pDescription = Server()->Localization()->Localize(m_VoteLanguage[ClientId], _("Switch language to english?"));
+		Server()->SendPackMsg(&Msg, MSGFLAG_VITAL, ClientId);
+		m_VoteLanguageTick[ClientId] = 10 * Server()->TickSpeed();
+	}
+	else
+	{
+		SendChatTarget_Localization(ClientId, CHATCATEGORY_DEFAULT, _("You can change the language of this mod using the command /language."), NULL);
+		SendChatTarget_Localization(ClientId, CHATCATEGORY_DEFAULT, _("If your language is not available, you can help with translation (/help translate)."), NULL);
+	}
+}
+
 void CGameContext::InitGeolocation()
 {
 #ifdef CONF_GEOLOCATION
@@ -3861,111 +3972,6 @@ void CGameContext::ConChallenge(IConsole::IResult *pResult, void *pUserData)
 	pSelf->Server()->ShowChallenge(ClientId);
 }
 
-void CGameContext::ConTop10(IConsole::IResult *pResult, void *pUserData)
-{
-	CGameContext *pSelf = (CGameContext *)pUserData;
-	int ClientId = pResult->GetClientId();
-	
-	if(pResult->NumArguments()>0)
-	{
-		const char* pArg = pResult->GetString(0);
-		
-		if(str_comp_nocase(pArg, "engineer") == 0)
-			pSelf->Server()->ShowTop10(ClientId, SQL_SCORETYPE_ENGINEER_SCORE);
-		else if(str_comp_nocase(pArg, "soldier") == 0)
-			pSelf->Server()->ShowTop10(ClientId, SQL_SCORETYPE_SOLDIER_SCORE);
-		else if(str_comp_nocase(pArg, "scientist") == 0)
-			pSelf->Server()->ShowTop10(ClientId, SQL_SCORETYPE_SCIENTIST_SCORE);
-		else if(str_comp_nocase(pArg, "biologist") == 0)
-			pSelf->Server()->ShowTop10(ClientId, SQL_SCORETYPE_BIOLOGIST_SCORE);
-		else if(str_comp_nocase(pArg, "looper") == 0)
-			pSelf->Server()->ShowTop10(ClientId, SQL_SCORETYPE_LOOPER_SCORE);
-		else if(str_comp_nocase(pArg, "medic") == 0)
-			pSelf->Server()->ShowTop10(ClientId, SQL_SCORETYPE_MEDIC_SCORE);
-		else if(str_comp_nocase(pArg, "hero") == 0)
-			pSelf->Server()->ShowTop10(ClientId, SQL_SCORETYPE_HERO_SCORE);
-		else if(str_comp_nocase(pArg, "ninja") == 0)
-			pSelf->Server()->ShowTop10(ClientId, SQL_SCORETYPE_NINJA_SCORE);
-		else if(str_comp_nocase(pArg, "mercenary") == 0)
-			pSelf->Server()->ShowTop10(ClientId, SQL_SCORETYPE_MERCENARY_SCORE);
-		else if(str_comp_nocase(pArg, "sniper") == 0)
-			pSelf->Server()->ShowTop10(ClientId, SQL_SCORETYPE_SNIPER_SCORE);
-		else if(str_comp_nocase(pArg, "smoker") == 0)
-			pSelf->Server()->ShowTop10(ClientId, SQL_SCORETYPE_SMOKER_SCORE);
-		else if(str_comp_nocase(pArg, "hunter") == 0)
-			pSelf->Server()->ShowTop10(ClientId, SQL_SCORETYPE_HUNTER_SCORE);
-		else if(str_comp_nocase(pArg, "boomer") == 0)
-			pSelf->Server()->ShowTop10(ClientId, SQL_SCORETYPE_BOOMER_SCORE);
-		else if(str_comp_nocase(pArg, "ghost") == 0)
-			pSelf->Server()->ShowTop10(ClientId, SQL_SCORETYPE_GHOST_SCORE);
-		else if(str_comp_nocase(pArg, "spider") == 0)
-			pSelf->Server()->ShowTop10(ClientId, SQL_SCORETYPE_SPIDER_SCORE);
-		else if(str_comp_nocase(pArg, "ghoul") == 0)
-			pSelf->Server()->ShowTop10(ClientId, SQL_SCORETYPE_GHOUL_SCORE);
-		else if(str_comp_nocase(pArg, "slug") == 0)
-			pSelf->Server()->ShowTop10(ClientId, SQL_SCORETYPE_SLUG_SCORE);
-		else if(str_comp_nocase(pArg, "undead") == 0)
-			pSelf->Server()->ShowTop10(ClientId, SQL_SCORETYPE_UNDEAD_SCORE);
-		else if(str_comp_nocase(pArg, "witch") == 0)
-			pSelf->Server()->ShowTop10(ClientId, SQL_SCORETYPE_WITCH_SCORE);
-	}
-	else
-		pSelf->Server()->ShowTop10(ClientId, SQL_SCORETYPE_ROUND_SCORE);
-}
-
-void CGameContext::ConRank(IConsole::IResult *pResult, void *pUserData)
-{
-	CGameContext *pSelf = (CGameContext *)pUserData;
-	int ClientId = pResult->GetClientId();
-	
-	if(pResult->NumArguments()>0)
-	{
-		const char* pArg = pResult->GetString(0);
-		
-		if(str_comp_nocase(pArg, "engineer") == 0)
-			pSelf->Server()->ShowRank(ClientId, SQL_SCORETYPE_ENGINEER_SCORE);
-		else if(str_comp_nocase(pArg, "soldier") == 0)
-			pSelf->Server()->ShowRank(ClientId, SQL_SCORETYPE_SOLDIER_SCORE);
-		else if(str_comp_nocase(pArg, "scientist") == 0)
-			pSelf->Server()->ShowRank(ClientId, SQL_SCORETYPE_SCIENTIST_SCORE);
-		else if(str_comp_nocase(pArg, "biologist") == 0)
-			pSelf->Server()->ShowRank(ClientId, SQL_SCORETYPE_BIOLOGIST_SCORE);
-		else if(str_comp_nocase(pArg, "looper") == 0)
-			pSelf->Server()->ShowRank(ClientId, SQL_SCORETYPE_LOOPER_SCORE);
-		else if(str_comp_nocase(pArg, "medic") == 0)
-			pSelf->Server()->ShowRank(ClientId, SQL_SCORETYPE_MEDIC_SCORE);
-		else if(str_comp_nocase(pArg, "hero") == 0)
-			pSelf->Server()->ShowRank(ClientId, SQL_SCORETYPE_HERO_SCORE);
-		else if(str_comp_nocase(pArg, "ninja") == 0)
-			pSelf->Server()->ShowRank(ClientId, SQL_SCORETYPE_NINJA_SCORE);
-		else if(str_comp_nocase(pArg, "mercenary") == 0)
-			pSelf->Server()->ShowRank(ClientId, SQL_SCORETYPE_MERCENARY_SCORE);
-		else if(str_comp_nocase(pArg, "sniper") == 0)
-			pSelf->Server()->ShowRank(ClientId, SQL_SCORETYPE_SNIPER_SCORE);
-		else if(str_comp_nocase(pArg, "smoker") == 0)
-			pSelf->Server()->ShowRank(ClientId, SQL_SCORETYPE_SMOKER_SCORE);
-		else if(str_comp_nocase(pArg, "hunter") == 0)
-			pSelf->Server()->ShowRank(ClientId, SQL_SCORETYPE_HUNTER_SCORE);
-		else if(str_comp_nocase(pArg, "boomer") == 0)
-			pSelf->Server()->ShowRank(ClientId, SQL_SCORETYPE_BOOMER_SCORE);
-		else if(str_comp_nocase(pArg, "ghost") == 0)
-			pSelf->Server()->ShowRank(ClientId, SQL_SCORETYPE_GHOST_SCORE);
-		else if(str_comp_nocase(pArg, "spider") == 0)
-			pSelf->Server()->ShowRank(ClientId, SQL_SCORETYPE_SPIDER_SCORE);
-		else if(str_comp_nocase(pArg, "ghoul") == 0)
-			pSelf->Server()->ShowRank(ClientId, SQL_SCORETYPE_GHOUL_SCORE);
-		else if(str_comp_nocase(pArg, "slug") == 0)
-			pSelf->Server()->ShowRank(ClientId, SQL_SCORETYPE_SLUG_SCORE);
-		else if(str_comp_nocase(pArg, "undead") == 0)
-			pSelf->Server()->ShowRank(ClientId, SQL_SCORETYPE_UNDEAD_SCORE);
-		else if(str_comp_nocase(pArg, "witch") == 0)
-			pSelf->Server()->ShowRank(ClientId, SQL_SCORETYPE_WITCH_SCORE);
-	
-	}
-	else
-		pSelf->Server()->ShowRank(ClientId, SQL_SCORETYPE_ROUND_SCORE);
-}
-
 void CGameContext::ConGoal(IConsole::IResult *pResult, void *pUserData)
 {
 	CGameContext *pSelf = (CGameContext *)pUserData;
@@ -4034,6 +4040,36 @@ void CGameContext::ConStats(IConsole::IResult *pResult, void *pUserData)
 
 #endif
 
+void CGameContext::ConTop10(IConsole::IResult *pResult, void *pUserData)
+{
+	CGameContext *pSelf = (CGameContext *)pUserData;
+	int ClientId = pResult->GetClientId();
+
+	int ScoreType = ROUNDSCORE_TYPE_ROUND;
+	if(pResult->NumArguments() > 0)
+	{
+		ScoreType = RoundScoreTypeFromClassName(pResult->GetString(0));
+		if(ScoreType < 0)
+			return;
+	}
+	pSelf->Server()->ShowTop10(ClientId, ScoreType);
+}
+
+void CGameContext::ConRank(IConsole::IResult *pResult, void *pUserData)
+{
+	CGameContext *pSelf = (CGameContext *)pUserData;
+	int ClientId = pResult->GetClientId();
+
+	int ScoreType = ROUNDSCORE_TYPE_ROUND;
+	if(pResult->NumArguments() > 0)
+	{
+		ScoreType = RoundScoreTypeFromClassName(pResult->GetString(0));
+		if(ScoreType < 0)
+			return;
+	}
+	pSelf->Server()->ShowRank(ClientId, ScoreType);
+}
+
 void CGameContext::ConHelp(IConsole::IResult *pResult, void *pUserData)
 {
 	int ClientId = pResult->GetClientId();
@@ -4564,6 +4600,7 @@ void CGameContext::OnConsoleInit()
 	Console()->Register("toggle_tune", "s[tuning] i[value 1] i[value 2]", CFGFLAG_SERVER | CFGFLAG_GAME, ConToggleTuneParam, this, "Toggle tune variable");
 	Console()->Register("tune_reset", "", CFGFLAG_SERVER, ConTuneReset, this, "Reset tuning");
 	Console()->Register("tune_dump", "", CFGFLAG_SERVER, ConTuneDump, this, "Dump tuning");
+	Console()->Register("event_stats", "", CFGFLAG_SERVER, ConEventStats, this, "Show the most events per snapshot and the dropped events");
 	Console()->Register("pause_game", "", CFGFLAG_SERVER, ConPause, this, "Pause/unpause game");
 	Console()->Register("change_map", "?r[map]", CFGFLAG_SERVER | CFGFLAG_STORE, ConChangeMap, this, "Change map");
 	Console()->Register("restart", "?i[seconds]", CFGFLAG_SERVER | CFGFLAG_STORE, ConRestart, this, "Restart in x seconds (0 = abort)");
@@ -4593,12 +4630,12 @@ void CGameContext::OnConsoleInit()
 	Console()->Register("register", "s[username] s[password] ?s[email]", CFGFLAG_CHAT, ConRegister, this, "Create an account");
 	Console()->Register("login", "s[username] s[password]", CFGFLAG_CHAT, ConLogin, this, "Login to an account");
 	Console()->Register("logout", "", CFGFLAG_CHAT, ConLogout, this, "Logout");
+	Console()->Register("top10", "?s[classname]", CFGFLAG_CHAT, ConTop10, this, "Show the top 10 on the current map");
+	Console()->Register("rank", "?s[classname]", CFGFLAG_CHAT, ConRank, this, "Show your rank");
 #ifdef CONF_SQL
 	Console()->Register("setemail", "s[email]", CFGFLAG_CHAT, ConSetEmail, this, "Change your email");
 	
-	Console()->Register("top10", "?s[classname]", CFGFLAG_CHAT, ConTop10, this, "Show the top 10 on the current map");
 	Console()->Register("challenge", "", CFGFLAG_CHAT, ConChallenge, this, "Show the current winner of the challenge");
-	Console()->Register("rank", "?s[classname]", CFGFLAG_CHAT, ConRank, this, "Show your rank");
 	Console()->Register("goal", "?s[classname]", CFGFLAG_CHAT, ConGoal, this, "Show your goal");
 	Console()->Register("stats", "i", CFGFLAG_CHAT, ConStats, this, "Show stats by id");
 #endif
@@ -4657,7 +4694,7 @@ void CGameContext::OnInit()
 	m_pServer = Kernel()->RequestInterface<IServer>();
 	m_pConfig = Kernel()->RequestInterface<IConfigManager>()->Values();
 	m_pConsole = Kernel()->RequestInterface<IConsole>();
-	m_pEngine = nullptr;
+	m_pEngine = Kernel()->RequestInterface<IEngine>();
 	m_pStorage = Kernel()->RequestInterface<IStorage>();
 	m_World.SetGameServer(this);
 	m_Events.SetGameServer(this);
@@ -5061,7 +5098,7 @@ void CGameContext::WhisperId(int ClientId, int VictimId, const char *pMessage)
 		return;
 	}
 
-	if(CGameContext::m_ClientMuted[VictimId][ClientId])
+	if(m_ClientMuted[VictimId][ClientId])
 	{
 		return;
 	}
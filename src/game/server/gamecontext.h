@@ -22,6 +22,7 @@
 #include "gameworld.h"
 
 #include <fstream>
+#include <memory>
 #include <string>
 
 /*
@@ -97,6 +98,7 @@ class CGameContext : public IGameServer
 	static void ConToggleTuneParam(IConsole::IResult *pResult, void *pUserData);
 	static void ConTuneReset(IConsole::IResult *pResult, void *pUserData);
 	static void ConTuneDump(IConsole::IResult *pResult, void *pUserData);
+	static void ConEventStats(IConsole::IResult *pResult, void *pUserData);
 	static void ConPause(IConsole::IResult *pResult, void *pUserData);
 	static void ConChangeMap(IConsole::IResult *pResult, void *pUserData);
 	static void ConSkipMap(IConsole::IResult *pResult, void *pUserData);
@@ -321,11 +323,11 @@ private:
 	static void ConRegister(IConsole::IResult *pResult, void *pUserData);
 	static void ConLogin(IConsole::IResult *pResult, void *pUserData);
 	static void ConLogout(IConsole::IResult *pResult, void *pUserData);
+	static void ConTop10(IConsole::IResult *pResult, void *pUserData);
+	static void ConRank(IConsole::IResult *pResult, void *pUserData);
 #ifdef CONF_SQL
 	static void ConSetEmail(IConsole::IResult *pResult, void *pUserData);
-	static void ConTop10(IConsole::IResult *pResult, void *pUserData);
 	static void ConChallenge(IConsole::IResult *pResult, void *pUserData);
-	static void ConRank(IConsole::IResult *pResult, void *pUserData);
 	static void ConGoal(IConsole::IResult *pResult, void *pUserData);
 	static void ConStats(IConsole::IResult *pResult, void *pUserData);
 #endif
@@ -344,6 +346,7 @@ private:
 	void MutePlayer(const char* pStr, int ClientId);
 
 	void InitGeolocation();
+	void InitClientLanguage(int ClientId, int FlagCountry, int LocatedCountry);
 
 	enum OPTION_VOTE_TYPE
 	{
@@ -388,8 +391,11 @@ public:
 private:
 	int m_VoteLanguageTick[MAX_CLIENTS];
 	char m_VoteLanguage[MAX_CLIENTS][16];
+	// country lookups started in OnStartInfoNetMessage and applied in OnTick
+	std::shared_ptr<class CGeolocationJob> m_apGeolocationJobs[MAX_CLIENTS];
+	int m_aGeolocationFlagCountry[MAX_CLIENTS];
 	int m_VoteBanClientId;
-	static bool m_ClientMuted[MAX_CLIENTS][MAX_CLIENTS]; // m_ClientMuted[i][j]: i muted j
+	bool m_ClientMuted[MAX_CLIENTS][MAX_CLIENTS]; // m_ClientMuted[i][j]: i muted j
 	static icArray<std::string, 256> m_aChangeLogEntries;
 	static icArray<uint32_t, 16> m_aChangeLogPageIndices;
 	
@@ -411,6 +417,31 @@ private:
 
 	
 	CBroadcastState m_BroadcastStates[MAX_CLIENTS];
+
+	// Formatted localized texts, indexed by (template, arguments, language).
+	// Lets a message sent to many players (or resent every tick) be formatted
+	// once per language instead of once per recipient. The template, language
+	// and plural number are kept with the text, so that two messages with the
+	// same key can't return each other's text.
+	struct CLocalizedTextCacheEntry
+	{
+		uint64_t m_Key;
+		const char *m_pText;
+		int m_LanguageHandle;
+		bool m_Plural;
+		int m_Number;
+		std::string m_Text;
+	};
+	enum
+	{
+		LOCALIZED_TEXT_CACHE_SIZE = 256,
+		LOCALIZED_TEXT_NO_LANGUAGE = -2, // never a valid language handle
+	};
+	CLocalizedTextCacheEntry m_aLocalizedTextCache[LOCALIZED_TEXT_CACHE_SIZE];
+
+	const char *FormatLocalized(int LanguageHandle, uint64_t FormatKey, const char *pText, va_list VarArgs);
+	const char *FormatLocalized_P(int LanguageHandle, uint64_t FormatKey, int Number, const char *pText, va_list VarArgs);
+	CLocalizedTextCacheEntry *FindLocalizedText(int LanguageHandle, uint64_t Key, const char *pText, bool Plural, int Number, bool *pFound);
 	
 	struct LaserDotState
 	{
@@ -352,6 +352,9 @@ void IGameController::EndRound()
 	GameServer()->m_World.m_Paused = true;
 	m_GameOverTick = Server()->Tick();
 	m_SuddenDeath = 0;
+
+	// the scoreboard is shown for a while, convert the next map meanwhile
+	PrepareNextMap();
 }
 
 void IGameController::IncreaseCurrentRoundCounter()
@@ -847,6 +850,13 @@ void IGameController::CycleMap(bool Forced)
 }
 
 void IGameController::DefaultMapCycle()
+{
+	char aBuf[256] = {0};
+	if(FindDefaultNextMap(aBuf, g_Config.m_InfMaprotationRandom))
+		RotateMapTo(aBuf);
+}
+
+bool IGameController::FindDefaultNextMap(char *pMapName, bool Random)
 {
 	int PlayerCount = Server()->GetActivePlayerCount();
 
@@ -854,20 +864,19 @@ void IGameController::DefaultMapCycle()
 	GetMapRotationInfo(&pMapRotationInfo);
 
 	if (pMapRotationInfo.m_MapCount == 0)
-		return;
+		return false;
 
-	char aBuf[256] = {0};
 	int i=0;
 	CMapInfo Info;
-	if (g_Config.m_InfMaprotationRandom)
+	if (Random)
 	{
 		// handle random maprotation
 		int RandInt;
 		for ( ; i<32; i++)
 		{
 			RandInt = random_int(0, pMapRotationInfo.m_MapCount-1);
-			GetWordFromList(aBuf, g_Config.m_SvMaprotation, pMapRotationInfo.m_MapNameIndices[RandInt]);
-			LoadMapConfig(aBuf, &Info);
+			GetWordFromList(pMapName, g_Config.m_SvMaprotation, pMapRotationInfo.m_MapNameIndices[RandInt]);
+			LoadMapConfig(pMapName, &Info);
 
 			if(Info.MaximumPlayers && (PlayerCount > Info.MaximumPlayers))
 				continue;
@@ -894,8 +903,8 @@ void IGameController::DefaultMapCycle()
 				if (i == pMapRotationInfo.m_CurrentMapNumber)
 					break;
 			}
-			GetWordFromList(aBuf, g_Config.m_SvMaprotation, pMapRotationInfo.m_MapNameIndices[i]);
-			LoadMapConfig(aBuf, &Info);
+			GetWordFromList(pMapName, g_Config.m_SvMaprotation, pMapRotationInfo.m_MapNameIndices[i]);
+			LoadMapConfig(pMapName, &Info);
 
 			if(Info.MaximumPlayers && (PlayerCount > Info.MaximumPlayers))
 				continue;
@@ -913,17 +922,30 @@ void IGameController::DefaultMapCycle()
 		i++;
 		if (i >= pMapRotationInfo.m_MapCount)
 			i = 0;
-		GetWordFromList(aBuf, g_Config.m_SvMaprotation, pMapRotationInfo.m_MapNameIndices[i]);
+		GetWordFromList(pMapName, g_Config.m_SvMaprotation, pMapRotationInfo.m_MapNameIndices[i]);
 	}
 
-	RotateMapTo(aBuf);
+	return true;
 }
 
 void IGameController::SmartMapCycle()
 {
-	if(s_aMapInfo.IsEmpty())
+	int BestMapIndex = FindSmartNextMapIndex();
+	if(BestMapIndex < 0)
 		return;
 
+	const CMapInfoEx &Info = s_aMapInfo.At(BestMapIndex);
+	s_CachedMapIndex = BestMapIndex;
+
+	dbg_msg("smart-rotation", "rotating to index %d (name %s)", BestMapIndex, Info.Name());
+	RotateMapTo(Info.Name());
+}
+
+int IGameController::FindSmartNextMapIndex()
+{
+	if(s_aMapInfo.IsEmpty())
+		return -1;
+
 	const char *pCurrentMap = g_Config.m_SvMap;
 	int CurrentActivePlayers = Server()->GetActivePlayerCount();
 
@@ -977,11 +999,60 @@ void IGameController::SmartMapCycle()
 		BestMapIndex = i;
 	}
 
-	const CMapInfoEx &Info = s_aMapInfo.At(BestMapIndex);
-	s_CachedMapIndex = BestMapIndex;
+	return BestMapIndex;
+}
 
-	dbg_msg("smart-rotation", "rotating to index %d (name %s)", BestMapIndex, Info.Name());
-	RotateMapTo(Info.Name());
+// Mirrors CycleMap() without side effects. Random rotations can't be predicted.
+bool IGameController::PredictNextMap(char *pMapName, int Size)
+{
+	if(Server()->GetMapReload())
+	{
+		str_copy(pMapName, g_Config.m_SvMap, Size);
+		return true;
+	}
+
+	if(m_aMapWish[0] != 0)
+	{
+		str_copy(pMapName, m_aMapWish, Size);
+		return true;
+	}
+
+	if(m_RoundCount < g_Config.m_SvRoundsPerMap - 1 || !MapRotationEnabled())
+		return false;
+
+	if(m_aQueuedMap[0] != 0)
+	{
+		str_copy(pMapName, m_aQueuedMap, Size);
+		return true;
+	}
+
+	if(!str_length(g_Config.m_SvMaprotation))
+		return false;
+
+	if(Config()->m_InfSmartMapRotation)
+	{
+		int Index = FindSmartNextMapIndex();
+		if(Index < 0)
+			return false;
+		str_copy(pMapName, s_aMapInfo.At(Index).Name(), Size);
+		return true;
+	}
+
+	if(g_Config.m_InfMaprotationRandom)
+		return false;
+
+	char aBuf[256] = {0};
+	if(!FindDefaultNextMap(aBuf, false))
+		return false;
+	str_copy(pMapName, aBuf, Size);
+	return true;
+}
+
+void IGameController::PrepareNextMap()
+{
+	char aMapName[MAX_MAP_LENGTH];
+	if(PredictNextMap(aMapName, sizeof(aMapName)))
+		Server()->PrepareMap(aMapName);
 }
 
 void IGameController::SkipMap()
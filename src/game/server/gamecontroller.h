@@ -63,6 +63,10 @@ protected:
 	void CycleMap(bool Forced = false);
 	void DefaultMapCycle();
 	void SmartMapCycle();
+	bool FindDefaultNextMap(char *pMapName, bool Random);
+	int FindSmartNextMapIndex();
+	bool PredictNextMap(char *pMapName, int Size);
+	void PrepareNextMap();
 	void ResetGame();
 	void RotateMapTo(const char *pMapName);
 
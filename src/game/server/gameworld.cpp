@@ -6,7 +6,7 @@
 #include "entity.h"
 #include "gamecontext.h"
 #include <algorithm>
-#include <utility>
+#include <cmath>
 #include <engine/shared/config.h>
 #include <game/server/player.h>
 
@@ -21,6 +21,9 @@ CGameWorld::CGameWorld()
 
 	m_Paused = false;
 	m_ResetRequested = false;
+	m_SnapGridTick = -1;
+	m_SnapGridWidth = 0;
+	m_SnapGridHeight = 0;
 	for(int i = 0; i < NUM_ENTTYPES; i++)
 		m_apFirstEntityTypes[i] = 0;
 }
@@ -105,6 +108,7 @@ void CGameWorld::InsertEntity(CEntity *pEnt)
 	pEnt->m_pNextTypeEntity = m_apFirstEntityTypes[pEnt->m_ObjType];
 	pEnt->m_pPrevTypeEntity = 0x0;
 	m_apFirstEntityTypes[pEnt->m_ObjType] = pEnt;
+	m_SnapGridTick = -1;
 }
 
 void CGameWorld::DestroyEntity(CEntity *pEnt)
@@ -132,18 +136,108 @@ void CGameWorld::RemoveEntity(CEntity *pEnt)
 
 	pEnt->m_pNextTypeEntity = 0;
 	pEnt->m_pPrevTypeEntity = 0;
+	m_SnapGridTick = -1;
+}
+
+void CGameWorld::SnapCellRange(vec2 Min, vec2 Max, int *pMinX, int *pMinY, int *pMaxX, int *pMaxY) const
+{
+	const float CellSize = SNAP_CELL_SIZE;
+	*pMinX = clamp((int)std::floor(Min.x / CellSize), 0, m_SnapGridWidth - 1);
+	*pMinY = clamp((int)std::floor(Min.y / CellSize), 0, m_SnapGridHeight - 1);
+	*pMaxX = clamp((int)std::floor(Max.x / CellSize), 0, m_SnapGridWidth - 1);
+	*pMaxY = clamp((int)std::floor(Max.y / CellSize), 0, m_SnapGridHeight - 1);
+}
+
+void CGameWorld::UpdateSnapGrid()
+{
+	if(m_SnapGridTick == Server()->Tick())
+		return;
+	m_SnapGridTick = Server()->Tick();
+
+	// entities outside of the map are put into the border cells
+	m_SnapGridWidth = maximum(1, (GameServer()->Collision()->GetWidth() * 32 + SNAP_CELL_SIZE - 1) / SNAP_CELL_SIZE);
+	m_SnapGridHeight = maximum(1, (GameServer()->Collision()->GetHeight() * 32 + SNAP_CELL_SIZE - 1) / SNAP_CELL_SIZE);
+	m_vpSnapEntities.clear();
+	m_vSnapUnbounded.clear();
+	m_vSnapCellStart.assign(m_SnapGridWidth * m_SnapGridHeight + 1, 0);
+
+	m_vSnapCellRanges.clear();
+	for(auto *pEnt : m_apFirstEntityTypes)
+		for(; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+		{
+			const int Index = m_vpSnapEntities.size();
+			m_vpSnapEntities.push_back(pEnt);
+			vec2 Min, Max;
+			int MinX = -1, MinY = -1, MaxX = -1, MaxY = -1;
+			if(pEnt->SnapBounds(&Min, &Max))
+				SnapCellRange(Min, Max, &MinX, &MinY, &MaxX, &MaxY);
+			// long lasers and walls would be in too many cells
+			if(MinX == -1 || (MaxX - MinX + 1) * (MaxY - MinY + 1) > 4)
+			{
+				m_vSnapUnbounded.push_back(Index);
+				MinX = -1;
+			}
+			else
+			{
+				for(int y = MinY; y <= MaxY; y++)
+					for(int x = MinX; x <= MaxX; x++)
+						m_vSnapCellStart[y * m_SnapGridWidth + x + 1]++;
+			}
+			m_vSnapCellRanges.insert(m_vSnapCellRanges.end(), {MinX, MinY, MaxX, MaxY});
+		}
+
+	for(int i = 1; i < (int)m_vSnapCellStart.size(); i++)
+		m_vSnapCellStart[i] += m_vSnapCellStart[i - 1];
+	// m_vSnapCellStart[i] is the start of cell i now, fill the cells in the order of the entities
+	m_vSnapCellEntities.resize(m_vSnapCellStart.back());
+	for(int Index = 0; Index < (int)m_vpSnapEntities.size(); Index++)
+	{
+		const int *pRange = &m_vSnapCellRanges[Index * 4];
+		if(pRange[0] == -1)
+			continue;
+		for(int y = pRange[1]; y <= pRange[3]; y++)
+			for(int x = pRange[0]; x <= pRange[2]; x++)
+				m_vSnapCellEntities[m_vSnapCellStart[y * m_SnapGridWidth + x]++] = Index;
+	}
+	// filling moved every start to the start of the next cell
+	for(int i = m_vSnapCellStart.size() - 1; i > 0; i--)
+		m_vSnapCellStart[i] = m_vSnapCellStart[i - 1];
+	m_vSnapCellStart[0] = 0;
 }
 
 //
 void CGameWorld::Snap(int SnappingClient)
 {
-	for(int i = 0; i < NUM_ENTTYPES; i++)
-		for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt; )
+	const std::optional<CViewParams> View = GetViewParams(GameServer(), SnappingClient);
+	if(!View)
+	{
+		for(int i = 0; i < NUM_ENTTYPES; i++)
+			for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt; )
+			{
+				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+				pEnt->Snap(SnappingClient);
+				pEnt = m_pNextTraverseEntity;
+			}
+		return;
+	}
+
+	// only the entities in the cells the client can see, Snap does the exact clipping
+	UpdateSnapGrid();
+	m_vSnapVisible = m_vSnapUnbounded;
+	int MinX, MinY, MaxX, MaxY;
+	SnapCellRange(View->ViewPos - View->ShowDistance, View->ViewPos + View->ShowDistance, &MinX, &MinY, &MaxX, &MaxY);
+	for(int y = MinY; y <= MaxY; y++)
+		for(int x = MinX; x <= MaxX; x++)
 		{
-			m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
-			pEnt->Snap(SnappingClient);
-			pEnt = m_pNextTraverseEntity;
+			const int Cell = y * m_SnapGridWidth + x;
+			m_vSnapVisible.insert(m_vSnapVisible.end(), m_vSnapCellEntities.begin() + m_vSnapCellStart[Cell], m_vSnapCellEntities.begin() + m_vSnapCellStart[Cell + 1]);
 		}
+
+	// keep the order of the entity lists
+	std::sort(m_vSnapVisible.begin(), m_vSnapVisible.end());
+	m_vSnapVisible.erase(std::unique(m_vSnapVisible.begin(), m_vSnapVisible.end()), m_vSnapVisible.end());
+	for(int Index : m_vSnapVisible)
+		m_vpSnapEntities[Index]->Snap(SnappingClient);
 }
 
 void CGameWorld::Reset()
@@ -180,74 +274,21 @@ void CGameWorld::RemoveEntities()
 		}
 }
 
-bool distCompare(std::pair<float,int> a, std::pair<float,int> b)
-{
-	return (a.first < b.first);
-}
-
 void CGameWorld::UpdatePlayerMaps()
 {
 	if (Server()->Tick() % g_Config.m_SvMapUpdateRate != 0) return;
 
-	std::pair<float,int> dist[MAX_CLIENTS];
+	CPlayerMapper::CClient aClients[MAX_CLIENTS] = {};
 	for (int i = 0; i < MAX_CLIENTS; i++)
 	{
-		if(!Server()->ClientIngame(i) || Server()->ClientIsBot(i))
+		if(!Server()->ClientIngame(i))
 			continue;
-		int* map = Server()->GetIdMap(i);
-
-		// compute distances
-		for (int j = 0; j < MAX_CLIENTS; j++)
-		{
-			dist[j].second = j;
-			dist[j].first = 1e10;
-			if (!Server()->ClientIngame(j))
-				continue;
-			CCharacter* ch = GameServer()->m_apPlayers[j]->GetCharacter();
-			if (!ch)
-				continue;
-			dist[j].first = distance(GameServer()->m_apPlayers[i]->m_ViewPos, GameServer()->m_apPlayers[j]->m_ViewPos);
-		}
-
-		// always send the player himself
-		dist[i].first = 0;
-
-		// compute reverse map
-		int rMap[MAX_CLIENTS];
-		for (int j = 0; j < MAX_CLIENTS; j++)
-		{
-			rMap[j] = -1;
-		}
-		for (int j = 0; j < VANILLA_MAX_CLIENTS; j++)
-		{
-			if (map[j] == -1) continue;
-			if (dist[map[j]].first > 1e9) map[j] = -1;
-			else rMap[map[j]] = j;
-		}
-
-		std::nth_element(&dist[0], &dist[VANILLA_MAX_CLIENTS - 1], &dist[MAX_CLIENTS], distCompare);
-
-		int mapc = 0;
-		int demand = 0;
-		for (int j = 0; j < VANILLA_MAX_CLIENTS - 1; j++)
-		{
-			int k = dist[j].second;
-			if (rMap[k] != -1 || dist[j].first > 1e9) continue;
-			while (mapc < VANILLA_MAX_CLIENTS && map[mapc] != -1) mapc++;
-			if (mapc < VANILLA_MAX_CLIENTS - 1)
-				map[mapc] = k;
-			else
-				if (dist[j].first < 1300) // dont bother freeing up space for players which are too far to be displayed anyway
-					demand++;
-		}
-		for (int j = MAX_CLIENTS - 1; j > VANILLA_MAX_CLIENTS - 2; j--)
-		{
-			int k = dist[j].second;
-			if (rMap[k] != -1 && demand-- > 0)
-				map[rMap[k]] = -1;
-		}
-		map[VANILLA_MAX_CLIENTS - 1] = -1; // player with empty name to say chat msgs
+		aClients[i].m_Pos = GameServer()->m_apPlayers[i]->m_ViewPos;
+		aClients[i].m_Visible = GameServer()->m_apPlayers[i]->GetCharacter() != nullptr;
+		if(!Server()->ClientIsBot(i))
+			aClients[i].m_pIdMap = Server()->GetIdMap(i);
 	}
+	m_PlayerMapper.Update(aClients);
 }
 
 void CGameWorld::Tick()
@@ -259,6 +300,9 @@ void CGameWorld::Tick()
 	{
 		if(GameServer()->m_pController->IsForceBalanced())
 			GameServer()->SendChat(-1, CGameContext::CHAT_ALL, "Teams have been balanced");
+
+		m_Core.UpdateGrid();
+
 		// update all objects
 		for(int i = 0; i < NUM_ENTTYPES; i++)
 			for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt; )
@@ -268,6 +312,7 @@ void CGameWorld::Tick()
 				pEnt = m_pNextTraverseEntity;
 			}
 
+		m_Core.UpdateGrid();
 		for(int i = 0; i < NUM_ENTTYPES; i++)
 			for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt; )
 			{
@@ -4,6 +4,9 @@
 #define GAME_SERVER_GAMEWORLD_H
 
 #include <game/gamecore.h>
+#include <game/server/playermapper.h>
+
+#include <vector>
 
 class CEntity;
 class CCharacter;
@@ -57,8 +60,27 @@ private:
 	class CConfig *m_pConfig;
 	class IServer *m_pServer;
 
+	CPlayerMapper m_PlayerMapper;
 	void UpdatePlayerMaps();
 
+	// entities by the grid cells their snap bounds touch, built once per snapshot tick
+	enum
+	{
+		SNAP_CELL_SIZE = 512,
+	};
+	int m_SnapGridTick;
+	int m_SnapGridWidth;
+	int m_SnapGridHeight;
+	std::vector<CEntity *> m_vpSnapEntities;
+	std::vector<int> m_vSnapUnbounded;
+	// four per entity, MinX == -1 for the unbounded ones
+	std::vector<int> m_vSnapCellRanges;
+	std::vector<int> m_vSnapCellStart;
+	std::vector<int> m_vSnapCellEntities;
+	std::vector<int> m_vSnapVisible;
+	void UpdateSnapGrid();
+	void SnapCellRange(vec2 Min, vec2 Max, int *pMinX, int *pMinY, int *pMaxX, int *pMaxY) const;
+
 public:
 	class CGameContext *GameServer() { return m_pGameServer; }
 	class CConfig *Config() { return m_pConfig; }
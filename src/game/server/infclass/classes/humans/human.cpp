@@ -1365,12 +1365,12 @@ void CInfClassHuman::BroadcastWeaponState() const
 			int RemainingTicks = pCurrentWhiteHole->GetEndTick() - CurrentTick;
 			int Seconds = 1 + RemainingTicks / Server()->TickSpeed();
 			dynamic_string Buffer;
-			Server()->Localization()->Format_LP(Buffer, GetPlayer()->GetLanguage(), NumMines,
+			Server()->Localization()->Format_LP(Buffer, GetPlayer()->GetLanguageHandle(), NumMines,
 				_P("One mine is active", "{int:NumMines} mines are active"),
 				"NumMines", &NumMines,
 				nullptr);
 			Buffer.append("\n");
-			Server()->Localization()->Format_L(Buffer, GetPlayer()->GetLanguage(),
+			Server()->Localization()->Format_L(Buffer, GetPlayer()->GetLanguageHandle(),
 				_("White hole: {sec:RemainingTime}"),
 				"RemainingTime", &Seconds,
 				nullptr);
@@ -1457,11 +1457,11 @@ void CInfClassHuman::BroadcastWeaponState() const
 				if(BombLevel < 1.0)
 				{
 					dynamic_string Line1;
-					Server()->Localization()->Format_L(Line1, GetPlayer()->GetLanguage(),
+					Server()->Localization()->Format_L(Line1, GetPlayer()->GetLanguageHandle(),
 						_C("Mercenary", "Use the laser to upgrade the bomb"), NULL);
 
 					dynamic_string Line2;
-					Server()->Localization()->Format_L(Line2, GetPlayer()->GetLanguage(),
+					Server()->Localization()->Format_L(Line2, GetPlayer()->GetLanguageHandle(),
 						_C("Mercenary", "Explosive yield: {percent:BombLevel}"), "BombLevel", &BombLevel, NULL);
 
 					Line1.append("\n");
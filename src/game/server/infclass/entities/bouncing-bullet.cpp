@@ -139,3 +139,11 @@ void CBouncingBullet::Snap(int SnappingClient)
 	if(pProj)
 		FillInfo(pProj);
 }
+
+bool CBouncingBullet::SnapBounds(vec2 *pMin, vec2 *pMax)
+{
+	float Ct = (Server()->Tick()-m_StartTick)/(float)Server()->TickSpeed();
+	*pMin = GetPos(Ct);
+	*pMax = *pMin;
+	return true;
+}
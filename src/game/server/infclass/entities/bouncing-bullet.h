@@ -16,6 +16,7 @@ public:
 	virtual void Tick();
 	virtual void TickPaused();
 	virtual void Snap(int SnappingClient);
+	virtual bool SnapBounds(vec2 *pMin, vec2 *pMax);
 
 private:
 	vec2 m_ActualPos;
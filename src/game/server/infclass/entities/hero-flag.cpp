@@ -151,3 +151,10 @@ void CHeroFlag::Snap(int SnappingClient)
 	pFlag->m_Y = m_Pos.y + TileSizeF * 0.5;
 	pFlag->m_Team = TEAM_BLUE;
 }
+
+bool CHeroFlag::SnapBounds(vec2 *pMin, vec2 *pMax)
+{
+	*pMin = m_Pos;
+	*pMax = m_Pos;
+	return true;
+}
@@ -185,6 +185,13 @@ void CIcPickup::Snap(int SnappingClient)
 	GameServer()->SnapPickup(CSnapContext(SnappingClientVersion), GetId(), m_Pos, NetworkType, Subtype);
 }
 
+bool CIcPickup::SnapBounds(vec2 *pMin, vec2 *pMax)
+{
+	*pMin = m_Pos;
+	*pMax = m_Pos;
+	return true;
+}
+
 void CIcPickup::Spawn(float Delay)
 {
 	m_SpawnTick = Server()->Tick() + Server()->TickSpeed() * Delay;
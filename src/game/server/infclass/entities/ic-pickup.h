@@ -30,6 +30,7 @@ public:
 	void Tick() override;
 	void TickPaused() override;
 	void Snap(int SnappingClient) override;
+	bool SnapBounds(vec2 *pMin, vec2 *pMax) override;
 	
 	void Spawn(float Delay = 0);
 	void SetRespawnInterval(float Seconds);
@@ -134,6 +134,13 @@ void CInfClassLaser::Snap(int SnappingClient)
 	GameServer()->SnapLaserObject(Context, GetId(), m_Pos, m_From, m_EvalTick, GetOwner());
 }
 
+bool CInfClassLaser::SnapBounds(vec2 *pMin, vec2 *pMax)
+{
+	*pMin = vec2(minimum(m_Pos.x, m_From.x), minimum(m_Pos.y, m_From.y));
+	*pMax = vec2(maximum(m_Pos.x, m_From.x), maximum(m_Pos.y, m_From.y));
+	return true;
+}
+
 void CInfClassLaser::SetExplosive(bool Explosive)
 {
 	m_Explosive = Explosive;
@@ -15,6 +15,7 @@ public:
 	void Tick() override;
 	void TickPaused() override;
 	void Snap(int SnappingClient) override;
+	bool SnapBounds(vec2 *pMin, vec2 *pMax) override;
 
 	virtual void DoBounce();
 
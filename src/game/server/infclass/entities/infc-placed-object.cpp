@@ -29,6 +29,14 @@ bool CPlacedObject::DoSnapForClient(int SnappingClient)
 	return true;
 }
 
+bool CPlacedObject::SnapBounds(vec2 *pMin, vec2 *pMax)
+{
+	const vec2 Pos2 = HasSecondPosition() ? m_Pos2 : m_Pos;
+	*pMin = vec2(minimum(m_Pos.x, Pos2.x), minimum(m_Pos.y, Pos2.y));
+	*pMax = vec2(maximum(m_Pos.x, Pos2.x), maximum(m_Pos.y, Pos2.y));
+	return true;
+}
+
 CNetObj_InfClassObject *CPlacedObject::SnapInfClassObject()
 {
 	CNetObj_InfClassObject *pInfClassObject = Server()->SnapNewItem<CNetObj_InfClassObject>(m_InfClassObjectId);
@@ -13,6 +13,8 @@ public:
 
 	bool HasSecondPosition() const { return m_InfClassObjectFlags & INFCLASS_OBJECT_FLAG_HAS_SECOND_POSITION; }
 
+	bool SnapBounds(vec2 *pMin, vec2 *pMax) override;
+
 protected:
 	bool DoSnapForClient(int SnappingClient) override;
 
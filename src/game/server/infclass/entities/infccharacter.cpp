@@ -2681,6 +2681,7 @@ void CInfClassCharacter::TeleToId(int TeleNumber, int TeleType)
 	int DestTeleNumber = random_int(0, Outs.size() - 1);
 	vec2 DestPosition = Outs.at(DestTeleNumber);
 	m_Core.m_Pos = DestPosition;
+	m_Core.UpdateWorldGrid();
 	if(TeleType == TILE_TELEINEVIL)
 	{
 		m_Core.m_Vel = vec2(0, 0);
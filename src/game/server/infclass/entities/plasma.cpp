@@ -96,3 +96,10 @@ void CPlasma::Snap(int SnappingClient)
 	CSnapContext Context(SnappingClientVersion);
 	GameServer()->SnapLaserObject(Context, GetId(), m_Pos, m_Pos, m_StartTick, GetOwner());
 }
+
+bool CPlasma::SnapBounds(vec2 *pMin, vec2 *pMax)
+{
+	*pMin = m_Pos;
+	*pMax = m_Pos;
+	return true;
+}
@@ -14,6 +14,7 @@ public:
 
 	virtual void Tick();
 	virtual void Snap(int SnappingClient);
+	virtual bool SnapBounds(vec2 *pMin, vec2 *pMax);
 
 	void SetDamageType(EDamageType Type);
 
@@ -134,6 +134,14 @@ void CScatterGrenade::Snap(int SnappingClient)
 	if(pProj)
 		FillInfo(pProj);
 }
+
+bool CScatterGrenade::SnapBounds(vec2 *pMin, vec2 *pMax)
+{
+	float Ct = (Server()->Tick()-m_StartTick)/(float)Server()->TickSpeed();
+	*pMin = GetPos(Ct);
+	*pMax = *pMin;
+	return true;
+}
 	
 void CScatterGrenade::Explode()
 {
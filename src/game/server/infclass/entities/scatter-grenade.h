@@ -19,6 +19,7 @@ public:
 	virtual void TickPaused();
 	virtual void Explode();
 	virtual void Snap(int SnappingClient);
+	virtual bool SnapBounds(vec2 *pMin, vec2 *pMax);
 	virtual void FlashGrenade();
 	void ExplodeOnContact();
 
@@ -55,6 +55,13 @@ void CSuperWeaponIndicator::Snap(int SnappingClient)
 	}
 }
 
+bool CSuperWeaponIndicator::SnapBounds(vec2 *pMin, vec2 *pMax)
+{
+	*pMin = m_Pos;
+	*pMax = m_Pos;
+	return true;
+}
+
 void CSuperWeaponIndicator::Tick()
 {
 	if(IsMarkedForDestroy())
@@ -14,6 +14,8 @@ public:
 	~CSuperWeaponIndicator() override;
 	
 	virtual void Snap(int SnappingClient);
+	
+	virtual bool SnapBounds(vec2 *pMin, vec2 *pMax);
 	virtual void Tick();
 
 private:
@@ -121,6 +121,13 @@ void CWhiteHole::Snap(int SnappingClient)
 	}
 }
 
+bool CWhiteHole::SnapBounds(vec2 *pMin, vec2 *pMax)
+{
+	*pMin = m_Pos;
+	*pMax = m_Pos;
+	return true;
+}
+
 void CWhiteHole::MoveParticles()
 {
 	const int CurrentTick = Server()->Tick();
@@ -17,6 +17,8 @@ public:
 	virtual ~CWhiteHole();
 	
 	virtual void Snap(int SnappingClient);
+	
+	virtual bool SnapBounds(vec2 *pMin, vec2 *pMax);
 	virtual void TickPaused();
 	virtual void Tick();
 
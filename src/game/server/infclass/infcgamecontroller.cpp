@@ -1631,7 +1631,7 @@ void CInfClassGameController::SetPreferredClass(int ClientId, EPlayerClass Class
 	default:
 	{
 		const char *pClassDisplayName = GetClassDisplayName(Class);
-		const char *pTranslated = Server()->Localization()->Localize(pPlayer->GetLanguage(), pClassDisplayName);
+		const char *pTranslated = Server()->Localization()->Localize(pPlayer->GetLanguageHandle(), pClassDisplayName);
 		GameServer()->SendChatTarget_Localization(ClientId, CHATCATEGORY_PLAYER,
 			_("Class {str:ClassName} will be automatically attributed to you when round starts"),
 			"ClassName", pTranslated,
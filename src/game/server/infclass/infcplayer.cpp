@@ -782,7 +782,7 @@ void CInfClassPlayer::SendClassIntro()
 	if(!IsBot() && (Class != EPlayerClass::None) && (Class != EPlayerClass::Invalid))
 	{
 		const char *pClassName = CInfClassGameController::GetClassDisplayName(Class);
-		const char *pTranslated = Server()->Localization()->Localize(GetLanguage(), pClassName);
+		const char *pTranslated = Server()->Localization()->Localize(GetLanguageHandle(), pClassName);
 
 		if(IsHuman())
 			GameServer()->SendBroadcast_Localization(GetCid(), BROADCAST_PRIORITY_GAMEANNOUNCE, BROADCAST_DURATION_GAMEANNOUNCE,
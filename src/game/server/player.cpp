@@ -485,6 +485,7 @@ const char *CPlayer::GetLanguage() const
 void CPlayer::SetLanguage(const char* pLanguage)
 {
 	str_copy(m_aLanguage, pLanguage, sizeof(m_aLanguage));
+	m_LanguageHandle = Server()->Localization()->GetLanguageHandle(m_aLanguage);
 }
 
 void CPlayer::SetOriginalName(const char *pName)
@@ -176,6 +176,7 @@ protected:
 	EPlayerClass m_class;
 	int m_DefaultScoreMode;
 	char m_aLanguage[16];
+	int m_LanguageHandle;
 
 public:
 	EPlayerClass GetClass() const;
@@ -184,6 +185,7 @@ public:
 	bool IsSpectator() const;
 
 	const char *GetLanguage() const;
+	int GetLanguageHandle() const { return m_LanguageHandle; }
 	void SetLanguage(const char* pLanguage);
 
 	void SetOriginalName(const char *pName);
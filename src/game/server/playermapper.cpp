@@ -0,0 +1,193 @@
+#include "playermapper.h"
+
+#include <base/system.h>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+CPlayerMapper::CPlayerMapper()
+{
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		m_aRankedPos[i] = vec2(0, 0);
+		m_aVisible[i] = false;
+		m_aDirty[i] = false;
+		for(int &Id : m_aaLastMap[i])
+			Id = -1;
+	}
+	m_NumRanked = 0;
+}
+
+int CPlayerMapper::Bucket(int CellX, int CellY) const
+{
+	return ((unsigned)CellX * 73856093u ^ (unsigned)CellY * 19349663u) % NUM_GRID_BUCKETS;
+}
+
+void CPlayerMapper::GridInsert(int ClientId)
+{
+	int CellX = (int)std::floor(m_aRankedPos[ClientId].x / GRID_CELL_SIZE);
+	int CellY = (int)std::floor(m_aRankedPos[ClientId].y / GRID_CELL_SIZE);
+	int Index = Bucket(CellX, CellY);
+	m_aGridNext[ClientId] = m_aGridFirst[Index];
+	m_aGridFirst[Index] = ClientId;
+}
+
+void CPlayerMapper::MarkNear(vec2 Pos, float Radius)
+{
+	int MinX = (int)std::floor((Pos.x - Radius) / GRID_CELL_SIZE);
+	int MaxX = (int)std::floor((Pos.x + Radius) / GRID_CELL_SIZE);
+	int MinY = (int)std::floor((Pos.y - Radius) / GRID_CELL_SIZE);
+	int MaxY = (int)std::floor((Pos.y + Radius) / GRID_CELL_SIZE);
+	for(int y = MinY; y <= MaxY; y++)
+		for(int x = MinX; x <= MaxX; x++)
+			for(int i = m_aGridFirst[Bucket(x, y)]; i != -1; i = m_aGridNext[i])
+				if(distance(m_aRankedPos[i], Pos) < Radius)
+					m_aDirty[i] = true;
+}
+
+void CPlayerMapper::Update(const CClient *pClients)
+{
+	bool aMoved[MAX_CLIENTS];
+	vec2 aOldPos[MAX_CLIENTS];
+	bool aAppeared[MAX_CLIENTS];
+	bool aVanished[MAX_CLIENTS];
+	bool AnyAppeared = false;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		const CClient &Client = pClients[i];
+		aOldPos[i] = m_aRankedPos[i];
+		aMoved[i] = distance(Client.m_Pos, m_aRankedPos[i]) > MOVE_THRESHOLD;
+		aAppeared[i] = Client.m_Visible && !m_aVisible[i];
+		if(aMoved[i] || aAppeared[i])
+			m_aRankedPos[i] = Client.m_Pos;
+		aVanished[i] = !Client.m_Visible && m_aVisible[i];
+		AnyAppeared |= aAppeared[i];
+		m_aVisible[i] = Client.m_Visible;
+
+		if(!Client.m_pIdMap)
+		{
+			m_aDirty[i] = false;
+			continue;
+		}
+		// new clients and maps reset by the player
+		if(aMoved[i] || mem_comp(Client.m_pIdMap, m_aaLastMap[i], sizeof(m_aaLastMap[i])) != 0)
+			m_aDirty[i] = true;
+	}
+
+	for(int &First : m_aGridFirst)
+		First = -1;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+		if(pClients[i].m_pIdMap)
+			GridInsert(i);
+
+	const float Radius = DISPLAY_RANGE + SWAP_MARGIN + MOVE_THRESHOLD;
+	for(int j = 0; j < MAX_CLIENTS; j++)
+	{
+		if(aAppeared[j] || (aMoved[j] && m_aVisible[j]))
+			MarkNear(m_aRankedPos[j], Radius);
+		if(aMoved[j] && m_aVisible[j] && !aAppeared[j])
+			MarkNear(aOldPos[j], Radius);
+	}
+
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		int *pMap = pClients[i].m_pIdMap;
+		if(!pMap || m_aDirty[i])
+			continue;
+		for(int s = 0; s < VANILLA_MAX_CLIENTS - 1; s++)
+		{
+			// a free slot takes any new player, a vanished one has to go
+			if((pMap[s] == -1 && AnyAppeared) || (pMap[s] != -1 && aVanished[pMap[s]]))
+			{
+				m_aDirty[i] = true;
+				break;
+			}
+		}
+	}
+
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(!pClients[i].m_pIdMap)
+			continue;
+		if(m_aDirty[i])
+			Rank(i, pClients);
+		mem_copy(m_aaLastMap[i], pClients[i].m_pIdMap, sizeof(m_aaLastMap[i]));
+	}
+}
+
+void CPlayerMapper::Rank(int ClientId, const CClient *pClients)
+{
+	m_NumRanked++;
+	m_aDirty[ClientId] = false;
+	int *pMap = pClients[ClientId].m_pIdMap;
+	const vec2 Pos = pClients[ClientId].m_Pos;
+
+	int aSlot[MAX_CLIENTS];
+	for(int &Slot : aSlot)
+		Slot = -1;
+	for(int s = 0; s < VANILLA_MAX_CLIENTS; s++)
+	{
+		if(pMap[s] == -1)
+			continue;
+		// always send the player himself
+		if(pMap[s] < 0 || pMap[s] >= MAX_CLIENTS || (pMap[s] != ClientId && !m_aVisible[pMap[s]]))
+			pMap[s] = -1;
+		else
+			aSlot[pMap[s]] = s;
+	}
+
+	std::pair<float, int> aDist[MAX_CLIENTS];
+	int NumDist = 0;
+	for(int j = 0; j < MAX_CLIENTS; j++)
+	{
+		if(j == ClientId)
+			aDist[NumDist++] = {0.0f, j};
+		else if(m_aVisible[j])
+			aDist[NumDist++] = {distance(Pos, pClients[j].m_Pos), j};
+	}
+
+	// fill the free slots with the nearest players, remember the ones that didn't fit
+	const int NumNearest = minimum(NumDist, (int)VANILLA_MAX_CLIENTS - 1);
+	std::nth_element(aDist, aDist + NumNearest, aDist + NumDist);
+	std::sort(aDist, aDist + NumNearest);
+	float aDemand[VANILLA_MAX_CLIENTS];
+	int NumDemand = 0;
+	int FreeSlot = 0;
+	for(int k = 0; k < NumNearest; k++)
+	{
+		int Id = aDist[k].second;
+		if(aSlot[Id] != -1)
+			continue;
+		while(FreeSlot < VANILLA_MAX_CLIENTS - 1 && pMap[FreeSlot] != -1)
+			FreeSlot++;
+		if(FreeSlot < VANILLA_MAX_CLIENTS - 1)
+		{
+			pMap[FreeSlot] = Id;
+			aSlot[Id] = FreeSlot;
+		}
+		else if(aDist[k].first < DISPLAY_RANGE) // dont bother freeing up space for players which are too far to be displayed anyway
+		{
+			aDemand[NumDemand++] = aDist[k].first;
+		}
+	}
+
+	// free the slots of the farthest players, they are filled in the next update
+	if(NumDemand > 0)
+		std::sort(aDist + NumNearest, aDist + NumDist);
+	int NumFreed = 0;
+	for(int k = NumDist - 1; k >= NumNearest && NumFreed < NumDemand; k--)
+	{
+		int Id = aDist[k].second;
+		if(aSlot[Id] == -1)
+			continue;
+		if(aDist[k].first < aDemand[NumFreed] + SWAP_MARGIN)
+			break;
+		pMap[aSlot[Id]] = -1;
+		NumFreed++;
+	}
+	if(NumFreed > 0)
+		m_aDirty[ClientId] = true;
+
+	pMap[VANILLA_MAX_CLIENTS - 1] = -1; // player with empty name to say chat msgs
+}
@@ -0,0 +1,69 @@
+#ifndef GAME_SERVER_PLAYERMAPPER_H
+#define GAME_SERVER_PLAYERMAPPER_H
+
+#include <base/vmath.h>
+#include <engine/shared/protocol.h>
+
+/*
+	Class: Player Mapper
+		Keeps the id maps of the vanilla clients which only know
+		VANILLA_MAX_CLIENTS players at once, so every client sees the
+		players nearest to it.
+
+		A client is only ranked again if something near it moved further
+		than MOVE_THRESHOLD since the last ranking, found through a grid
+		of the client positions. Mapped players are kept as long as
+		possible, every remap costs the client a new player info.
+*/
+class CPlayerMapper
+{
+public:
+	// players further away aren't displayed, no need to map them
+	static constexpr float DISPLAY_RANGE = 1300.0f;
+	static constexpr float MOVE_THRESHOLD = 100.0f;
+	// a mapped player is only replaced by one that much closer
+	static constexpr float SWAP_MARGIN = 200.0f;
+	static constexpr float GRID_CELL_SIZE = 1024.0f;
+
+	enum
+	{
+		NUM_GRID_BUCKETS = 256,
+	};
+
+	struct CClient
+	{
+		vec2 m_Pos;
+		// has a character the others can see
+		bool m_Visible;
+		// the map to maintain, nullptr if the client doesn't need one
+		int *m_pIdMap;
+	};
+
+	CPlayerMapper();
+
+	// pClients has MAX_CLIENTS entries, ids without a player are all zero
+	void Update(const CClient *pClients);
+
+	// number of times a map was ranked again, for statistics
+	int NumRanked() const { return m_NumRanked; }
+
+private:
+	int Bucket(int CellX, int CellY) const;
+	void GridInsert(int ClientId);
+	void MarkNear(vec2 Pos, float Radius);
+	void Rank(int ClientId, const CClient *pClients);
+
+	vec2 m_aRankedPos[MAX_CLIENTS];
+	bool m_aVisible[MAX_CLIENTS];
+	bool m_aDirty[MAX_CLIENTS];
+	// the maps as written by the last update, to notice resets
+	int m_aaLastMap[MAX_CLIENTS][VANILLA_MAX_CLIENTS];
+
+	// clients with a map, by ranked position
+	int m_aGridFirst[NUM_GRID_BUCKETS];
+	int m_aGridNext[MAX_CLIENTS];
+
+	int m_NumRanked;
+};
+
+#endif
@@ -1,8 +1,41 @@
 #include "geolocation.h"
 
+#include <base/system.h>
+
 #include <iostream>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 
 static Geolocation *Instance = nullptr;
+// guards Instance against Shutdown() while a CGeolocationJob is running
+static std::mutex InstanceMutex;
+
+namespace {
+
+struct CAddrIpHash
+{
+	size_t operator()(const NETADDR &Addr) const
+	{
+		size_t Hash = Addr.type;
+		for(unsigned char Byte : Addr.ip)
+			Hash = Hash * 31 + Byte;
+		return Hash;
+	}
+};
+
+NETADDR AddrWithoutPort(const NETADDR &Addr)
+{
+	NETADDR Result = Addr;
+	Result.port = 0;
+	return Result;
+}
+
+constexpr size_t CountryCacheSize = 1024;
+std::list<std::pair<NETADDR, int>> CountryCacheLru; // most recent first
+std::unordered_map<NETADDR, std::list<std::pair<NETADDR, int>>::iterator, CAddrIpHash> CountryCache;
+
+} // namespace
 
 Geolocation::Geolocation(const char* path_to_mmdb) {
 	db = new GeoLite2PP::DB(path_to_mmdb);
@@ -32,10 +65,58 @@ bool Geolocation::Initialize(const char *pPathToDB)
 
 void Geolocation::Shutdown()
 {
+	std::lock_guard<std::mutex> Lock(InstanceMutex);
 	delete Instance;
 	Instance = nullptr;
 }
 
+bool Geolocation::FindCachedCountry(const NETADDR &Addr, int *pCountry)
+{
+	auto It = CountryCache.find(AddrWithoutPort(Addr));
+	if(It == CountryCache.end())
+		return false;
+
+	CountryCacheLru.splice(CountryCacheLru.begin(), CountryCacheLru, It->second);
+	*pCountry = It->second->second;
+	return true;
+}
+
+void Geolocation::CacheCountry(const NETADDR &Addr, int Country)
+{
+	const NETADDR Key = AddrWithoutPort(Addr);
+	auto It = CountryCache.find(Key);
+	if(It != CountryCache.end())
+	{
+		It->second->second = Country;
+		CountryCacheLru.splice(CountryCacheLru.begin(), CountryCacheLru, It->second);
+		return;
+	}
+
+	if(CountryCache.size() >= CountryCacheSize)
+	{
+		CountryCache.erase(CountryCacheLru.back().first);
+		CountryCacheLru.pop_back();
+	}
+	CountryCacheLru.emplace_front(Key, Country);
+	CountryCache[Key] = CountryCacheLru.begin();
+}
+
+CGeolocationJob::CGeolocationJob(const NETADDR &Addr) :
+	m_Addr(Addr),
+	m_Country(-1)
+{
+}
+
+void CGeolocationJob::Run()
+{
+	char aAddrStr[NETADDR_MAXSTRSIZE];
+	net_addr_str(&m_Addr, aAddrStr, sizeof(aAddrStr), false);
+	std::string ip(aAddrStr);
+
+	std::lock_guard<std::mutex> Lock(InstanceMutex);
+	m_Country = Geolocation::get_country_iso_numeric_code(ip);
+}
+
 int Geolocation::get_country_iso_numeric_code(std::string& ip) {
 	if(!Instance)
 	{
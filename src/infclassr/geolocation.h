@@ -1,6 +1,9 @@
 #ifndef INFCLASSR_GEOLOCATION_H
 #define INFCLASSR_GEOLOCATION_H
 
+#include <base/types.h>
+#include <engine/shared/jobs.h>
+
 #include <infclassr/GeoLite2PP/GeoLite2PP.hpp>
 
 class Geolocation {
@@ -15,6 +18,25 @@ public:
 	static void Shutdown();
 
 	static int get_country_iso_numeric_code(std::string& ip);
+
+	// LRU cache of recent lookups keyed by IP (port ignored), game thread only
+	static bool FindCachedCountry(const NETADDR &Addr, int *pCountry);
+	static void CacheCountry(const NETADDR &Addr, int Country);
+};
+
+// Resolves the country of an address on a worker thread, see CGameContext::OnStartInfoNetMessage
+class CGeolocationJob : public IJob
+{
+	NETADDR m_Addr;
+	int m_Country;
+
+	void Run() override;
+
+public:
+	CGeolocationJob(const NETADDR &Addr);
+
+	const NETADDR &Addr() const { return m_Addr; }
+	int Country() const { return m_Country; } // valid once Done()
 };
 
 #endif
@@ -7,9 +7,110 @@
 #include <unicode/ubidi.h>
 /* END EDIT ***********************************************************/
 
+//windows
+#if defined(CONF_FAMILY_WINDOWS) && !defined(va_copy)
+	#define va_copy(d,s) ((d) = (s))
+#endif
+
+/* FORMAT TEMPLATE ****************************************************/
+
+CLocalization::CFormatTemplate::CFormatTemplate(const char* pText)
+{
+	int Length = str_length(pText)+1;
+	m_pText = new char[Length];
+	str_copy(m_pText, pText, Length);
+	
+	int Iter = 0;
+	int Start = Iter;
+	int ParamTypeStart = -1;
+	int ParamNameStart = -1;
+	int ParamNameLength = 0;
+	
+	while(pText[Iter])
+	{
+		if(ParamNameStart >= 0)
+		{
+			if(pText[Iter] == '}') //End of the macro, store the argument
+			{
+				int Type = TOKEN_UNKNOWN;
+				if(str_comp_num("str:", pText+ParamTypeStart, 4) == 0)
+					Type = TOKEN_STR;
+				else if(str_comp_num("int:", pText+ParamTypeStart, 4) == 0)
+					Type = TOKEN_INT;
+				else if(str_comp_num("percent:", pText+ParamTypeStart, 4) == 0)
+					Type = TOKEN_PERCENT;
+				else if(str_comp_num("sec:", pText+ParamTypeStart, 4) == 0)
+					Type = TOKEN_SEC;
+				
+				if(Type != TOKEN_UNKNOWN)
+				{
+					CToken& Token = m_Tokens.increment();
+					Token.m_Type = Type;
+					Token.m_Start = ParamNameStart;
+					Token.m_Length = ParamNameLength;
+				}
+				
+				//Close the macro
+				Start = Iter+1;
+				ParamTypeStart = -1;
+				ParamNameStart = -1;
+			}
+			else
+				ParamNameLength++;
+		}
+		else if(ParamTypeStart >= 0)
+		{
+			if(pText[Iter] == ':') //End of the type, start of the name
+			{
+				ParamNameStart = Iter+1;
+				ParamNameLength = 0;
+			}
+			else if(pText[Iter] == '}') //Invalid: no name found
+			{
+				//Close the macro
+				Start = Iter+1;
+				ParamTypeStart = -1;
+				ParamNameStart = -1;
+			}
+		}
+		else
+		{
+			if(pText[Iter] == '{')
+			{
+				//Flush the content of pText
+				if(Iter > Start)
+				{
+					CToken& Token = m_Tokens.increment();
+					Token.m_Type = TOKEN_TEXT;
+					Token.m_Start = Start;
+					Token.m_Length = Iter-Start;
+				}
+				Iter++;
+				ParamTypeStart = Iter;
+			}
+		}
+		
+		Iter = str_utf8_forward(pText, Iter);
+	}
+	
+	if(Iter > Start && ParamTypeStart == -1 && ParamNameStart == -1)
+	{
+		CToken& Token = m_Tokens.increment();
+		Token.m_Type = TOKEN_TEXT;
+		Token.m_Start = Start;
+		Token.m_Length = Iter-Start;
+	}
+}
+
+CLocalization::CFormatTemplate::~CFormatTemplate()
+{
+	delete[] m_pText;
+}
+
 /* LANGUAGE ***********************************************************/
 
 CLocalization::CLanguage::CLanguage() :
+	m_ParentHandle(CLocalization::LANGUAGE_MAIN),
 	m_Loaded(false),
 	m_Direction(CLocalization::DIRECTION_LTR),
 	m_pPluralRules(NULL),
@@ -23,6 +124,7 @@ CLocalization::CLanguage::CLanguage() :
 }
 
 CLocalization::CLanguage::CLanguage(const char* pName, const char* pFilename, const char* pParentFilename) :
+	m_ParentHandle(CLocalization::LANGUAGE_MAIN),
 	m_Loaded(false),
 	m_Direction(CLocalization::DIRECTION_LTR),
 	m_pPluralRules(NULL),
@@ -84,13 +186,15 @@ CLocalization::CLanguage::CLanguage(const char* pName, const char* pFilename, co
 
 CLocalization::CLanguage::~CLanguage()
 {
-	hashtable< CEntry, 128 >::iterator Iter = m_Translations.begin();
-	while(Iter != m_Translations.end())
+	for(auto &Translation : m_Translations)
 	{
-		if(Iter.data())
-			Iter.data()->Free();
-		
-		++Iter;
+		CEntry* pEntry = Translation.second;
+		while(pEntry)
+		{
+			CEntry* pNext = pEntry->m_pNext;
+			delete pEntry;
+			pEntry = pNext;
+		}
 	}
 	
 	if(m_pNumberFormater)
@@ -150,7 +254,7 @@ bool CLocalization::CLanguage::Load(CLocalization* pLocalization, CStorage* pSto
 			const char* pKey = rStart[i]["key"];
 			if(pKey && pKey[0])
 			{
-				CEntry* pEntry = m_Translations.set(pKey);
+				CEntry* pEntry = AddEntry(pKey);
 				
 				const char* pSingular = rStart[i]["value"];
 				if(pSingular && pSingular[0])
@@ -225,27 +329,50 @@ bool CLocalization::CLanguage::Load(CLocalization* pLocalization, CStorage* pSto
 	return true;
 }
 
-const char* CLocalization::CLanguage::Localize(const char* pText) const
+CLocalization::CLanguage::CEntry* CLocalization::CLanguage::AddEntry(const char* pKey)
+{
+	uint32_t Hash = LocalizationHash(pKey);
+	CEntry* pEntry = FindEntry(Hash, pKey);
+	if(pEntry)
+		return pEntry;
+	
+	CEntry*& pFirst = m_Translations[Hash];
+	pFirst = new CEntry(pKey, pFirst);
+	return pFirst;
+}
+
+CLocalization::CLanguage::CEntry* CLocalization::CLanguage::FindEntry(uint32_t Hash, const char* pKey) const
+{
+	auto Iter = m_Translations.find(Hash);
+	if(Iter == m_Translations.end())
+		return NULL;
+	
+	for(CEntry* pEntry = Iter->second; pEntry; pEntry = pEntry->m_pNext)
+	{
+		if(str_comp(pEntry->m_pKey, pKey) == 0)
+			return pEntry;
+	}
+	
+	return NULL;
+}
+
+const char* CLocalization::CLanguage::Localize(uint32_t Hash, const char* pText) const
 {	
-	const CEntry* pEntry = m_Translations.get(pText);
+	const CEntry* pEntry = FindEntry(Hash, pText);
 	if(!pEntry)
 		return NULL;
 	
 	return pEntry->m_apVersions[PLURALTYPE_NONE];
 }
 
-const char* CLocalization::CLanguage::Localize_P(int Number, const char* pText) const
+int CLocalization::CLanguage::PluralType(int Number) const
 {
-	const CEntry* pEntry = m_Translations.get(pText);
-	if(!pEntry)
-		return NULL;
-	
 	UChar aPluralKeyWord[6];
 	UErrorCode Status = U_ZERO_ERROR;
 	uplrules_select(m_pPluralRules, static_cast<double>(Number), aPluralKeyWord, 6, &Status);
 	
 	if(U_FAILURE(Status))
-		return NULL;
+		return -1;
 	
 	int PluralCode = PLURALTYPE_NONE;
 	
@@ -265,16 +392,59 @@ const char* CLocalization::CLanguage::Localize_P(int Number, const char* pText)
 			PluralCode = PLURALTYPE_ONE;
 	}
 	
+	return PluralCode;
+}
+
+const char* CLocalization::CLanguage::Localize_P(int Number, uint32_t Hash, const char* pText) const
+{
+	const CEntry* pEntry = FindEntry(Hash, pText);
+	if(!pEntry)
+		return NULL;
+	
+	int PluralCode = PluralType(Number);
+	if(PluralCode < 0)
+		return NULL;
+	
 	return pEntry->m_apVersions[PluralCode];
 }
 
+const CLocalization::CFormatTemplate* CLocalization::CLanguage::LocalizeTemplate(uint32_t Hash, const char* pText)
+{
+	CEntry* pEntry = FindEntry(Hash, pText);
+	if(!pEntry || !pEntry->m_apVersions[PLURALTYPE_NONE])
+		return NULL;
+	
+	if(!pEntry->m_apTemplates[PLURALTYPE_NONE])
+		pEntry->m_apTemplates[PLURALTYPE_NONE] = new CFormatTemplate(pEntry->m_apVersions[PLURALTYPE_NONE]);
+	
+	return pEntry->m_apTemplates[PLURALTYPE_NONE];
+}
+
+const CLocalization::CFormatTemplate* CLocalization::CLanguage::LocalizeTemplate_P(int Number, uint32_t Hash, const char* pText)
+{
+	CEntry* pEntry = FindEntry(Hash, pText);
+	if(!pEntry)
+		return NULL;
+	
+	int PluralCode = PluralType(Number);
+	if(PluralCode < 0 || !pEntry->m_apVersions[PluralCode])
+		return NULL;
+	
+	if(!pEntry->m_apTemplates[PluralCode])
+		pEntry->m_apTemplates[PluralCode] = new CFormatTemplate(pEntry->m_apVersions[PluralCode]);
+	
+	return pEntry->m_apTemplates[PluralCode];
+}
+
 /* LOCALIZATION *******************************************************/
 
 /* BEGIN EDIT *********************************************************/
 CLocalization::CLocalization(class CStorage* pStorage) :
 	m_pStorage(pStorage),
 	m_pMainLanguage(NULL),
-	m_pUtf8Converter(NULL)
+	m_pUtf8Converter(NULL),
+	m_Utf8MaxCharSize(0),
+	m_NumSourceTemplates(0)
 {
 	
 }
@@ -285,6 +455,15 @@ CLocalization::~CLocalization()
 	for(int i=0; i<m_pLanguages.size(); i++)
 		delete m_pLanguages[i];
 	
+	hashtable< CFormatTemplate*, 256 >::iterator Iter = m_SourceTemplates.begin();
+	while(Iter != m_SourceTemplates.end())
+	{
+		if(Iter.data())
+			delete *Iter.data();
+		
+		++Iter;
+	}
+	
 	if(m_pUtf8Converter)
 		ucnv_close(m_pUtf8Converter);
 }
@@ -308,6 +487,7 @@ bool CLocalization::Init()
 		dbg_msg("Localization", "Can't create UTF8/UTF16 convertert");
 		return false;
 	}
+	m_Utf8MaxCharSize = ucnv_getMaxCharSize(m_pUtf8Converter);
 	
 	// read file data into buffer
 	const char *pFilename = "languages/index.json";
@@ -358,6 +538,13 @@ bool CLocalization::Init()
 		}
 	}
 
+	// resolve the fallback chain once, unknown parents fall back to the main language
+	for(int i=0; i<m_pLanguages.size(); i++)
+	{
+		if(m_pLanguages[i]->HasParent())
+			m_pLanguages[i]->SetParentHandle(GetLanguageHandle(m_pLanguages[i]->GetParentFilename()));
+	}
+
 	// clean up
 	json_value_free(pJsonData);
 	delete[] pFileData;
@@ -581,74 +768,134 @@ const char *CLocalization::FallbackLanguageForIpCountryCode(int Country)
 	}
 }
 
-const char* CLocalization::LocalizeWithDepth(const char* pLanguageCode, const char* pText, int Depth)
+int CLocalization::GetLanguageHandle(const char* pLanguageCode) const
 {
-	CLanguage* pLanguage = m_pMainLanguage;
 	if(pLanguageCode)
 	{
 		for(int i=0; i<m_pLanguages.size(); i++)
 		{
 			if(str_comp(m_pLanguages[i]->GetFilename(), pLanguageCode) == 0)
-			{
-				pLanguage = m_pLanguages[i];
-				break;
-			}
+				return i;
 		}
 	}
 	
+	return LANGUAGE_MAIN;
+}
+
+CLocalization::CLanguage* CLocalization::GetLanguage(int LanguageHandle)
+{
+	if(LanguageHandle >= 0 && LanguageHandle < m_pLanguages.size())
+		return m_pLanguages[LanguageHandle];
+	
+	return m_pMainLanguage;
+}
+
+const char* CLocalization::LocalizeWithDepth(int LanguageHandle, uint32_t Hash, const char* pText, int Depth)
+{
+	CLanguage* pLanguage = GetLanguage(LanguageHandle);
 	if(!pLanguage)
 		return pText;
 	
 	if(!pLanguage->IsLoaded())
 		pLanguage->Load(this, Storage());
 	
-	const char* pResult = pLanguage->Localize(pText);
+	const char* pResult = pLanguage->Localize(Hash, pText);
 	if(pResult)
 		return pResult;
-	else if(pLanguage->GetParentFilename()[0] && Depth < 4)
-		return LocalizeWithDepth(pLanguage->GetParentFilename(), pText, Depth+1);
+	else if(pLanguage->HasParent() && Depth < 4)
+		return LocalizeWithDepth(pLanguage->GetParentHandle(), Hash, pText, Depth+1);
 	else
 		return pText;
 }
 
 const char* CLocalization::Localize(const char* pLanguageCode, const char* pText)
 {
-	return LocalizeWithDepth(pLanguageCode, pText, 0);
+	return LocalizeWithDepth(GetLanguageHandle(pLanguageCode), LocalizationHash(pText), pText, 0);
 }
 
-const char* CLocalization::LocalizeWithDepth_P(const char* pLanguageCode, int Number, const char* pText, int Depth)
+const char* CLocalization::Localize(int LanguageHandle, const CLocalizableString& Text)
 {
-	CLanguage* pLanguage = m_pMainLanguage;
-	if(pLanguageCode)
-	{
-		for(int i=0; i<m_pLanguages.size(); i++)
-		{
-			if(str_comp(m_pLanguages[i]->GetFilename(), pLanguageCode) == 0)
-			{
-				pLanguage = m_pLanguages[i];
-				break;
-			}
-		}
-	}
-	
+	return LocalizeWithDepth(LanguageHandle, Text.m_Hash, Text.m_pText, 0);
+}
+
+const char* CLocalization::LocalizeWithDepth_P(int LanguageHandle, int Number, uint32_t Hash, const char* pText, int Depth)
+{
+	CLanguage* pLanguage = GetLanguage(LanguageHandle);
 	if(!pLanguage)
 		return pText;
 	
 	if(!pLanguage->IsLoaded())
 		pLanguage->Load(this, Storage());
 	
-	const char* pResult = pLanguage->Localize_P(Number, pText);
+	const char* pResult = pLanguage->Localize_P(Number, Hash, pText);
 	if(pResult)
 		return pResult;
-	else if(pLanguage->GetParentFilename()[0] && Depth < 4)
-		return LocalizeWithDepth_P(pLanguage->GetParentFilename(), Number, pText, Depth+1);
+	else if(pLanguage->HasParent() && Depth < 4)
+		return LocalizeWithDepth_P(pLanguage->GetParentHandle(), Number, Hash, pText, Depth+1);
 	else
 		return pText;
 }
 
 const char* CLocalization::Localize_P(const char* pLanguageCode, int Number, const char* pText)
 {
-	return LocalizeWithDepth_P(pLanguageCode, Number, pText, 0);
+	return LocalizeWithDepth_P(GetLanguageHandle(pLanguageCode), Number, LocalizationHash(pText), pText, 0);
+}
+
+const char* CLocalization::Localize_P(int LanguageHandle, int Number, const CLocalizableString& Text)
+{
+	return LocalizeWithDepth_P(LanguageHandle, Number, Text.m_Hash, Text.m_pText, 0);
+}
+
+const CLocalization::CFormatTemplate* CLocalization::LocalizeTemplateWithDepth(int LanguageHandle, uint32_t Hash, const char* pText, int Depth)
+{
+	CLanguage* pLanguage = GetLanguage(LanguageHandle);
+	if(!pLanguage)
+		return GetSourceTemplate(pText);
+	
+	if(!pLanguage->IsLoaded())
+		pLanguage->Load(this, Storage());
+	
+	const CFormatTemplate* pResult = pLanguage->LocalizeTemplate(Hash, pText);
+	if(pResult)
+		return pResult;
+	else if(pLanguage->HasParent() && Depth < 4)
+		return LocalizeTemplateWithDepth(pLanguage->GetParentHandle(), Hash, pText, Depth+1);
+	else
+		return GetSourceTemplate(pText);
+}
+
+const CLocalization::CFormatTemplate* CLocalization::LocalizeTemplateWithDepth_P(int LanguageHandle, int Number, uint32_t Hash, const char* pText, int Depth)
+{
+	CLanguage* pLanguage = GetLanguage(LanguageHandle);
+	if(!pLanguage)
+		return GetSourceTemplate(pText);
+	
+	if(!pLanguage->IsLoaded())
+		pLanguage->Load(this, Storage());
+	
+	const CFormatTemplate* pResult = pLanguage->LocalizeTemplate_P(Number, Hash, pText);
+	if(pResult)
+		return pResult;
+	else if(pLanguage->HasParent() && Depth < 4)
+		return LocalizeTemplateWithDepth_P(pLanguage->GetParentHandle(), Number, Hash, pText, Depth+1);
+	else
+		return GetSourceTemplate(pText);
+}
+
+const CLocalization::CFormatTemplate* CLocalization::GetSourceTemplate(const char* pText)
+{
+	CFormatTemplate** ppTemplate = m_SourceTemplates.get(pText);
+	if(ppTemplate)
+		return *ppTemplate;
+	
+	//Texts built at runtime would make the table grow forever
+	if(m_NumSourceTemplates >= MAX_SOURCE_TEMPLATES)
+		return NULL;
+	
+	CFormatTemplate* pTemplate = new CFormatTemplate(pText);
+	m_SourceTemplates.set(pText, pTemplate);
+	m_NumSourceTemplates++;
+	return pTemplate;
 }
 
 void CLocalization::AppendNumber(dynamic_string& Buffer, int& BufferIter, CLanguage* pLanguage, int Number)
@@ -663,7 +910,7 @@ void CLocalization::AppendNumber(dynamic_string& Buffer, int& BufferIter, CLangu
 	{
 		//Update buffer size
 		int SrcLength = u_strlen(aBufUtf16);
-		int NeededSize = UCNV_GET_MAX_BYTES_FOR_STRING(SrcLength, ucnv_getMaxCharSize(m_pUtf8Converter));
+		int NeededSize = UCNV_GET_MAX_BYTES_FOR_STRING(SrcLength, m_Utf8MaxCharSize);
 		
 		while(Buffer.maxsize() - BufferIter <= NeededSize)
 			Buffer.resize_buffer(Buffer.maxsize()*2);
@@ -688,7 +935,7 @@ void CLocalization::AppendPercent(dynamic_string& Buffer, int& BufferIter, CLang
 	{
 		//Update buffer size
 		int SrcLength = u_strlen(aBufUtf16);
-		int NeededSize = UCNV_GET_MAX_BYTES_FOR_STRING(SrcLength, ucnv_getMaxCharSize(m_pUtf8Converter));
+		int NeededSize = UCNV_GET_MAX_BYTES_FOR_STRING(SrcLength, m_Utf8MaxCharSize);
 		
 		while(Buffer.maxsize() - BufferIter <= NeededSize)
 			Buffer.resize_buffer(Buffer.maxsize()*2);
@@ -717,7 +964,7 @@ void CLocalization::AppendDuration(dynamic_string& Buffer, int& BufferIter, CLan
 	{
 		int SrcLength = BufUTF16.length();
 		
-		int NeededSize = UCNV_GET_MAX_BYTES_FOR_STRING(SrcLength, ucnv_getMaxCharSize(m_pUtf8Converter));
+		int NeededSize = UCNV_GET_MAX_BYTES_FOR_STRING(SrcLength, m_Utf8MaxCharSize);
 		
 		while(Buffer.maxsize() - BufferIter <= NeededSize)
 			Buffer.resize_buffer(Buffer.maxsize()*2);
@@ -732,145 +979,164 @@ void CLocalization::AppendDuration(dynamic_string& Buffer, int& BufferIter, CLan
 	}
 }
 
-void CLocalization::Format_V(dynamic_string& Buffer, const char* pLanguageCode, const char* pText, va_list VarArgs)
+void CLocalization::Format_T(dynamic_string& Buffer, CLanguage* pLanguage, const CFormatTemplate* pTemplate, va_list VarArgs)
 {
-	CLanguage* pLanguage = m_pMainLanguage;	
-	if(pLanguageCode)
+	const char* pText = pTemplate->GetText();
+	int BufferStart = Buffer.length();
+	int BufferIter = BufferStart;
+	
+	for(int t=0; t<pTemplate->NumTokens(); t++)
 	{
-		for(int i=0; i<m_pLanguages.size(); i++)
+		const CFormatTemplate::CToken& Token = pTemplate->GetToken(t);
+		if(Token.m_Type == CFormatTemplate::TOKEN_TEXT)
 		{
-			if(str_comp(m_pLanguages[i]->GetFilename(), pLanguageCode) == 0)
+			BufferIter = Buffer.append_at_num(BufferIter, pText+Token.m_Start, Token.m_Length);
+			continue;
+		}
+		
+		//Try to find an argument with this name
+		const void* pVarArgValue = NULL;
+		va_list VarArgsIter;
+		va_copy(VarArgsIter, VarArgs);
+		const char* pVarArgName = va_arg(VarArgsIter, const char*);
+		while(pVarArgName)
+		{
+			const void* pValue = va_arg(VarArgsIter, const void*);
+			if(str_comp_num(pText+Token.m_Start, pVarArgName, Token.m_Length) == 0)
 			{
-				pLanguage = m_pLanguages[i];
+				pVarArgValue = pValue;
+				break;
+			}
+			
+			pVarArgName = va_arg(VarArgsIter, const char*);
+		}
+		va_end(VarArgsIter);
+		
+		if(!pVarArgValue)
+			continue;
+		
+		switch(Token.m_Type)
+		{
+			case CFormatTemplate::TOKEN_STR:
+				BufferIter = Buffer.append_at(BufferIter, (const char*) pVarArgValue);
+				break;
+			case CFormatTemplate::TOKEN_INT:
+				AppendNumber(Buffer, BufferIter, pLanguage, *((const int*) pVarArgValue));
+				break;
+			case CFormatTemplate::TOKEN_PERCENT:
+				AppendPercent(Buffer, BufferIter, pLanguage, *((const float*) pVarArgValue));
+				break;
+			case CFormatTemplate::TOKEN_SEC:
+			{
+				int Duration = *((const int*) pVarArgValue);
+				int Minutes = Duration / 60;
+				int Seconds = Duration - Minutes*60;
+				if(Minutes > 0)
+				{
+					AppendDuration(Buffer, BufferIter, pLanguage, Minutes, icu::TimeUnit::UTIMEUNIT_MINUTE);
+					if(Seconds > 0)
+					{
+						BufferIter = Buffer.append_at(BufferIter, ", ");
+						AppendDuration(Buffer, BufferIter, pLanguage, Seconds, icu::TimeUnit::UTIMEUNIT_SECOND);
+					}
+				}
+				else
+					AppendDuration(Buffer, BufferIter, pLanguage, Seconds, icu::TimeUnit::UTIMEUNIT_SECOND);
 				break;
 			}
 		}
 	}
+	
+	if(pLanguage->GetWritingDirection() == DIRECTION_RTL)
+		ArabicShaping(Buffer, BufferStart);
+}
+
+void CLocalization::Format_V(dynamic_string& Buffer, const char* pLanguageCode, const char* pText, va_list VarArgs)
+{
+	CLanguage* pLanguage = GetLanguage(GetLanguageHandle(pLanguageCode));
 	if(!pLanguage)
 	{
 		Buffer.append(pText);
 		return;
 	}
 	
-	const char* pVarArgName = NULL;
-	const void* pVarArgValue = NULL;
-	
-	int Iter = 0;
-	int Start = Iter;
-	int ParamTypeStart = -1;
-	int ParamTypeLength = 0;
-	int ParamNameStart = -1;
-	int ParamNameLength = 0;
-	
-	int BufferStart = Buffer.length();
-	int BufferIter = BufferStart;
-	
-	while(pText[Iter])
+	const CFormatTemplate* pTemplate = GetSourceTemplate(pText);
+	if(pTemplate)
+		Format_T(Buffer, pLanguage, pTemplate, VarArgs);
+	else
 	{
-		if(ParamNameStart >= 0)
-		{
-			if(pText[Iter] == '}') //End of the macro, try to apply it
-			{
-				//Try to find an argument with this name
-				va_list VarArgsIter;
+		CFormatTemplate Template(pText);
+		Format_T(Buffer, pLanguage, &Template, VarArgs);
+	}
+}
 
-				//windows
-				#if defined(CONF_FAMILY_WINDOWS)
-					#define va_copy(d,s) ((d) = (s))
-				#endif
+static uint64_t HashBytes(uint64_t Hash, const void* pData, int Size)
+{
+	const unsigned char* pBytes = static_cast<const unsigned char*>(pData);
+	for(int i=0; i<Size; i++)
+	{
+		Hash ^= pBytes[i];
+		Hash *= 1099511628211ULL; // FNV-1a prime
+	}
+	return Hash;
+}
 
-				va_copy(VarArgsIter, VarArgs);
-				pVarArgName = va_arg(VarArgsIter, const char*);
-				while(pVarArgName)
-				{
-					pVarArgValue = va_arg(VarArgsIter, const void*);
-					if(str_comp_num(pText+ParamNameStart, pVarArgName, ParamNameLength) == 0)
-					{
-						//Get argument type
-						if(str_comp_num("str:", pText+ParamTypeStart, 4) == 0)
-						{
-							BufferIter = Buffer.append_at(BufferIter, (const char*) pVarArgValue);
-						}
-						else if(str_comp_num("int:", pText+ParamTypeStart, 4) == 0)
-						{
-							int Number = *((const int*) pVarArgValue);
-							AppendNumber(Buffer, BufferIter, pLanguage, Number);
-						}
-						else if(str_comp_num("percent:", pText+ParamTypeStart, 4) == 0)
-						{
-							float Number = (*((const float*) pVarArgValue));
-							AppendPercent(Buffer, BufferIter, pLanguage, Number);
-						}
-						else if(str_comp_num("sec:", pText+ParamTypeStart, 4) == 0)
-						{
-							int Duration = *((const int*) pVarArgValue);
-							int Minutes = Duration / 60;
-							int Seconds = Duration - Minutes*60;
-							if(Minutes > 0)
-							{
-								AppendDuration(Buffer, BufferIter, pLanguage, Minutes, icu::TimeUnit::UTIMEUNIT_MINUTE);
-								if(Seconds > 0)
-								{
-									BufferIter = Buffer.append_at(BufferIter, ", ");
-									AppendDuration(Buffer, BufferIter, pLanguage, Seconds, icu::TimeUnit::UTIMEUNIT_SECOND);
-								}
-							}
-							else
-								AppendDuration(Buffer, BufferIter, pLanguage, Seconds, icu::TimeUnit::UTIMEUNIT_SECOND);
-						}
-						break;
-					}
-					
-					pVarArgName = va_arg(VarArgsIter, const char*);
-				}
-				va_end(VarArgsIter);
-				
-				//Close the macro
-				Start = Iter+1;
-				ParamTypeStart = -1;
-				ParamNameStart = -1;
-			}
-			else
-				ParamNameLength++;
-		}
-		else if(ParamTypeStart >= 0)
+static_assert(sizeof(float) == sizeof(int), "percent values are hashed like ints");
+
+uint64_t CLocalization::FormatKey_V(const char* pText, va_list VarArgs)
+{
+	uint64_t Hash = HashBytes(14695981039346656037ULL, pText, str_length(pText)+1);
+	
+	for(const char* pIter = pText; *pIter; pIter++)
+	{
+		if(*pIter != '{')
+			continue;
+		
+		const char* pType = pIter+1;
+		const char* pName = pType;
+		while(*pName && *pName != ':' && *pName != '}')
+			pName++;
+		if(*pName != ':')
 		{
-			if(pText[Iter] == ':') //End of the type, start of the name
-			{
-				ParamNameStart = Iter+1;
-				ParamNameLength = 0;
-			}
-			else if(pText[Iter] == '}') //Invalid: no name found
-			{
-				//Close the macro
-				Start = Iter+1;
-				ParamTypeStart = -1;
-				ParamNameStart = -1;
-			}
-			else
-				ParamTypeLength++;
+			if(!*pName)
+				break;
+			pIter = pName;
+			continue;
 		}
-		else
+		pName++;
+		
+		const char* pEnd = pName;
+		while(*pEnd && *pEnd != '}')
+			pEnd++;
+		if(!*pEnd)
+			break;
+		int NameLength = pEnd - pName;
+		
+		//Same argument lookup as in Format_V
+		va_list VarArgsIter;
+		va_copy(VarArgsIter, VarArgs);
+		const char* pVarArgName = va_arg(VarArgsIter, const char*);
+		while(pVarArgName)
 		{
-			if(pText[Iter] == '{')
+			const void* pVarArgValue = va_arg(VarArgsIter, const void*);
+			if(str_comp_num(pName, pVarArgName, NameLength) == 0)
 			{
-				//Flush the content of pText in the buffer
-				BufferIter = Buffer.append_at_num(BufferIter, pText+Start, Iter-Start);
-				Iter++;
-				ParamTypeStart = Iter;
+				//the other types are ints, except the floats of percents which have the same size
+				if(str_comp_num("str:", pType, 4) == 0)
+					Hash = HashBytes(Hash, pVarArgValue, str_length((const char*) pVarArgValue)+1);
+				else
+					Hash = HashBytes(Hash, pVarArgValue, sizeof(int));
+				break;
 			}
+			
+			pVarArgName = va_arg(VarArgsIter, const char*);
 		}
+		va_end(VarArgsIter);
 		
-		Iter = str_utf8_forward(pText, Iter);
-	}
-	
-	if(Iter > 0 && ParamTypeStart == -1 && ParamNameStart == -1)
-	{
-		BufferIter = Buffer.append_at_num(BufferIter, pText+Start, Iter-Start);
+		pIter = pEnd;
 	}
 	
-	if(pLanguage && pLanguage->GetWritingDirection() == DIRECTION_RTL)
-		ArabicShaping(Buffer, BufferStart);
+	return Hash;
 }
 
 void CLocalization::Format(dynamic_string& Buffer, const char* pLanguageCode, const char* pText, ...)
@@ -885,9 +1151,26 @@ void CLocalization::Format(dynamic_string& Buffer, const char* pLanguageCode, co
 
 void CLocalization::Format_VL(dynamic_string& Buffer, const char* pLanguageCode, const char* pText, va_list VarArgs)
 {
-	const char* pLocalText = Localize(pLanguageCode, pText);
+	Format_VL(Buffer, GetLanguageHandle(pLanguageCode), pText, VarArgs);
+}
+
+void CLocalization::Format_VL(dynamic_string& Buffer, int LanguageHandle, const char* pText, va_list VarArgs)
+{
+	CLanguage* pLanguage = GetLanguage(LanguageHandle);
+	if(!pLanguage)
+	{
+		Buffer.append(pText);
+		return;
+	}
 	
-	Format_V(Buffer, pLanguageCode, pLocalText, VarArgs);
+	const CFormatTemplate* pTemplate = LocalizeTemplateWithDepth(LanguageHandle, LocalizationHash(pText), pText, 0);
+	if(pTemplate)
+		Format_T(Buffer, pLanguage, pTemplate, VarArgs);
+	else
+	{
+		CFormatTemplate Template(pText);
+		Format_T(Buffer, pLanguage, &Template, VarArgs);
+	}
 }
 
 void CLocalization::Format_L(dynamic_string& Buffer, const char* pLanguageCode, const char* pText, ...)
@@ -900,11 +1183,38 @@ void CLocalization::Format_L(dynamic_string& Buffer, const char* pLanguageCode,
 	va_end(VarArgs);
 }
 
+void CLocalization::Format_L(dynamic_string& Buffer, int LanguageHandle, const char* pText, ...)
+{
+	va_list VarArgs;
+	va_start(VarArgs, pText);
+	
+	Format_VL(Buffer, LanguageHandle, pText, VarArgs);
+	
+	va_end(VarArgs);
+}
+
 void CLocalization::Format_VLP(dynamic_string& Buffer, const char* pLanguageCode, int Number, const char* pText, va_list VarArgs)
 {
-	const char* pLocalText = Localize_P(pLanguageCode, Number, pText);
+	Format_VLP(Buffer, GetLanguageHandle(pLanguageCode), Number, pText, VarArgs);
+}
+
+void CLocalization::Format_VLP(dynamic_string& Buffer, int LanguageHandle, int Number, const char* pText, va_list VarArgs)
+{
+	CLanguage* pLanguage = GetLanguage(LanguageHandle);
+	if(!pLanguage)
+	{
+		Buffer.append(pText);
+		return;
+	}
 	
-	Format_V(Buffer, pLanguageCode, pLocalText, VarArgs);
+	const CFormatTemplate* pTemplate = LocalizeTemplateWithDepth_P(LanguageHandle, Number, LocalizationHash(pText), pText, 0);
+	if(pTemplate)
+		Format_T(Buffer, pLanguage, pTemplate, VarArgs);
+	else
+	{
+		CFormatTemplate Template(pText);
+		Format_T(Buffer, pLanguage, &Template, VarArgs);
+	}
 }
 
 void CLocalization::Format_LP(dynamic_string& Buffer, const char* pLanguageCode, int Number, const char* pText, ...)
@@ -917,6 +1227,16 @@ void CLocalization::Format_LP(dynamic_string& Buffer, const char* pLanguageCode,
 	va_end(VarArgs);
 }
 
+void CLocalization::Format_LP(dynamic_string& Buffer, int LanguageHandle, int Number, const char* pText, ...)
+{
+	va_list VarArgs;
+	va_start(VarArgs, pText);
+	
+	Format_VLP(Buffer, LanguageHandle, Number, pText, VarArgs);
+	
+	va_end(VarArgs);
+}
+
 void CLocalization::ArabicShaping(dynamic_string& Buffer, int BufferStart)
 {
 	UErrorCode Status = U_ZERO_ERROR;
@@ -946,7 +1266,7 @@ void CLocalization::ArabicShaping(dynamic_string& Buffer, int BufferStart)
 	);
 	
 	int ShapedLength = u_strlen(pBuf0);
-	int NeededSize = UCNV_GET_MAX_BYTES_FOR_STRING(ShapedLength, ucnv_getMaxCharSize(m_pUtf8Converter));
+	int NeededSize = UCNV_GET_MAX_BYTES_FOR_STRING(ShapedLength, m_Utf8MaxCharSize);
 	
 	while(Buffer.maxsize() - BufferStart <= NeededSize)
 		Buffer.resize_buffer(Buffer.maxsize()*2);
@@ -12,13 +12,28 @@
 #include <unicode/tmutfmt.h>
 
 #include <stdarg.h>
+#include <stdint.h>
+
+#include <unordered_map>
+
+//djb2 hash of a source text, translations are indexed by it.
+//constexpr so that it can be computed at compile time for literals.
+constexpr uint32_t LocalizationHash(const char* pText)
+{
+	uint32_t Hash = 5381;
+	for(; *pText; pText++)
+		Hash = ((Hash << 5) + Hash) + static_cast<unsigned char>(*pText); /* Hash * 33 + c */
+	return Hash;
+}
 
 struct CLocalizableString
 {
 	const char* m_pText;
+	uint32_t m_Hash;
 	
-	CLocalizableString(const char* pText) :
-		m_pText(pText)
+	constexpr CLocalizableString(const char* pText) :
+		m_pText(pText),
+		m_Hash(LocalizationHash(pText))
 	{ }
 };
 
@@ -58,36 +73,95 @@ public:
 	static const char *LanguageCodeByCountryCode(int country);
 	static const char *FallbackLanguageForIpCountryCode(int Country);
 
+	//A text split into literal parts and {type:name} placeholders, so that
+	//formatting it is a walk over the tokens instead of parsing it again
+	class CFormatTemplate
+	{
+	public:
+		enum
+		{
+			TOKEN_TEXT=0,
+			TOKEN_STR,
+			TOKEN_INT,
+			TOKEN_PERCENT,
+			TOKEN_SEC,
+			TOKEN_UNKNOWN, //placeholder of an unknown type, produces nothing
+		};
+		
+		struct CToken
+		{
+			int m_Type;
+			int m_Start; //literal text, or name of the argument
+			int m_Length;
+		};
+		
+	private:
+		char* m_pText;
+		array<CToken> m_Tokens;
+		
+		CFormatTemplate(const CFormatTemplate&);
+		CFormatTemplate& operator=(const CFormatTemplate&);
+		
+	public:
+		CFormatTemplate(const char* pText);
+		~CFormatTemplate();
+		
+		inline const char* GetText() const { return m_pText; }
+		inline int NumTokens() const { return m_Tokens.size(); }
+		inline const CToken& GetToken(int Index) const { return m_Tokens[Index]; }
+	};
+
 	class CLanguage
 	{
 	protected:
 		class CEntry
 		{
 		public:
+			char* m_pKey;
+			CEntry* m_pNext; //next entry with the same hash
 			char* m_apVersions[NUM_PLURALTYPES];
+			CFormatTemplate* m_apTemplates[NUM_PLURALTYPES]; //compiled on first use
 			
-			CEntry()
+			CEntry(const char* pKey, CEntry* pNext) :
+				m_pNext(pNext)
 			{
+				int Length = str_length(pKey)+1;
+				m_pKey = new char[Length];
+				str_copy(m_pKey, pKey, Length);
+				
 				for(int i=0; i<NUM_PLURALTYPES; i++)
+				{
 					m_apVersions[i] = NULL;
+					m_apTemplates[i] = NULL;
+				}
 			}
 			
-			void Free()
+			~CEntry()
 			{
+				delete[] m_pKey;
 				for(int i=0; i<NUM_PLURALTYPES; i++)
+				{
 					if(m_apVersions[i])
 						delete[] m_apVersions[i];
+					if(m_apTemplates[i])
+						delete m_apTemplates[i];
+				}
 			}
 		};
 		
+		CEntry* AddEntry(const char* pKey);
+		CEntry* FindEntry(uint32_t Hash, const char* pKey) const;
+		int PluralType(int Number) const;
+		
 	protected:
 		char m_aName[64];
 		char m_aFilename[64];
 		char m_aParentFilename[64];
+		int m_ParentHandle;
 		bool m_Loaded;
 		int m_Direction;
 		
-		hashtable< CEntry, 128 > m_Translations;
+		std::unordered_map<uint32_t, CEntry*> m_Translations;
 	
 	public:
 		UPluralRules* m_pPluralRules;
@@ -101,14 +175,19 @@ public:
 		~CLanguage();
 		
 		inline const char* GetParentFilename() const { return m_aParentFilename; }
+		inline bool HasParent() const { return m_aParentFilename[0] != 0; }
+		inline int GetParentHandle() const { return m_ParentHandle; }
+		inline void SetParentHandle(int Handle) { m_ParentHandle = Handle; }
 		inline const char* GetFilename() const { return m_aFilename; }
 		inline const char* GetName() const { return m_aName; }
 		inline int GetWritingDirection() const { return m_Direction; }
 		inline void SetWritingDirection(int Direction) { m_Direction = Direction; }
 		inline bool IsLoaded() const { return m_Loaded; }
 		bool Load(CLocalization* pLocalization, class CStorage* pStorage);
-		const char* Localize(const char* pKey) const;
-		const char* Localize_P(int Number, const char* pText) const;
+		const char* Localize(uint32_t Hash, const char* pKey) const;
+		const char* Localize_P(int Number, uint32_t Hash, const char* pText) const;
+		const CFormatTemplate* LocalizeTemplate(uint32_t Hash, const char* pKey);
+		const CFormatTemplate* LocalizeTemplate_P(int Number, uint32_t Hash, const char* pText);
 	};
 	
 	enum
@@ -117,6 +196,11 @@ public:
 		DIRECTION_RTL,
 		NUM_DIRECTIONS,
 	};
+	
+	enum
+	{
+		LANGUAGE_MAIN=-1, //handle of unknown languages, they use the main language
+	};
 
 protected:
 	CLanguage* m_pMainLanguage;
@@ -124,14 +208,28 @@ protected:
 	bool m_UpdateListeners;
 	
 	UConverter* m_pUtf8Converter;
+	int m_Utf8MaxCharSize;
+	
+	//templates of texts without a translation, keyed by the text itself
+	enum
+	{
+		MAX_SOURCE_TEMPLATES=4096,
+	};
+	hashtable< CFormatTemplate*, 256 > m_SourceTemplates;
+	int m_NumSourceTemplates;
 
 public:
 	array<CLanguage*> m_pLanguages;
 	fixed_string128 m_Cfg_MainLanguage;
 
 protected:
-	const char* LocalizeWithDepth(const char* pLanguageCode, const char* pText, int Depth);
-	const char* LocalizeWithDepth_P(const char* pLanguageCode, int Number, const char* pText, int Depth);
+	const char* LocalizeWithDepth(int LanguageHandle, uint32_t Hash, const char* pText, int Depth);
+	const char* LocalizeWithDepth_P(int LanguageHandle, int Number, uint32_t Hash, const char* pText, int Depth);
+	const CFormatTemplate* LocalizeTemplateWithDepth(int LanguageHandle, uint32_t Hash, const char* pText, int Depth);
+	const CFormatTemplate* LocalizeTemplateWithDepth_P(int LanguageHandle, int Number, uint32_t Hash, const char* pText, int Depth);
+	const CFormatTemplate* GetSourceTemplate(const char* pText);
+	
+	void Format_T(dynamic_string& Buffer, CLanguage* pLanguage, const CFormatTemplate* pTemplate, va_list VarArgs);
 	
 	void AppendNumber(dynamic_string& Buffer, int& BufferIter, CLanguage* pLanguage, int Number);
 	void AppendPercent(dynamic_string& Buffer, int& BufferIter, CLanguage* pLanguage, double Number);
@@ -154,20 +252,34 @@ public:
 	
 	inline bool GetWritingDirection() const { return (!m_pMainLanguage ? DIRECTION_LTR : m_pMainLanguage->GetWritingDirection()); }
 	
+	//language handles are stable for the lifetime of the localization
+	int GetLanguageHandle(const char* pLanguageCode) const;
+	CLanguage* GetLanguage(int LanguageHandle);
+	
 	//localize
 	const char* Localize(const char* pLanguageCode, const char* pText);
+	const char* Localize(int LanguageHandle, const CLocalizableString& Text);
 	//localize and find the appropriate plural form based on Number
 	const char* Localize_P(const char* pLanguageCode, int Number, const char* pText);
+	const char* Localize_P(int LanguageHandle, int Number, const CLocalizableString& Text);
 	
 	//format
 	void Format_V(dynamic_string& Buffer, const char* pLanguageCode, const char* pText, va_list VarArgs);
 	void Format(dynamic_string& Buffer, const char* pLanguageCode, const char* pText, ...);
 	//localize, format
 	void Format_VL(dynamic_string& Buffer, const char* pLanguageCode, const char* pText, va_list VarArgs);
+	void Format_VL(dynamic_string& Buffer, int LanguageHandle, const char* pText, va_list VarArgs);
 	void Format_L(dynamic_string& Buffer, const char* pLanguageCode, const char* pText, ...);
+	void Format_L(dynamic_string& Buffer, int LanguageHandle, const char* pText, ...);
 	//localize, find the appropriate plural form based on Number and format
 	void Format_VLP(dynamic_string& Buffer, const char* pLanguageCode, int Number, const char* pText, va_list VarArgs);
+	void Format_VLP(dynamic_string& Buffer, int LanguageHandle, int Number, const char* pText, va_list VarArgs);
 	void Format_LP(dynamic_string& Buffer, const char* pLanguageCode, int Number, const char* pText, ...);
+	void Format_LP(dynamic_string& Buffer, int LanguageHandle, int Number, const char* pText, ...);
+	
+	//fingerprint of the template and of the argument values it references,
+	//two calls with the same key produce the same text for a given language
+	static uint64_t FormatKey_V(const char* pText, va_list VarArgs);
 	
 	void ArabicShaping(dynamic_string& Buffer, int BufferStart = 0);
 };
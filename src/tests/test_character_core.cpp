@@ -0,0 +1,298 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/map.h>
+#include <game/collision.h>
+#include <game/gamecore.h>
+#include <game/layers.h>
+#include <game/mapitems.h>
+#include <game/teamscore.h>
+
+#include <vector>
+
+// a map with only a game layer, solid borders and a few platforms
+class CTestMap : public IMap
+{
+	CMapItemGroup m_Group;
+	CMapItemLayerTilemap m_Layer;
+	std::vector<CTile> m_vTiles;
+
+public:
+	enum
+	{
+		WIDTH = 60,
+		HEIGHT = 40,
+	};
+
+	CTestMap()
+	{
+		mem_zero(&m_Group, sizeof(m_Group));
+		m_Group.m_Version = CMapItemGroup::CURRENT_VERSION;
+		m_Group.m_NumLayers = 1;
+		StrToInts(m_Group.m_aName, std::size(m_Group.m_aName), "Game");
+
+		mem_zero(&m_Layer, sizeof(m_Layer));
+		m_Layer.m_Layer.m_Type = LAYERTYPE_TILES;
+		m_Layer.m_Version = 3;
+		m_Layer.m_Width = WIDTH;
+		m_Layer.m_Height = HEIGHT;
+		m_Layer.m_Flags = TILESLAYERFLAG_GAME;
+
+		m_vTiles.resize(WIDTH * HEIGHT);
+		mem_zero(m_vTiles.data(), m_vTiles.size() * sizeof(CTile));
+		for(int y = 0; y < HEIGHT; y++)
+		{
+			for(int x = 0; x < WIDTH; x++)
+			{
+				int Index = TILE_AIR;
+				if(x == 0 || y == 0 || x == WIDTH - 1 || y == HEIGHT - 1)
+					Index = TILE_SOLID;
+				else if(y % 8 == 0 && x % 12 < 7)
+					Index = x % 12 == 3 ? TILE_NOHOOK : TILE_SOLID;
+				m_vTiles[y * WIDTH + x].m_Index = Index;
+			}
+		}
+	}
+
+	void *GetData(int Index) override { return m_vTiles.data(); }
+	int GetDataSize(int Index) const override { return m_vTiles.size() * sizeof(CTile); }
+	void *GetDataSwapped(int Index) override { return GetData(Index); }
+	void UnloadData(int Index) override {}
+	int NumData() const override { return 1; }
+
+	void *GetItem(int Index, int *pType, int *pId) override
+	{
+		if(Index == 0)
+			return &m_Group;
+		return &m_Layer;
+	}
+	int GetItemSize(int Index) override { return Index == 0 ? sizeof(m_Group) : sizeof(m_Layer); }
+	void GetType(int Type, int *pStart, int *pNum) override
+	{
+		*pStart = Type == MAPITEMTYPE_GROUP ? 0 : 1;
+		*pNum = Type == MAPITEMTYPE_GROUP || Type == MAPITEMTYPE_LAYER ? 1 : 0;
+	}
+	void *FindItem(int Type, int Id) override { return nullptr; }
+	int NumItems() const override { return 2; }
+};
+
+class CharacterCore : public ::testing::Test
+{
+protected:
+	enum
+	{
+		NUM_CORES = MAX_CLIENTS,
+		NUM_TICKS = 6000,
+	};
+
+	CTestMap m_Map;
+	CLayers m_Layers;
+	CCollision m_Collision;
+	CTeamsCore m_Teams;
+
+	// the recorded inputs of every core for every tick
+	std::vector<CNetObj_PlayerInput> m_vReplay;
+	std::vector<vec2> m_vSpawns;
+
+	void SetUp() override
+	{
+		m_Layers.Init(&m_Map);
+		m_Collision.Init(&m_Layers);
+
+		unsigned Seed = 1;
+		auto Random = [&Seed](int Max) {
+			Seed = Seed * 1103515245 + 12345;
+			return (int)((Seed >> 16) % Max);
+		};
+
+		for(int i = 0; i < NUM_CORES; i++)
+			m_vSpawns.emplace_back(64.0f + Random(CTestMap::WIDTH * 32 - 128), 64.0f + Random(CTestMap::HEIGHT * 32 - 128));
+
+		// players change their mind every few ticks and aim at random spots
+		m_vReplay.resize(NUM_TICKS * NUM_CORES);
+		for(int i = 0; i < NUM_CORES; i++)
+		{
+			CNetObj_PlayerInput Input;
+			mem_zero(&Input, sizeof(Input));
+			for(int Tick = 0; Tick < NUM_TICKS; Tick++)
+			{
+				if(Random(8) == 0)
+				{
+					Input.m_Direction = Random(3) - 1;
+					Input.m_Jump = Random(4) == 0;
+					Input.m_Hook = Random(3) != 0;
+					Input.m_TargetX = Random(601) - 300;
+					Input.m_TargetY = Random(601) - 300;
+				}
+				m_vReplay[Tick * NUM_CORES + i] = Input;
+			}
+		}
+	}
+
+	// runs the replay like the game world, with the grid or with full scans
+	void Run(bool UseGrid, bool PlayerCollision, std::vector<CNetObj_CharacterCore> *pvStates, std::vector<vec2> *pvVels)
+	{
+		CTuningParams Tuning;
+		Tuning.Set("player_collision", PlayerCollision);
+
+		CWorldCore World;
+		World.m_UseGrid = UseGrid;
+		std::vector<CCharacterCore> vCores(NUM_CORES);
+		for(int i = 0; i < NUM_CORES; i++)
+		{
+			vCores[i].Init(&World, &m_Collision, &m_Teams);
+			vCores[i].m_Id = i;
+			vCores[i].m_Pos = m_vSpawns[i];
+			World.m_apCharacters[i] = &vCores[i];
+		}
+
+		CCharacterCore::CParams Params(&Tuning);
+		for(int Tick = 0; Tick < NUM_TICKS; Tick++)
+		{
+			const CNetObj_PlayerInput *pInputs = &m_vReplay[Tick * NUM_CORES];
+
+			// gameplay teleporting a character, and one dying and respawning
+			if(Tick % 50 == 0)
+			{
+				CCharacterCore &Core = vCores[Tick / 50 % NUM_CORES];
+				Core.m_Pos = m_vSpawns[(Tick / 50 + 1) % NUM_CORES];
+				Core.UpdateWorldGrid();
+				Core.SetHookedPlayer(-1);
+				Core.m_HookState = HOOK_RETRACTED;
+				Core.m_HookPos = Core.m_Pos;
+			}
+			if(Tick % 70 == 0)
+			{
+				const int Id = Tick / 70 % NUM_CORES;
+				World.m_apCharacters[Id] = World.m_apCharacters[Id] ? nullptr : &vCores[Id];
+				World.UpdateGrid(Id);
+			}
+
+			World.UpdateGrid();
+			for(int i = 0; i < NUM_CORES; i++)
+			{
+				if(!World.m_apCharacters[i])
+					continue;
+				vCores[i].m_Input = pInputs[i];
+				vCores[i].Tick(true, &Params);
+			}
+			World.UpdateGrid();
+			for(int i = 0; i < NUM_CORES; i++)
+			{
+				if(!World.m_apCharacters[i])
+					continue;
+				vCores[i].Move(&Params);
+				vCores[i].Quantize();
+			}
+
+			for(int i = 0; i < NUM_CORES; i++)
+			{
+				CNetObj_CharacterCore State;
+				mem_zero(&State, sizeof(State));
+				vCores[i].Write(&State);
+				pvStates->push_back(State);
+				pvVels->push_back(vCores[i].m_Vel);
+			}
+		}
+	}
+
+	void ExpectGridEqualsFullScans(bool PlayerCollision)
+	{
+		std::vector<CNetObj_CharacterCore> vFull, vGrid;
+		std::vector<vec2> vFullVels, vGridVels;
+		Run(false, PlayerCollision, &vFull, &vFullVels);
+		Run(true, PlayerCollision, &vGrid, &vGridVels);
+
+		ASSERT_EQ(vFull.size(), vGrid.size());
+		int NumHooked = 0;
+		for(int i = 0; i < (int)vFull.size(); i++)
+		{
+			ASSERT_EQ(mem_comp(&vFull[i], &vGrid[i], sizeof(CNetObj_CharacterCore)), 0) << "tick " << i / NUM_CORES << " core " << i % NUM_CORES;
+			ASSERT_EQ(mem_comp(&vFullVels[i], &vGridVels[i], sizeof(vec2)), 0) << "tick " << i / NUM_CORES << " core " << i % NUM_CORES;
+			NumHooked += vFull[i].m_HookedPlayer != -1;
+		}
+		// the replay has to hook players for the comparison to mean something
+		EXPECT_GT(NumHooked, 0);
+	}
+};
+
+TEST_F(CharacterCore, GridEqualsFullScans)
+{
+	ExpectGridEqualsFullScans(true);
+}
+
+TEST_F(CharacterCore, GridEqualsFullScansPlayerCollisionOff)
+{
+	ExpectGridEqualsFullScans(false);
+}
+
+TEST_F(CharacterCore, GridFindsNeighbours)
+{
+	unsigned Seed = 7;
+	auto Random = [&Seed](int Max) {
+		Seed = Seed * 1103515245 + 12345;
+		return (int)((Seed >> 16) % Max);
+	};
+
+	CWorldCore World;
+	std::vector<CCharacterCore> vCores(MAX_CLIENTS);
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		vCores[i].Init(&World, &m_Collision, &m_Teams);
+		vCores[i].m_Id = i;
+		vCores[i].m_Pos = vec2(Random(4000), Random(4000));
+		World.m_apCharacters[i] = &vCores[i];
+		vCores[i].UpdateWorldGrid();
+	}
+
+	int NumCandidates = 0;
+	for(int Round = 0; Round < 2000; Round++)
+	{
+		// players walk, teleport, die and respawn
+		CCharacterCore &Core = vCores[Random(MAX_CLIENTS)];
+		switch(Random(4))
+		{
+		case 0:
+			Core.m_Pos = vec2(Random(4000), Random(4000));
+			break;
+		case 1:
+			World.m_apCharacters[Core.m_Id] = World.m_apCharacters[Core.m_Id] ? nullptr : &Core;
+			World.UpdateGrid(Core.m_Id);
+			break;
+		default:
+			Core.m_Pos += vec2(Random(41) - 20, Random(41) - 20);
+		}
+		Core.UpdateWorldGrid();
+
+		const vec2 Min = vec2(Random(4200) - 100, Random(4200) - 100);
+		const vec2 Max = Min + vec2(Random(300), Random(300));
+		const uint64_t Candidates = World.FindCharacters(Min, Max);
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			const bool Candidate = Candidates & ((uint64_t)1 << i);
+			NumCandidates += Candidate && World.m_apCharacters[i];
+			const CCharacterCore *pCharCore = World.m_apCharacters[i];
+			if(!pCharCore)
+				continue;
+			const vec2 Pos = pCharCore->m_Pos;
+			if(Pos.x >= Min.x && Pos.x <= Max.x && Pos.y >= Min.y && Pos.y <= Max.y)
+			{
+				EXPECT_TRUE(Candidate) << "round " << Round << " core " << i;
+			}
+		}
+	}
+	// the boxes cover a few cells, far from everyone
+	EXPECT_LT(NumCandidates, 2000 * MAX_CLIENTS / 4);
+
+	// a box larger than the grid finds everyone
+	EXPECT_EQ(World.FindCharacters(vec2(-1e9f, -1e9f), vec2(1e9f, 1e9f)), ~(uint64_t)0);
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/console.h>
+#include <engine/shared/config.h>
+
+#include <string>
+#include <vector>
+
+static void CountCallback(IConsole::IResult *pResult, void *pUserData)
+{
+	(*static_cast<int *>(pUserData))++;
+}
+
+TEST(Console, FindCommandNoCase)
+{
+	std::unique_ptr<IConsole> pConsole = CreateConsole(CFGFLAG_SERVER);
+	int Calls = 0;
+	pConsole->Register("sv_test_command", "", CFGFLAG_SERVER, CountCallback, &Calls, "");
+
+	EXPECT_TRUE(pConsole->GetCommandInfo("sv_test_command", CFGFLAG_SERVER, false));
+	EXPECT_TRUE(pConsole->GetCommandInfo("SV_Test_Command", CFGFLAG_SERVER, false));
+	EXPECT_FALSE(pConsole->GetCommandInfo("sv_test_command", CFGFLAG_CLIENT, false));
+	EXPECT_FALSE(pConsole->GetCommandInfo("sv_test_comman", CFGFLAG_SERVER, false));
+
+	pConsole->ExecuteLine("SV_TEST_COMMAND; sv_test_command");
+	EXPECT_EQ(Calls, 2);
+}
+
+TEST(Console, TempCommands)
+{
+	std::unique_ptr<IConsole> pConsole = CreateConsole(CFGFLAG_SERVER);
+	pConsole->RegisterTemp("temp_a", "", CFGFLAG_SERVER, "");
+	pConsole->RegisterTemp("temp_b", "", CFGFLAG_SERVER, "");
+	EXPECT_TRUE(pConsole->GetCommandInfo("temp_a", CFGFLAG_SERVER, true));
+	EXPECT_TRUE(pConsole->GetCommandInfo("temp_b", CFGFLAG_SERVER, true));
+
+	// the recycled entry has to be indexed under its new name
+	pConsole->DeregisterTemp("temp_a");
+	EXPECT_FALSE(pConsole->GetCommandInfo("temp_a", CFGFLAG_SERVER, true));
+	pConsole->RegisterTemp("temp_c", "", CFGFLAG_SERVER, "");
+	EXPECT_FALSE(pConsole->GetCommandInfo("temp_a", CFGFLAG_SERVER, true));
+	EXPECT_TRUE(pConsole->GetCommandInfo("temp_c", CFGFLAG_SERVER, true));
+
+	pConsole->DeregisterTempAll();
+	EXPECT_FALSE(pConsole->GetCommandInfo("temp_b", CFGFLAG_SERVER, true));
+	EXPECT_FALSE(pConsole->GetCommandInfo("temp_c", CFGFLAG_SERVER, true));
+	EXPECT_TRUE(pConsole->GetCommandInfo("echo", CFGFLAG_SERVER, false));
+}
+
+// prints a timing, run with --gtest_also_run_disabled_tests
+TEST(Console, DISABLED_ExecuteConfigBenchmark)
+{
+	std::unique_ptr<IConsole> pConsole = CreateConsole(CFGFLAG_SERVER);
+	pConsole->SetAccessLevel(IConsole::ACCESS_LEVEL_ADMIN);
+
+	// register a command set roughly the size of the server's
+	enum
+	{
+		NUM_COMMANDS = 800,
+		NUM_LINES = 5000,
+	};
+	int Calls = 0;
+	std::vector<std::string> vNames;
+	for(int i = 0; i < NUM_COMMANDS; i++)
+	{
+		char aName[64];
+		str_format(aName, sizeof(aName), "sv_bench_variable_%d", i);
+		vNames.emplace_back(aName);
+	}
+	for(const std::string &Name : vNames)
+		pConsole->Register(Name.c_str(), "?i[value]", CFGFLAG_SERVER, CountCallback, &Calls, "");
+
+	std::vector<std::string> vLines;
+	for(int i = 0; i < NUM_LINES; i++)
+		vLines.push_back(vNames[(i * 7919) % NUM_COMMANDS] + " " + std::to_string(i));
+
+	int64_t Start = time_get();
+	for(const std::string &Line : vLines)
+		pConsole->ExecuteLine(Line.c_str());
+	int64_t Elapsed = time_get() - Start;
+
+	EXPECT_EQ(Calls, (int)NUM_LINES);
+	dbg_msg("test", "executed %d config lines in %.3f ms", (int)NUM_LINES, Elapsed * 1000.0 / time_freq());
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/jobs.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+class CTestJob : public IJob
+{
+	std::function<void()> m_pfnRun;
+
+	void Run() override { m_pfnRun(); }
+
+public:
+	CTestJob(std::function<void()> &&pfnRun, EJobPriority Priority = PRIORITY_NORMAL, bool IsAbortable = false) :
+		m_pfnRun(std::move(pfnRun))
+	{
+		SetPriority(Priority);
+		Abortable(IsAbortable);
+	}
+};
+
+static void Busy(int64_t Duration)
+{
+	const int64_t End = time_get() + Duration;
+	while(time_get() < End)
+	{
+	}
+}
+
+TEST(Jobs, RunsAllJobs)
+{
+	static const int s_NumJobs = 200;
+	CJobPool Pool;
+	Pool.Init(4);
+
+	// jobs adding jobs put them into their own worker's queues
+	std::atomic<int> NumRun(0);
+	std::vector<std::shared_ptr<IJob>> vpJobs;
+	std::vector<std::shared_ptr<IJob>> vpNested(s_NumJobs);
+	for(int i = 0; i < s_NumJobs; i++)
+	{
+		vpJobs.push_back(std::make_shared<CTestJob>([&, i]() {
+			NumRun++;
+			vpNested[i] = std::make_shared<CTestJob>([&]() { NumRun++; }, i % 2 ? IJob::PRIORITY_NORMAL : IJob::PRIORITY_BACKGROUND);
+			Pool.Add(vpNested[i]);
+		}));
+		Pool.Add(vpJobs.back());
+	}
+	for(const std::shared_ptr<IJob> &pJob : vpJobs)
+		while(!pJob->Done())
+			thread_yield();
+
+	Pool.Shutdown();
+	EXPECT_EQ(NumRun, 2 * s_NumJobs);
+	for(const std::shared_ptr<IJob> &pJob : vpNested)
+		EXPECT_EQ(pJob->State(), IJob::STATE_DONE);
+}
+
+TEST(Jobs, NormalBeforeBackground)
+{
+	CJobPool Pool;
+	Pool.Init(1);
+
+	// keep the only worker busy until everything is queued
+	std::atomic<bool> Release(false);
+	std::shared_ptr<IJob> pGate = std::make_shared<CTestJob>([&]() {
+		while(!Release)
+			thread_yield();
+	});
+	Pool.Add(pGate);
+	while(pGate->State() != IJob::STATE_RUNNING)
+		thread_yield();
+
+	std::vector<int> vOrder;
+	for(int i = 0; i < 10; i++)
+	{
+		const bool Background = i < 5;
+		Pool.Add(std::make_shared<CTestJob>([&vOrder, i]() { vOrder.push_back(i); }, Background ? IJob::PRIORITY_BACKGROUND : IJob::PRIORITY_NORMAL));
+	}
+	Release = true;
+	Pool.Shutdown();
+
+	// the normal jobs in order, then the background ones
+	EXPECT_EQ(vOrder, std::vector<int>({5, 6, 7, 8, 9, 0, 1, 2, 3, 4}));
+}
+
+TEST(Jobs, RunInlineTakesBackQueuedJob)
+{
+	CJobPool Pool;
+	Pool.Init(1);
+
+	std::atomic<bool> Release(false);
+	std::shared_ptr<IJob> pGate = std::make_shared<CTestJob>([&]() {
+		while(!Release)
+			thread_yield();
+	});
+	Pool.Add(pGate);
+	while(pGate->State() != IJob::STATE_RUNNING)
+		thread_yield();
+
+	// queued behind the gate, run on this thread instead and only once
+	std::atomic<int> NumRun(0);
+	std::shared_ptr<IJob> pJob = std::make_shared<CTestJob>([&]() { NumRun++; }, IJob::PRIORITY_BACKGROUND);
+	Pool.Add(pJob);
+	EXPECT_TRUE(pJob->RunInline());
+	EXPECT_EQ(pJob->State(), IJob::STATE_DONE);
+	EXPECT_FALSE(pJob->RunInline());
+	EXPECT_FALSE(pGate->RunInline());
+
+	Release = true;
+	Pool.Shutdown();
+	EXPECT_EQ(NumRun, 1);
+}
+
+TEST(Jobs, ShutdownAbortsAbortableJobs)
+{
+	CJobPool Pool;
+	Pool.Init(2);
+
+	std::atomic<bool> Release(false);
+	std::vector<std::shared_ptr<IJob>> vpGates;
+	for(int i = 0; i < 2; i++)
+	{
+		vpGates.push_back(std::make_shared<CTestJob>([&]() {
+			while(!Release)
+				thread_yield();
+		}));
+		Pool.Add(vpGates.back());
+	}
+	for(const std::shared_ptr<IJob> &pGate : vpGates)
+		while(pGate->State() != IJob::STATE_RUNNING)
+			thread_yield();
+
+	std::vector<std::shared_ptr<IJob>> vpJobs;
+	for(int i = 0; i < 20; i++)
+	{
+		vpJobs.push_back(std::make_shared<CTestJob>([]() {}, i % 3 ? IJob::PRIORITY_NORMAL : IJob::PRIORITY_BACKGROUND, i % 2));
+		Pool.Add(vpJobs.back());
+	}
+	std::thread Releaser([&]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		Release = true;
+	});
+	Pool.Shutdown();
+	Releaser.join();
+
+	for(int i = 0; i < 20; i++)
+		EXPECT_EQ(vpJobs[i]->State(), i % 2 ? IJob::STATE_ABORTED : IJob::STATE_DONE) << i;
+
+	// no more jobs once shut down
+	std::shared_ptr<IJob> pLate = std::make_shared<CTestJob>([]() {}, IJob::PRIORITY_NORMAL, true);
+	Pool.Add(pLate);
+	EXPECT_EQ(pLate->State(), IJob::STATE_ABORTED);
+}
+
+// busy for half a second and prints a timing, run with --gtest_also_run_disabled_tests
+TEST(Jobs, DISABLED_Benchmark)
+{
+	enum
+	{
+		NUM_THREADS = 4,
+		NUM_BACKGROUND = 40,
+		NUM_SHORT = 400,
+	};
+
+	// large background jobs with short ones arriving in between, as with a
+	// map conversion while players connect
+	auto Measure = [](bool UsePriorities, double *pMeanLatency, double *pMaxLatency, double *pTotal) {
+		CJobPool Pool;
+		Pool.Init(NUM_THREADS);
+		const int64_t Freq = time_freq();
+		std::vector<int64_t> vLatencies(NUM_SHORT);
+		std::vector<std::shared_ptr<IJob>> vpJobs;
+
+		const int64_t Start = time_get();
+		for(int i = 0; i < NUM_BACKGROUND; i++)
+		{
+			vpJobs.push_back(std::make_shared<CTestJob>([Freq]() { Busy(Freq / 200); }, UsePriorities ? IJob::PRIORITY_BACKGROUND : IJob::PRIORITY_NORMAL));
+			Pool.Add(vpJobs.back());
+		}
+		for(int i = 0; i < NUM_SHORT; i++)
+		{
+			const int64_t Added = time_get();
+			vpJobs.push_back(std::make_shared<CTestJob>([&vLatencies, i, Added, Freq]() {
+				vLatencies[i] = time_get() - Added;
+				Busy(Freq / 20000);
+			}));
+			Pool.Add(vpJobs.back());
+			Busy(Freq / 10000);
+		}
+		for(const std::shared_ptr<IJob> &pJob : vpJobs)
+			while(!pJob->Done())
+				thread_yield();
+		*pTotal = (time_get() - Start) * 1000.0 / Freq;
+		Pool.Shutdown();
+
+		int64_t Sum = 0;
+		for(int64_t Latency : vLatencies)
+			Sum += Latency;
+		*pMeanLatency = Sum * 1000.0 / (int)NUM_SHORT / Freq;
+		*pMaxLatency = *std::max_element(vLatencies.begin(), vLatencies.end()) * 1000.0 / Freq;
+	};
+
+	double MeanFifo, MaxFifo, TotalFifo;
+	double MeanPriority, MaxPriority, TotalPriority;
+	Measure(false, &MeanFifo, &MaxFifo, &TotalFifo);
+	Measure(true, &MeanPriority, &MaxPriority, &TotalPriority);
+
+	printf("%d threads, %d background jobs of 5 ms, %d short jobs of 0.05 ms\n", (int)NUM_THREADS, (int)NUM_BACKGROUND, (int)NUM_SHORT);
+	printf("one priority: short job latency mean %.3f ms, max %.3f ms, total %.3f ms\n", MeanFifo, MaxFifo, TotalFifo);
+	printf("priorities:   short job latency mean %.3f ms, max %.3f ms, total %.3f ms\n", MeanPriority, MaxPriority, TotalPriority);
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/server/leaderboard.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+TEST(Leaderboard, Empty)
+{
+	CLeaderboard Leaderboard;
+	const CLeaderboard::CEntry *apEntries[10];
+	EXPECT_EQ(Leaderboard.Rank(0, "nameless tee"), 0);
+	EXPECT_EQ(Leaderboard.Top(0, apEntries, 10), 0);
+	EXPECT_EQ(Leaderboard.NumPlayers(0), 0);
+}
+
+TEST(Leaderboard, Basic)
+{
+	CLeaderboard Leaderboard;
+	Leaderboard.AddRound(0, "b", 50);
+	Leaderboard.AddRound(0, "a", 50);
+	Leaderboard.AddRound(0, "c", 30);
+	Leaderboard.AddRound(100, "c", 10);
+	Leaderboard.AddRound(0, "c", 30);
+
+	const CLeaderboard::CEntry *pEntry;
+	EXPECT_EQ(Leaderboard.Rank(0, "c", &pEntry), 1);
+	EXPECT_EQ(pEntry->m_Score, 60);
+	EXPECT_EQ(pEntry->m_NumRounds, 2);
+	// equal scores are ordered by name
+	EXPECT_EQ(Leaderboard.Rank(0, "a"), 2);
+	EXPECT_EQ(Leaderboard.Rank(0, "b"), 3);
+	EXPECT_EQ(Leaderboard.Rank(100, "c"), 1);
+	EXPECT_EQ(Leaderboard.Rank(100, "a"), 0);
+
+	const CLeaderboard::CEntry *apEntries[2];
+	ASSERT_EQ(Leaderboard.Top(0, apEntries, 2), 2);
+	EXPECT_STREQ(apEntries[0]->m_aName, "c");
+	EXPECT_STREQ(apEntries[1]->m_aName, "a");
+}
+
+TEST(Leaderboard, BestRoundsOnly)
+{
+	CLeaderboard Leaderboard;
+	for(int i = 0; i < CLeaderboard::NUM_BEST_ROUNDS; i++)
+		Leaderboard.AddRound(0, "a", 10);
+	Leaderboard.AddRound(0, "a", 5);
+	Leaderboard.AddRound(0, "a", 20);
+
+	const CLeaderboard::CEntry *pEntry;
+	ASSERT_EQ(Leaderboard.Rank(0, "a", &pEntry), 1);
+	EXPECT_EQ(pEntry->m_Score, (CLeaderboard::NUM_BEST_ROUNDS - 1) * 10 + 20);
+	EXPECT_EQ(pEntry->m_NumRounds, (int)CLeaderboard::NUM_BEST_ROUNDS);
+}
+
+TEST(Leaderboard, IncrementalMatchesBulk)
+{
+	CLeaderboard Incremental;
+	CLeaderboard Bulk;
+	std::map<std::string, std::vector<int>> Rounds;
+	unsigned Seed = 1;
+	for(int i = 0; i < 20000; i++)
+	{
+		Seed = Seed * 1103515245 + 12345;
+		char aName[MAX_NAME_LENGTH];
+		str_format(aName, sizeof(aName), "player%d", (Seed >> 16) % 500);
+		Seed = Seed * 1103515245 + 12345;
+		int Score = 10 + (Seed >> 16) % 200;
+		Incremental.AddRound(0, aName, Score);
+		Bulk.AddRoundUnsorted(0, aName, Score);
+		Rounds[aName].push_back(Score);
+	}
+	Bulk.Sort();
+
+	// reference: sum of the best rounds, sorted by score and name
+	std::vector<std::pair<int, std::string>> vExpected;
+	for(auto &[Name, vScores] : Rounds)
+	{
+		std::sort(vScores.begin(), vScores.end(), std::greater<int>());
+		vScores.resize(std::min<size_t>(vScores.size(), CLeaderboard::NUM_BEST_ROUNDS));
+		int Sum = 0;
+		for(int Score : vScores)
+			Sum += Score;
+		vExpected.emplace_back(-Sum, Name);
+	}
+	std::sort(vExpected.begin(), vExpected.end());
+
+	ASSERT_EQ(Incremental.NumPlayers(0), (int)vExpected.size());
+	ASSERT_EQ(Bulk.NumPlayers(0), (int)vExpected.size());
+	for(size_t i = 0; i < vExpected.size(); i++)
+	{
+		const CLeaderboard::CEntry *pEntry;
+		EXPECT_EQ(Incremental.Rank(0, vExpected[i].second.c_str(), &pEntry), (int)i + 1);
+		EXPECT_EQ(pEntry->m_Score, -vExpected[i].first);
+		EXPECT_EQ(Bulk.Rank(0, vExpected[i].second.c_str()), (int)i + 1);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/server/login_throttle.h>
+
+static NETADDR Addr(const char *pAddr)
+{
+	NETADDR Addr;
+	EXPECT_EQ(net_addr_from_str(&Addr, pAddr), 0);
+	return Addr;
+}
+
+TEST(LoginThrottle, BlocksAfterFailures)
+{
+	CLoginThrottle Throttle;
+	const int64_t Start = 1000 * time_freq();
+	NETADDR Client = Addr("1.2.3.4:8303");
+	for(int i = 0; i < CLoginThrottle::MAX_FAILURES - 1; i++)
+		Throttle.OnFailure(&Client, Start + i);
+	EXPECT_EQ(Throttle.BlockedFor(&Client, Start), 0);
+
+	Throttle.OnFailure(&Client, Start + 10 * time_freq());
+	EXPECT_EQ(Throttle.BlockedFor(&Client, Start + 10 * time_freq()), CLoginThrottle::FAILURE_WINDOW - 10);
+	// the port is ignored, other addresses aren't affected
+	NETADDR OtherPort = Addr("1.2.3.4:1234");
+	NETADDR Other = Addr("1.2.3.5:8303");
+	EXPECT_GT(Throttle.BlockedFor(&OtherPort, Start), 0);
+	EXPECT_EQ(Throttle.BlockedFor(&Other, Start), 0);
+
+	// the block ends with the window
+	const int64_t End = Start + CLoginThrottle::FAILURE_WINDOW * time_freq();
+	EXPECT_EQ(Throttle.BlockedFor(&Client, End), 0);
+	Throttle.OnFailure(&Client, End);
+	EXPECT_EQ(Throttle.BlockedFor(&Client, End), 0);
+}
+
+TEST(LoginThrottle, Prune)
+{
+	CLoginThrottle Throttle;
+	NETADDR Client = Addr("1.2.3.4:8303");
+	for(int i = 0; i < CLoginThrottle::MAX_FAILURES; i++)
+		Throttle.OnFailure(&Client, 0);
+	Throttle.Prune(1);
+	EXPECT_GT(Throttle.BlockedFor(&Client, 1), 0);
+	Throttle.Prune(CLoginThrottle::FAILURE_WINDOW * time_freq());
+	EXPECT_EQ(Throttle.BlockedFor(&Client, 1), 0);
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
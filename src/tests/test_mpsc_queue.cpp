@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include <base/tl/mpsc_queue.h>
+
+#include <thread>
+#include <vector>
+
+TEST(MpscQueue, Basic)
+{
+	CMpscQueue<int, 4> Queue;
+	int Value;
+	EXPECT_FALSE(Queue.TryPop(&Value));
+	for(int i = 0; i < 4; i++)
+		EXPECT_TRUE(Queue.TryPush(i));
+	EXPECT_FALSE(Queue.TryPush(4));
+	for(int i = 0; i < 4; i++)
+	{
+		ASSERT_TRUE(Queue.TryPop(&Value));
+		EXPECT_EQ(Value, i);
+	}
+	EXPECT_FALSE(Queue.TryPop(&Value));
+
+	// wraps around
+	for(int Round = 0; Round < 10; Round++)
+	{
+		EXPECT_TRUE(Queue.TryPush(Round));
+		ASSERT_TRUE(Queue.TryPop(&Value));
+		EXPECT_EQ(Value, Round);
+	}
+}
+
+TEST(MpscQueue, Stress)
+{
+	static const int s_NumProducers = 8;
+	static const int s_NumItems = 2000;
+	// small enough for the producers to fill it
+	CMpscQueue<int, 64> Queue;
+
+	std::vector<std::thread> vProducers;
+	for(int p = 0; p < s_NumProducers; p++)
+	{
+		vProducers.emplace_back([&Queue, p]() {
+			for(int i = 0; i < s_NumItems; i++)
+				Queue.Push(p * s_NumItems + i);
+		});
+	}
+
+	// the items of every producer arrive in order
+	int aNext[s_NumProducers] = {0};
+	int NumReceived = 0;
+	while(NumReceived < s_NumProducers * s_NumItems)
+	{
+		int Value;
+		if(!Queue.TryPop(&Value))
+			continue;
+		int Producer = Value / s_NumItems;
+		ASSERT_GE(Producer, 0);
+		ASSERT_LT(Producer, s_NumProducers);
+		ASSERT_EQ(Value % s_NumItems, aNext[Producer]);
+		aNext[Producer]++;
+		NumReceived++;
+	}
+	for(std::thread &Producer : vProducers)
+		Producer.join();
+	int Value;
+	EXPECT_FALSE(Queue.TryPop(&Value));
+
+	int64_t NumLatencies = 0;
+	for(int p = 0; p < decltype(Queue)::MAX_PRODUCERS; p++)
+		for(int b = 0; b < decltype(Queue)::NUM_LATENCY_BUCKETS; b++)
+			NumLatencies += Queue.NumLatencies(p, b);
+	EXPECT_EQ(NumLatencies, (int64_t)s_NumProducers * s_NumItems);
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/server/name_ban.h>
+
+#include <string>
+#include <vector>
+
+// reference implementation, the linear scan CNameBans::IsBanned replaces
+static const CNameBan *IsNameBannedLinear(const char *pName, const std::vector<CNameBan> &vNameBans)
+{
+	char aTrimmed[MAX_NAME_LENGTH];
+	str_copy(aTrimmed, str_utf8_skip_whitespaces(pName));
+	str_utf8_trim_right(aTrimmed);
+
+	int aSkeleton[MAX_NAME_SKELETON_LENGTH];
+	int SkeletonLength = str_utf8_to_skeleton(aTrimmed, aSkeleton, std::size(aSkeleton));
+	int aBuffer[MAX_NAME_SKELETON_LENGTH * 2 + 2];
+
+	const CNameBan *pResult = nullptr;
+	for(const CNameBan &Ban : vNameBans)
+	{
+		int Distance = str_utf32_dist_buffer(aSkeleton, SkeletonLength, Ban.m_aSkeleton, Ban.m_SkeletonLength, aBuffer, std::size(aBuffer));
+		if(Distance <= Ban.m_Distance || (Ban.m_IsSubstring == 1 && str_utf8_find_nocase(pName, Ban.m_aName)))
+			pResult = &Ban;
+	}
+	return pResult;
+}
+
+// a small alphabet with confusables produces many near matches
+static const char s_aConfusableChars[] = "abcdeilmnorstuIl10O _";
+static const char s_aNameChars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 _.-";
+
+static void RandomName(char *pName, int Size, const char *pChars, unsigned *pSeed)
+{
+	const int NumChars = str_length(pChars);
+	*pSeed = *pSeed * 1103515245 + 12345;
+	int Length = 3 + (*pSeed >> 16) % (Size - 4);
+	for(int i = 0; i < Length; i++)
+	{
+		*pSeed = *pSeed * 1103515245 + 12345;
+		pName[i] = pChars[(*pSeed >> 16) % NumChars];
+	}
+	pName[Length] = '\0';
+}
+
+TEST(NameBan, Basic)
+{
+	CNameBans NameBans;
+	EXPECT_FALSE(NameBans.IsBanned("nameless tee"));
+
+	NameBans.Set("nameless tee", 3, 0, "default name");
+	ASSERT_TRUE(NameBans.IsBanned("nameless tee"));
+	EXPECT_STREQ(NameBans.IsBanned("  nameless tee ")->m_aReason, "default name");
+	EXPECT_TRUE(NameBans.IsBanned("nameIess tee"));
+	EXPECT_TRUE(NameBans.IsBanned("namelss te"));
+	EXPECT_FALSE(NameBans.IsBanned("brainless tee"));
+
+	NameBans.Set("admin", 0, 1, "");
+	EXPECT_TRUE(NameBans.IsBanned("the real ADMIN"));
+	EXPECT_FALSE(NameBans.IsBanned("the real admn"));
+
+	NameBans.Set("admin", 1, 0, "");
+	EXPECT_FALSE(NameBans.IsBanned("the real ADMIN"));
+	EXPECT_TRUE(NameBans.IsBanned("admn"));
+
+	EXPECT_TRUE(NameBans.Remove("admin"));
+	EXPECT_FALSE(NameBans.Remove("admin"));
+	EXPECT_FALSE(NameBans.IsBanned("admn"));
+	EXPECT_EQ(NameBans.Bans().size(), 1u);
+}
+
+TEST(NameBan, MatchesLinearScan)
+{
+	CNameBans NameBans;
+	unsigned Seed = 1;
+	char aName[MAX_NAME_LENGTH];
+	for(int i = 0; i < 500; i++)
+	{
+		RandomName(aName, sizeof(aName), s_aConfusableChars, &Seed);
+		NameBans.Set(aName, str_length(aName) / 3, i % 17 == 0, "");
+	}
+
+	for(int i = 0; i < 1000; i++)
+	{
+		RandomName(aName, sizeof(aName), s_aConfusableChars, &Seed);
+		EXPECT_EQ(NameBans.IsBanned(aName), IsNameBannedLinear(aName, NameBans.Bans())) << aName;
+	}
+}
+
+// takes seconds, run with --gtest_also_run_disabled_tests
+TEST(NameBan, DISABLED_Benchmark)
+{
+	enum
+	{
+		NUM_BANS = 10000,
+		NUM_CHECKS = 2000,
+	};
+
+	CNameBans NameBans;
+	unsigned Seed = 1;
+	char aName[MAX_NAME_LENGTH];
+	for(int i = 0; i < NUM_BANS; i++)
+	{
+		RandomName(aName, sizeof(aName), s_aNameChars, &Seed);
+		NameBans.Set(aName, str_length(aName) / 3, i % 100 == 0, "");
+	}
+
+	std::vector<std::string> vNames;
+	for(int i = 0; i < NUM_CHECKS; i++)
+	{
+		RandomName(aName, sizeof(aName), s_aNameChars, &Seed);
+		vNames.emplace_back(aName);
+	}
+
+	int64_t Start = time_get();
+	int Indexed = 0;
+	for(const std::string &Name : vNames)
+		Indexed += NameBans.IsBanned(Name.c_str()) != nullptr;
+	int64_t IndexedTime = time_get() - Start;
+
+	Start = time_get();
+	int Linear = 0;
+	for(const std::string &Name : vNames)
+		Linear += IsNameBannedLinear(Name.c_str(), NameBans.Bans()) != nullptr;
+	int64_t LinearTime = time_get() - Start;
+
+	EXPECT_EQ(Indexed, Linear);
+	printf("%d name checks against %d bans: indexed %.3f ms, linear %.3f ms\n", (int)NUM_CHECKS, (int)NUM_BANS,
+		IndexedTime * 1000.0 / time_freq(), LinearTime * 1000.0 / time_freq());
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
@@ -0,0 +1,246 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <game/server/playermapper.h>
+
+#include <algorithm>
+#include <utility>
+
+// how the maps were updated before, every client ranked on every update
+static void UpdateFull(const CPlayerMapper::CClient *pClients)
+{
+	std::pair<float, int> aDist[MAX_CLIENTS];
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		int *pMap = pClients[i].m_pIdMap;
+		if(!pMap)
+			continue;
+		for(int j = 0; j < MAX_CLIENTS; j++)
+		{
+			aDist[j].second = j;
+			aDist[j].first = pClients[j].m_Visible ? distance(pClients[i].m_Pos, pClients[j].m_Pos) : 1e10;
+		}
+		aDist[i].first = 0;
+
+		int aReverse[MAX_CLIENTS];
+		for(int &Slot : aReverse)
+			Slot = -1;
+		for(int j = 0; j < VANILLA_MAX_CLIENTS; j++)
+		{
+			if(pMap[j] == -1)
+				continue;
+			if(aDist[pMap[j]].first > 1e9)
+				pMap[j] = -1;
+			else
+				aReverse[pMap[j]] = j;
+		}
+
+		std::nth_element(&aDist[0], &aDist[VANILLA_MAX_CLIENTS - 1], &aDist[MAX_CLIENTS]);
+
+		int Slot = 0;
+		int Demand = 0;
+		for(int j = 0; j < VANILLA_MAX_CLIENTS - 1; j++)
+		{
+			int k = aDist[j].second;
+			if(aReverse[k] != -1 || aDist[j].first > 1e9)
+				continue;
+			while(Slot < VANILLA_MAX_CLIENTS && pMap[Slot] != -1)
+				Slot++;
+			if(Slot < VANILLA_MAX_CLIENTS - 1)
+				pMap[Slot] = k;
+			else if(aDist[j].first < 1300)
+				Demand++;
+		}
+		for(int j = MAX_CLIENTS - 1; j > VANILLA_MAX_CLIENTS - 2; j--)
+		{
+			int k = aDist[j].second;
+			if(aReverse[k] != -1 && Demand-- > 0)
+				pMap[aReverse[k]] = -1;
+		}
+		pMap[VANILLA_MAX_CLIENTS - 1] = -1;
+	}
+}
+
+class PlayerMapper : public ::testing::Test
+{
+protected:
+	int m_aaMaps[MAX_CLIENTS][VANILLA_MAX_CLIENTS];
+	CPlayerMapper::CClient m_aClients[MAX_CLIENTS];
+	unsigned m_Seed = 1;
+
+	void SetUp() override
+	{
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			// what CPlayer::Reset does
+			for(int &Id : m_aaMaps[i])
+				Id = -1;
+			m_aaMaps[i][0] = i;
+			m_aClients[i].m_Pos = vec2(0, 0);
+			m_aClients[i].m_Visible = true;
+			m_aClients[i].m_pIdMap = m_aaMaps[i];
+		}
+	}
+
+	float Random(float Max)
+	{
+		m_Seed = m_Seed * 1103515245 + 12345;
+		return (m_Seed >> 16) % 10000 * Max / 10000;
+	}
+
+	int NumChanges(const int (*pOld)[VANILLA_MAX_CLIENTS]) const
+	{
+		int Num = 0;
+		for(int i = 0; i < MAX_CLIENTS; i++)
+			for(int s = 0; s < VANILLA_MAX_CLIENTS; s++)
+				Num += m_aaMaps[i][s] != pOld[i][s];
+		return Num;
+	}
+
+	void ExpectValid() const
+	{
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			if(!m_aClients[i].m_pIdMap)
+				continue;
+			bool aSeen[MAX_CLIENTS] = {};
+			bool Self = false;
+			for(int s = 0; s < VANILLA_MAX_CLIENTS; s++)
+			{
+				int Id = m_aaMaps[i][s];
+				if(Id == -1)
+					continue;
+				ASSERT_GE(Id, 0);
+				ASSERT_LT(Id, MAX_CLIENTS);
+				EXPECT_FALSE(aSeen[Id]);
+				aSeen[Id] = true;
+				Self |= Id == i;
+				EXPECT_TRUE(Id == i || m_aClients[Id].m_Visible);
+			}
+			EXPECT_TRUE(Self);
+			EXPECT_EQ(m_aaMaps[i][VANILLA_MAX_CLIENTS - 1], -1);
+		}
+	}
+};
+
+TEST_F(PlayerMapper, FewPlayers)
+{
+	CPlayerMapper Mapper;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		m_aClients[i].m_Pos = vec2(i * 5000.0f, 0);
+		// at most VANILLA_MAX_CLIENTS - 1 players, everyone knows everyone
+		m_aClients[i].m_Visible = i < VANILLA_MAX_CLIENTS - 1;
+		if(!m_aClients[i].m_Visible)
+			m_aClients[i] = {};
+	}
+	Mapper.Update(m_aClients);
+	ExpectValid();
+	for(int i = 0; i < VANILLA_MAX_CLIENTS - 1; i++)
+		for(int j = 0; j < VANILLA_MAX_CLIENTS - 1; j++)
+			EXPECT_NE(std::find(m_aaMaps[i], m_aaMaps[i] + VANILLA_MAX_CLIENTS, j), m_aaMaps[i] + VANILLA_MAX_CLIENTS);
+
+	// nothing moved, nobody is ranked again
+	int NumRanked = Mapper.NumRanked();
+	Mapper.Update(m_aClients);
+	EXPECT_EQ(Mapper.NumRanked(), NumRanked);
+
+	// a player without a character is removed from the maps
+	m_aClients[3].m_Visible = false;
+	Mapper.Update(m_aClients);
+	ExpectValid();
+	for(int i = 0; i < VANILLA_MAX_CLIENTS - 1; i++)
+		EXPECT_EQ(std::count(m_aaMaps[i], m_aaMaps[i] + VANILLA_MAX_CLIENTS, 3), i == 3 ? 1 : 0);
+}
+
+TEST_F(PlayerMapper, NearestPlayers)
+{
+	CPlayerMapper Mapper;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+		m_aClients[i].m_Pos = vec2(Random(20000), Random(20000));
+	Mapper.Update(m_aClients);
+
+	// a group of players gathers around client 0
+	for(int i = 1; i < 8; i++)
+		m_aClients[MAX_CLIENTS - i].m_Pos = m_aClients[0].m_Pos + vec2(i * 50.0f, 0);
+	for(int Update = 0; Update < 4; Update++)
+	{
+		Mapper.Update(m_aClients);
+		ExpectValid();
+	}
+	for(int i = 1; i < 8; i++)
+		EXPECT_NE(std::find(m_aaMaps[0], m_aaMaps[0] + VANILLA_MAX_CLIENTS, MAX_CLIENTS - i), m_aaMaps[0] + VANILLA_MAX_CLIENTS);
+
+	// a map reset by the player is filled again
+	for(int &Id : m_aaMaps[5])
+		Id = -1;
+	m_aaMaps[5][0] = 5;
+	Mapper.Update(m_aClients);
+	ExpectValid();
+	EXPECT_EQ(std::count(m_aaMaps[5], m_aaMaps[5] + VANILLA_MAX_CLIENTS, -1), 1);
+}
+
+// prints a timing, run with --gtest_also_run_disabled_tests
+TEST_F(PlayerMapper, DISABLED_Benchmark)
+{
+	enum
+	{
+		NUM_UPDATES = 2000,
+	};
+
+	// players walking around in a few groups
+	vec2 aVel[MAX_CLIENTS];
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		m_aClients[i].m_Pos = vec2(i % 4 * 3000.0f + Random(2000), Random(2000));
+		aVel[i] = vec2(Random(20) - 10, Random(20) - 10);
+	}
+	CPlayerMapper::CClient aStart[MAX_CLIENTS];
+	mem_copy(aStart, m_aClients, sizeof(aStart));
+
+	int aaOld[MAX_CLIENTS][VANILLA_MAX_CLIENTS];
+	CPlayerMapper Mapper;
+	int Changes = 0;
+	int64_t Start = time_get();
+	for(int Update = 0; Update < NUM_UPDATES; Update++)
+	{
+		for(int i = 0; i < MAX_CLIENTS; i++)
+			m_aClients[i].m_Pos += aVel[i];
+		mem_copy(aaOld, m_aaMaps, sizeof(aaOld));
+		Mapper.Update(m_aClients);
+		Changes += NumChanges(aaOld);
+	}
+	int64_t IncrementalTime = time_get() - Start;
+	ExpectValid();
+
+	SetUp();
+	mem_copy(m_aClients, aStart, sizeof(aStart));
+	for(int i = 0; i < MAX_CLIENTS; i++)
+		m_aClients[i].m_pIdMap = m_aaMaps[i];
+	int FullChanges = 0;
+	Start = time_get();
+	for(int Update = 0; Update < NUM_UPDATES; Update++)
+	{
+		for(int i = 0; i < MAX_CLIENTS; i++)
+			m_aClients[i].m_Pos += aVel[i];
+		mem_copy(aaOld, m_aaMaps, sizeof(aaOld));
+		UpdateFull(m_aClients);
+		FullChanges += NumChanges(aaOld);
+	}
+	int64_t FullTime = time_get() - Start;
+
+	EXPECT_LT(Mapper.NumRanked(), (int)NUM_UPDATES * MAX_CLIENTS);
+	printf("%d updates with %d clients: incremental %.3f ms, %d ranked, %d remaps; full %.3f ms, %d remaps\n",
+		(int)NUM_UPDATES, (int)MAX_CLIENTS,
+		IncrementalTime * 1000.0 / time_freq(), Mapper.NumRanked(), Changes,
+		FullTime * 1000.0 / time_freq(), FullChanges);
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
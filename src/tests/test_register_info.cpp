@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/server/register_info.h>
+#include <engine/shared/json.h>
+
+static const char s_aServerFields[] = "{\"name\":\"test\",\"clients\":[";
+
+// how the info was built before the fragments were cached
+static void BuildFull(char *pInfo, int InfoSize, const CRegisterServerInfo::CClientInfo *pClients, int NumClients)
+{
+	str_copy(pInfo, s_aServerFields, InfoSize);
+	for(int i = 0; i < NumClients; i++)
+	{
+		char aCName[32];
+		char aCClan[32];
+		char aClientInfo[1024];
+		str_format(aClientInfo, sizeof(aClientInfo),
+			"%s{"
+			"\"name\":\"%s\","
+			"\"clan\":\"%s\","
+			"\"country\":%d,"
+			"\"score\":%d,"
+			"\"is_player\":%s"
+			"%s"
+			"}",
+			i > 0 ? "," : "",
+			EscapeJson(aCName, sizeof(aCName), pClients[i].m_pName),
+			EscapeJson(aCClan, sizeof(aCClan), pClients[i].m_pClan),
+			pClients[i].m_Country,
+			pClients[i].m_Score,
+			JsonBool(pClients[i].m_IsPlayer),
+			pClients[i].m_pExtra);
+		str_append(pInfo, aClientInfo, InfoSize);
+	}
+	str_append(pInfo, "]}", InfoSize);
+}
+
+class RegisterInfo : public ::testing::Test
+{
+protected:
+	char m_aaNames[MAX_CLIENTS][MAX_NAME_LENGTH];
+	char m_aaExtras[MAX_CLIENTS][128];
+	CRegisterServerInfo::CClientInfo m_aClients[MAX_CLIENTS];
+
+	void SetUp() override
+	{
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			str_format(m_aaNames[i], sizeof(m_aaNames[i]), "\"tee\" %d", i);
+			str_format(m_aaExtras[i], sizeof(m_aaExtras[i]), ",\"skin\":{\"name\":\"default\"},\"afk\":false,\"team\":%d", i % 2);
+			m_aClients[i].m_pName = m_aaNames[i];
+			m_aClients[i].m_pClan = i % 3 ? "clan\\" : "";
+			m_aClients[i].m_Country = i;
+			m_aClients[i].m_Score = i * 10;
+			m_aClients[i].m_IsPlayer = i % 5 != 0;
+			m_aClients[i].m_pExtra = m_aaExtras[i];
+		}
+	}
+
+	const char *Build(CRegisterServerInfo *pInfo, int NumClients)
+	{
+		pInfo->Start(s_aServerFields);
+		for(int i = 0; i < NumClients; i++)
+			pInfo->AddClient(i, m_aClients[i]);
+		return pInfo->Finish();
+	}
+};
+
+TEST_F(RegisterInfo, MatchesFullBuild)
+{
+	CRegisterServerInfo Info;
+	char aExpected[16384];
+	BuildFull(aExpected, sizeof(aExpected), m_aClients, 0);
+	EXPECT_STREQ(Build(&Info, 0), aExpected);
+
+	BuildFull(aExpected, sizeof(aExpected), m_aClients, MAX_CLIENTS);
+	EXPECT_STREQ(Build(&Info, MAX_CLIENTS), aExpected);
+	EXPECT_EQ(Info.NumRebuilt(), MAX_CLIENTS);
+
+	// only the changed clients are formatted again
+	m_aClients[3].m_Score += 5;
+	m_aClients[7].m_pClan = "other";
+	str_copy(m_aaExtras[9], ",\"afk\":true");
+	BuildFull(aExpected, sizeof(aExpected), m_aClients, MAX_CLIENTS);
+	EXPECT_STREQ(Build(&Info, MAX_CLIENTS), aExpected);
+	EXPECT_EQ(Info.NumRebuilt(), MAX_CLIENTS + 3);
+
+	BuildFull(aExpected, sizeof(aExpected), m_aClients, 10);
+	EXPECT_STREQ(Build(&Info, 10), aExpected);
+	EXPECT_EQ(Info.NumRebuilt(), MAX_CLIENTS + 3);
+}
+
+// prints a timing, run with --gtest_also_run_disabled_tests
+TEST_F(RegisterInfo, DISABLED_Benchmark)
+{
+	enum
+	{
+		NUM_UPDATES = 5000,
+	};
+
+	CRegisterServerInfo Info;
+	unsigned Seed = 1;
+	int64_t Start = time_get();
+	size_t Length = 0;
+	for(int i = 0; i < NUM_UPDATES; i++)
+	{
+		// a few players score between two updates
+		for(int j = 0; j < 2; j++)
+		{
+			Seed = Seed * 1103515245 + 12345;
+			m_aClients[(Seed >> 16) % MAX_CLIENTS].m_Score++;
+		}
+		Length += str_length(Build(&Info, MAX_CLIENTS));
+	}
+	int64_t CachedTime = time_get() - Start;
+
+	char aInfo[16384];
+	Start = time_get();
+	size_t FullLength = 0;
+	for(int i = 0; i < NUM_UPDATES; i++)
+	{
+		for(int j = 0; j < 2; j++)
+		{
+			Seed = Seed * 1103515245 + 12345;
+			m_aClients[(Seed >> 16) % MAX_CLIENTS].m_Score--;
+		}
+		BuildFull(aInfo, sizeof(aInfo), m_aClients, MAX_CLIENTS);
+		FullLength += str_length(aInfo);
+	}
+	int64_t FullTime = time_get() - Start;
+
+	EXPECT_GT(Length, 0u);
+	EXPECT_GT(FullLength, 0u);
+	printf("%d updates with %d clients: cached %.3f ms, full %.3f ms\n", (int)NUM_UPDATES, (int)MAX_CLIENTS,
+		CachedTime * 1000.0 / time_freq(), FullTime * 1000.0 / time_freq());
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}
@@ -0,0 +1,301 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/server/databases/connection.h>
+#include <engine/server/databases/connection_pool.h>
+#include <engine/server/roundstatistics_worker.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+static const char s_aDatabaseFile[] = "test_roundstatistics_worker.sqlite";
+
+class RoundStatsWorker : public ::testing::Test
+{
+protected:
+	std::unique_ptr<IDbConnection> m_pConn;
+	char m_aError[256] = "unknown error";
+
+	void SetUp() override
+	{
+		RemoveDatabase();
+		m_pConn = CreateSqliteConnection(s_aDatabaseFile, true);
+		ASSERT_FALSE(m_pConn->Connect(m_aError, sizeof(m_aError))) << m_aError;
+	}
+
+	void TearDown() override
+	{
+		m_pConn->Disconnect();
+		m_pConn = nullptr;
+		RemoveDatabase();
+	}
+
+	static void RemoveDatabase()
+	{
+		fs_remove(s_aDatabaseFile);
+		fs_remove("test_roundstatistics_worker.sqlite-wal");
+		fs_remove("test_roundstatistics_worker.sqlite-shm");
+	}
+
+	static std::unique_ptr<CSqlRoundStatsData> RoundData(const char *pRoundId, int NumPlayers)
+	{
+		auto pData = std::make_unique<CSqlRoundStatsData>(nullptr);
+		str_copy(pData->m_aRoundId, pRoundId);
+		str_copy(pData->m_aMap, "infc_skull");
+		str_copy(pData->m_aTimestamp, "2024-01-01 12:00:00");
+		pData->m_Duration = 300;
+		pData->m_NumPlayersMin = NumPlayers;
+		pData->m_NumPlayersMax = NumPlayers;
+		for(int i = 0; i < NumPlayers; i++)
+		{
+			CRoundStatistics::CPlayerStats Stats;
+			Stats.m_Score = 10 + i;
+			Stats.m_EngineerScore = i % 2 ? 5 : 0;
+			Stats.m_SmokerScore = 5;
+			Stats.m_Won = i % 3 == 0;
+			char aName[MAX_NAME_LENGTH];
+			str_format(aName, sizeof(aName), "player %d", i);
+			pData->AddPlayer(aName, &Stats);
+		}
+		return pData;
+	}
+
+	int Count(const char *pTable)
+	{
+		char aBuf[128];
+		str_format(aBuf, sizeof(aBuf), "SELECT COUNT(*) FROM %s_%s", m_pConn->GetPrefix(), pTable);
+		EXPECT_FALSE(m_pConn->PrepareStatement(aBuf, m_aError, sizeof(m_aError))) << m_aError;
+		bool End;
+		EXPECT_FALSE(m_pConn->Step(&End, m_aError, sizeof(m_aError))) << m_aError;
+		EXPECT_FALSE(End);
+		return m_pConn->GetInt(1);
+	}
+};
+
+TEST_F(RoundStatsWorker, Normal)
+{
+	auto pData = RoundData("round-1", 10);
+	EXPECT_EQ(pData->m_NumScores, 10 + 5 + 10);
+	ASSERT_FALSE(CRoundStatsWorker::SaveRoundStats(m_pConn.get(), pData.get(), Write::NORMAL, m_aError, sizeof(m_aError))) << m_aError;
+	EXPECT_EQ(Count("infc_rounds"), 1);
+	EXPECT_EQ(Count("infc_round_scores"), pData->m_NumScores);
+	EXPECT_EQ(Count("infc_round_scores_backup"), 0);
+
+	ASSERT_FALSE(m_pConn->PrepareStatement("SELECT Score, Won FROM record_infc_round_scores WHERE Name = 'player 3' AND ScoreType = 0", m_aError, sizeof(m_aError)));
+	bool End;
+	ASSERT_FALSE(m_pConn->Step(&End, m_aError, sizeof(m_aError)));
+	ASSERT_FALSE(End);
+	EXPECT_EQ(m_pConn->GetInt(1), 13);
+	EXPECT_EQ(m_pConn->GetInt(2), 1);
+}
+
+TEST_F(RoundStatsWorker, SplitsLargeRounds)
+{
+	auto pData = RoundData("round-1", MAX_CLIENTS);
+	EXPECT_GT(pData->m_NumScores, 150);
+	ASSERT_FALSE(CRoundStatsWorker::SaveRoundStats(m_pConn.get(), pData.get(), Write::NORMAL, m_aError, sizeof(m_aError))) << m_aError;
+	EXPECT_EQ(Count("infc_round_scores"), pData->m_NumScores);
+}
+
+TEST_F(RoundStatsWorker, FailedWriteRollsBack)
+{
+	auto pData = RoundData("round-1", 10);
+	ASSERT_FALSE(CRoundStatsWorker::SaveRoundStats(m_pConn.get(), pData.get(), Write::NORMAL, m_aError, sizeof(m_aError))) << m_aError;
+	// the round id is already taken, the scores must not be written either
+	auto pDuplicate = RoundData("round-1", 20);
+	EXPECT_TRUE(CRoundStatsWorker::SaveRoundStats(m_pConn.get(), pDuplicate.get(), Write::NORMAL, m_aError, sizeof(m_aError)));
+	EXPECT_EQ(Count("infc_rounds"), 1);
+	EXPECT_EQ(Count("infc_round_scores"), pData->m_NumScores);
+}
+
+TEST_F(RoundStatsWorker, BackupSucceeded)
+{
+	auto pData = RoundData("round-1", 10);
+	ASSERT_FALSE(CRoundStatsWorker::SaveRoundStats(m_pConn.get(), pData.get(), Write::BACKUP_FIRST, m_aError, sizeof(m_aError))) << m_aError;
+	EXPECT_EQ(Count("infc_rounds_backup"), 1);
+	EXPECT_EQ(Count("infc_round_scores_backup"), pData->m_NumScores);
+	ASSERT_FALSE(CRoundStatsWorker::SaveRoundStats(m_pConn.get(), pData.get(), Write::NORMAL_SUCCEEDED, m_aError, sizeof(m_aError))) << m_aError;
+	EXPECT_EQ(Count("infc_rounds_backup"), 0);
+	EXPECT_EQ(Count("infc_round_scores_backup"), 0);
+	EXPECT_EQ(Count("infc_rounds"), 0);
+}
+
+TEST_F(RoundStatsWorker, BackupFailed)
+{
+	auto pData = RoundData("round-1", 10);
+	ASSERT_FALSE(CRoundStatsWorker::SaveRoundStats(m_pConn.get(), pData.get(), Write::BACKUP_FIRST, m_aError, sizeof(m_aError))) << m_aError;
+	ASSERT_FALSE(CRoundStatsWorker::SaveRoundStats(m_pConn.get(), pData.get(), Write::NORMAL_FAILED, m_aError, sizeof(m_aError))) << m_aError;
+	EXPECT_EQ(Count("infc_rounds_backup"), 0);
+	EXPECT_EQ(Count("infc_round_scores_backup"), 0);
+	EXPECT_EQ(Count("infc_rounds"), 1);
+	EXPECT_EQ(Count("infc_round_scores"), pData->m_NumScores);
+}
+
+TEST_F(RoundStatsWorker, PoolFallsBackToSqlite)
+{
+	// no MySQL server registered: the write ends up in the backup file
+	CDbConnectionPool Pool;
+	Pool.RegisterSqliteDatabase(CDbConnectionPool::WRITE_BACKUP, s_aDatabaseFile);
+
+	auto pResult = std::make_shared<ISqlResult>();
+	auto pData = RoundData("round-1", 10);
+	pData->m_pResult = pResult;
+	const int NumScores = pData->m_NumScores;
+	Pool.ExecuteWrite(CRoundStatsWorker::SaveRoundStats, std::move(pData), "save round statistics");
+	for(int i = 0; i < 500 && !pResult->m_Completed.load(); i++)
+		std::this_thread::sleep_for(10ms);
+	ASSERT_TRUE(pResult->m_Completed.load());
+	EXPECT_TRUE(pResult->m_Success);
+	Pool.OnShutdown();
+
+	EXPECT_EQ(Count("infc_rounds"), 1);
+	EXPECT_EQ(Count("infc_round_scores"), NumScores);
+	EXPECT_EQ(Count("infc_round_scores_backup"), 0);
+}
+
+// a write that waits until it is released, and records the order of the writes
+struct CSqlOrderedWrite : ISqlData
+{
+	int m_Index;
+	CSqlOrderedWrite(int Index) :
+		ISqlData(nullptr), m_Index(Index) {}
+};
+static std::atomic_bool s_ReleaseWrites{false};
+static std::vector<int> s_vWriteOrder;
+static std::atomic_int s_NumWritten{0};
+
+static bool OrderedWrite(IDbConnection *pConnection, const ISqlData *pData, Write w, char *pError, int ErrorSize)
+{
+	while(!s_ReleaseWrites)
+		std::this_thread::sleep_for(1ms);
+	if(w == Write::NORMAL)
+	{
+		s_vWriteOrder.push_back(((const CSqlOrderedWrite *)pData)->m_Index);
+		s_NumWritten++;
+	}
+	return false;
+}
+
+TEST_F(RoundStatsWorker, PoolWriteOverflowDoesNotBlock)
+{
+	const int NumWrites = 1500;
+	CDbConnectionPool Pool;
+	Pool.RegisterSqliteDatabase(CDbConnectionPool::WRITE, s_aDatabaseFile);
+
+	// the worker is stuck on the first write, more writes than the queue holds
+	// still return right away
+	s_ReleaseWrites = false;
+	s_vWriteOrder.clear();
+	s_NumWritten = 0;
+	for(int i = 0; i < NumWrites; i++)
+		Pool.ExecuteWrite(OrderedWrite, std::make_unique<CSqlOrderedWrite>(i), "ordered write");
+	s_ReleaseWrites = true;
+
+	// the main loop moves the overflowed writes into the queue
+	for(int i = 0; i < 1000 && s_NumWritten < NumWrites; i++)
+	{
+		Pool.Update();
+		std::this_thread::sleep_for(10ms);
+	}
+	Pool.OnShutdown();
+
+	ASSERT_EQ((int)s_vWriteOrder.size(), NumWrites);
+	for(int i = 0; i < NumWrites; i++)
+		ASSERT_EQ(s_vWriteOrder[i], i);
+}
+
+TEST_F(RoundStatsWorker, LoadLeaderboard)
+{
+	ASSERT_FALSE(CRoundStatsWorker::SaveRoundStats(m_pConn.get(), RoundData("round-1", 10).get(), Write::NORMAL, m_aError, sizeof(m_aError))) << m_aError;
+	ASSERT_FALSE(CRoundStatsWorker::SaveRoundStats(m_pConn.get(), RoundData("round-2", 5).get(), Write::NORMAL, m_aError, sizeof(m_aError))) << m_aError;
+
+	auto pResult = std::make_shared<CLeaderboardResult>();
+	CSqlLeaderboardRequest Request(pResult);
+	str_copy(Request.m_aMap, "infc_skull");
+	ASSERT_FALSE(CRoundStatsWorker::LoadLeaderboard(m_pConn.get(), &Request, m_aError, sizeof(m_aError))) << m_aError;
+	EXPECT_EQ(pResult->m_RoundIds.size(), 2u);
+
+	const CLeaderboard &Leaderboard = pResult->m_Leaderboard;
+	EXPECT_EQ(Leaderboard.NumPlayers(ROUNDSCORE_TYPE_ROUND), 10);
+	const CLeaderboard::CEntry *pEntry;
+	// player 4 has 14 + 14 points, player 9 only 19
+	EXPECT_EQ(Leaderboard.Rank(ROUNDSCORE_TYPE_ROUND, "player 4", &pEntry), 1);
+	EXPECT_EQ(pEntry->m_Score, 28);
+	EXPECT_EQ(pEntry->m_NumRounds, 2);
+	EXPECT_EQ(Leaderboard.Rank(ROUNDSCORE_TYPE_SMOKER, "player 9", &pEntry), 10);
+	EXPECT_EQ(pEntry->m_Score, 5);
+
+	str_copy(Request.m_aMap, "infc_other");
+	ASSERT_FALSE(CRoundStatsWorker::LoadLeaderboard(m_pConn.get(), &Request, m_aError, sizeof(m_aError))) << m_aError;
+	EXPECT_EQ(pResult->m_Leaderboard.NumPlayers(ROUNDSCORE_TYPE_ROUND), 0);
+}
+
+TEST_F(RoundStatsWorker, StatementCache)
+{
+	ASSERT_FALSE(CRoundStatsWorker::SaveRoundStats(m_pConn.get(), RoundData("round-1", 10).get(), Write::NORMAL, m_aError, sizeof(m_aError))) << m_aError;
+	const CDbStatementCacheStats &Stats = m_pConn->StatementCacheStats();
+	const int64_t Misses = Stats.m_Misses.load();
+
+	// the same statement with new bindings
+	const char *pQuery = "SELECT Score FROM record_infc_round_scores WHERE Name = ? AND ScoreType = 0";
+	for(int i = 0; i < 10; i++)
+	{
+		char aName[MAX_NAME_LENGTH];
+		str_format(aName, sizeof(aName), "player %d", i);
+		ASSERT_FALSE(m_pConn->PrepareStatement(pQuery, m_aError, sizeof(m_aError))) << m_aError;
+		m_pConn->BindString(1, aName);
+		bool End;
+		ASSERT_FALSE(m_pConn->Step(&End, m_aError, sizeof(m_aError))) << m_aError;
+		ASSERT_FALSE(End);
+		EXPECT_EQ(m_pConn->GetInt(1), 10 + i);
+	}
+	EXPECT_EQ(Stats.m_Misses.load(), Misses + 1);
+	EXPECT_GE(Stats.m_Hits.load(), 9);
+
+	// a statement left in the middle of its rows doesn't block the commit
+	ASSERT_FALSE(m_pConn->BeginTransaction(m_aError, sizeof(m_aError))) << m_aError;
+	ASSERT_FALSE(m_pConn->PrepareStatement("SELECT Name FROM record_infc_round_scores", m_aError, sizeof(m_aError))) << m_aError;
+	bool End;
+	ASSERT_FALSE(m_pConn->Step(&End, m_aError, sizeof(m_aError))) << m_aError;
+	ASSERT_FALSE(m_pConn->PrepareStatement("DELETE FROM record_infc_round_scores WHERE ScoreType = 200", m_aError, sizeof(m_aError))) << m_aError;
+	int NumDeleted;
+	ASSERT_FALSE(m_pConn->ExecuteUpdate(&NumDeleted, m_aError, sizeof(m_aError))) << m_aError;
+	EXPECT_EQ(NumDeleted, 10);
+	ASSERT_FALSE(m_pConn->CommitTransaction(m_aError, sizeof(m_aError))) << m_aError;
+}
+
+TEST_F(RoundStatsWorker, StatementCacheEviction)
+{
+	const CDbStatementCacheStats &Stats = m_pConn->StatementCacheStats();
+	for(int i = 0; i < IDbConnection::STATEMENT_CACHE_SIZE + 8; i++)
+	{
+		char aQuery[64];
+		str_format(aQuery, sizeof(aQuery), "SELECT %d", i);
+		ASSERT_FALSE(m_pConn->PrepareStatement(aQuery, m_aError, sizeof(m_aError))) << m_aError;
+		bool End;
+		ASSERT_FALSE(m_pConn->Step(&End, m_aError, sizeof(m_aError))) << m_aError;
+		EXPECT_EQ(m_pConn->GetInt(1), i);
+	}
+	EXPECT_EQ(Stats.m_Evictions.load(), 8);
+	// the oldest statement was evicted, the newest is still prepared
+	int64_t Misses = Stats.m_Misses.load();
+	ASSERT_FALSE(m_pConn->PrepareStatement("SELECT 0", m_aError, sizeof(m_aError))) << m_aError;
+	EXPECT_EQ(Stats.m_Misses.load(), Misses + 1);
+	char aQuery[64];
+	str_format(aQuery, sizeof(aQuery), "SELECT %d", IDbConnection::STATEMENT_CACHE_SIZE + 7);
+	ASSERT_FALSE(m_pConn->PrepareStatement(aQuery, m_aError, sizeof(m_aError))) << m_aError;
+	EXPECT_EQ(Stats.m_Misses.load(), Misses + 1);
+}
+
+int main(int argc, char *argv[])
+{
+	::testing::InitGoogleTest(&argc, const_cast<char **>(argv));
+
+	int Result = RUN_ALL_TESTS();
+
+	return Result;
+}